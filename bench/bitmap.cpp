@@ -2,6 +2,7 @@
 #include <benchmark/benchmark.h>
 #include <rect.h>
 #include <bitmap.h>
+#include <bitmap_tone.h>
 #include <pixel_format.h>
 #include <transform.h>
 
@@ -251,6 +252,17 @@ static void BM_ClearRect(benchmark::State& state) {
 
 BENCHMARK(BM_ClearRect);
 
+static void BM_FlashFill(benchmark::State& state) {
+	Bitmap::SetFormat(format);
+	auto dest = Bitmap::Create(320, 240);
+	auto keep = Rect(0, 16, 320, 208);
+	for (auto _: state) {
+		dest->FlashFill(Color(255, 255, 255, 128), keep);
+	}
+}
+
+BENCHMARK(BM_FlashFill);
+
 static void BM_HueChangeBlit(benchmark::State& state) {
 	Bitmap::SetFormat(format);
 	auto dest = Bitmap::Create(320, 240);
@@ -264,18 +276,78 @@ static void BM_HueChangeBlit(benchmark::State& state) {
 
 BENCHMARK(BM_HueChangeBlit);
 
-static void BM_ToneBlit(benchmark::State& state) {
+static BitmapRef MakeToneSource(ImageOpacity op) {
+	auto src = Bitmap::Create(320, 240);
+	switch (op) {
+		case ImageOpacity::Opaque:
+			src->Fill(Color(255, 128, 64, 255));
+			break;
+		case ImageOpacity::Alpha_1Bit:
+			src->Clear();
+			src->FillRect(Rect{ 0, 0, 160, 240 }, Color(255, 128, 64, 255));
+			break;
+		default:
+			src->Fill(Color(255, 128, 64, 128));
+			break;
+	}
+	src->CheckPixels(Bitmap::Flag_ReadOnly);
+	return src;
+}
+
+static void BM_ToneBlitImpl(benchmark::State& state, ImageOpacity op, Tone tone) {
 	Bitmap::SetFormat(format);
+	auto kernel = static_cast<BitmapTone::Kernel>(state.range(0));
+	if (!BitmapTone::SetKernel(kernel)) {
+		state.SkipWithError("Kernel not supported");
+		return;
+	}
+	state.SetLabel(BitmapTone::GetKernelName(kernel));
+
 	auto dest = Bitmap::Create(320, 240);
-	auto src = Bitmap::Create(320, 240);
+	auto src = MakeToneSource(op);
 	auto rect = src->GetRect();
-	auto tone = Tone(255,255,255,128);
 	for (auto _: state) {
 		dest->ToneBlit(0, 0, *src, rect, tone, opacity);
 	}
+
+	BitmapTone::SetKernel(BitmapTone::GetBestKernel());
+}
+
+static void ToneBlitKernels(benchmark::internal::Benchmark* b) {
+	for (auto kernel: { BitmapTone::Kernel::Scalar, BitmapTone::Kernel::SSE2, BitmapTone::Kernel::AVX2, BitmapTone::Kernel::NEON }) {
+		b->Arg(static_cast<int>(kernel));
+	}
+}
+
+static void BM_ToneBlit(benchmark::State& state) {
+	BM_ToneBlitImpl(state, ImageOpacity::Opaque, Tone(255,255,255,128));
+}
+
+BENCHMARK(BM_ToneBlit)->Apply(ToneBlitKernels);
+
+static void BM_ToneBlitSaturation(benchmark::State& state) {
+	BM_ToneBlitImpl(state, ImageOpacity::Opaque, Tone(128,128,128,0));
+}
+
+BENCHMARK(BM_ToneBlitSaturation)->Apply(ToneBlitKernels);
+
+static void BM_ToneBlitOpaque(benchmark::State& state) {
+	BM_ToneBlitImpl(state, ImageOpacity::Opaque, Tone(200,100,50,64));
+}
+
+BENCHMARK(BM_ToneBlitOpaque)->Apply(ToneBlitKernels);
+
+static void BM_ToneBlit1Bit(benchmark::State& state) {
+	BM_ToneBlitImpl(state, ImageOpacity::Alpha_1Bit, Tone(200,100,50,64));
+}
+
+BENCHMARK(BM_ToneBlit1Bit)->Apply(ToneBlitKernels);
+
+static void BM_ToneBlit8Bit(benchmark::State& state) {
+	BM_ToneBlitImpl(state, ImageOpacity::Alpha_8Bit, Tone(200,100,50,64));
 }
 
-BENCHMARK(BM_ToneBlit);
+BENCHMARK(BM_ToneBlit8Bit)->Apply(ToneBlitKernels);
 
 static void BM_BlendBlit(benchmark::State& state) {
 	Bitmap::SetFormat(format);
@@ -2,6 +2,7 @@
 #include <font.h>
 #include <rect.h>
 #include <bitmap.h>
+#include <pixel_format.h>
 #include <sprite.h>
 #include <graphics.h>
 #include <drawable_list.h>
@@ -12,7 +13,7 @@ constexpr int num_sprites = 5000;
 
 class TestSprite : public Drawable {
 	public:
-		TestSprite() : Drawable(0) { DrawableMgr::Register(this); }
+		TestSprite(Drawable::Z_t z = 0) : Drawable(z) { DrawableMgr::Register(this); }
 		void Draw(Bitmap&) override {}
 };
 
@@ -45,4 +46,220 @@ static void BM_DrawSortLocality(benchmark::State& state) {
 
 BENCHMARK(BM_DrawSortLocality);
 
+// Pictures and event sprites being created, destroyed and moving around
+static void BM_DrawChurn(benchmark::State& state) {
+	DrawableList list;
+	DrawableMgr::SetLocalList(&list);
+	list.Sort();
+
+	std::vector<std::unique_ptr<TestSprite>> sprites;
+	for (int i = 0; i < num_sprites; ++i) {
+		sprites.push_back(std::make_unique<TestSprite>(Priority_EventsBelow + i % 320));
+	}
+
+	int i = 0;
+	for (auto _: state) {
+		auto& sprite = sprites[(i * 7919) % num_sprites];
+		sprite->SetZ(Priority_EventsBelow + (i * 31) % 320);
+		sprites[(i * 104729) % num_sprites] = std::make_unique<TestSprite>(Priority_PictureNew + i % 1000);
+		++i;
+	}
+}
+
+BENCHMARK(BM_DrawChurn);
+
+// Compares the blits without pixman (opaque and 1 bit alpha sources) with pixman
+struct BitmapAccess : public Bitmap {
+	static pixman_image_t* GetImage(const Bitmap& bm) {
+		return (bm.*(&BitmapAccess::bitmap)).get();
+	}
+
+	static void SetImageOpacity(Bitmap& bm, ImageOpacity opacity) {
+		bm.*(&BitmapAccess::image_opacity) = opacity;
+	}
+};
+
+static BitmapRef MakeSource(ImageOpacity opacity) {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto bm = Bitmap::Create(320, 240, Color(80, 160, 240, 255));
+	if (opacity == ImageOpacity::Alpha_1Bit) {
+		// Color key like transparency, every second 8x8 block is transparent
+		for (int y = 0; y < bm->height(); ++y) {
+			auto* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(bm->pixels()) + y * bm->pitch());
+			for (int x = 0; x < bm->width(); ++x) {
+				if ((x / 8 + y / 8) % 2) {
+					row[x] = 0;
+				}
+			}
+		}
+	}
+	BitmapAccess::SetImageOpacity(*bm, opacity);
+	return bm;
+}
+
+static void BlitDirect(benchmark::State& state, ImageOpacity opacity) {
+	auto src = MakeSource(opacity);
+	auto dest = Bitmap::Create(320, 240);
+	const int size = state.range(0);
+	for (auto _: state) {
+		for (int y = 0; y < 240; y += size) {
+			for (int x = 0; x < 320; x += size) {
+				dest->Blit(x, y, *src, Rect(x, y, size, size), Opacity::Opaque());
+			}
+		}
+	}
+}
+
+static void BlitPixman(benchmark::State& state, ImageOpacity opacity) {
+	auto src = MakeSource(opacity);
+	auto dest = Bitmap::Create(320, 240);
+	const auto op = opacity == ImageOpacity::Opaque ? PIXMAN_OP_SRC : PIXMAN_OP_OVER;
+	const int size = state.range(0);
+	for (auto _: state) {
+		for (int y = 0; y < 240; y += size) {
+			for (int x = 0; x < 320; x += size) {
+				pixman_image_composite32(op, BitmapAccess::GetImage(*src), nullptr, BitmapAccess::GetImage(*dest),
+					x, y, 0, 0, x, y, size, size);
+			}
+		}
+	}
+}
+
+static void BM_BlitDirectOpaque(benchmark::State& state) {
+	BlitDirect(state, ImageOpacity::Opaque);
+}
+
+BENCHMARK(BM_BlitDirectOpaque)->Arg(16)->Arg(80)->Arg(320);
+
+static void BM_BlitPixmanOpaque(benchmark::State& state) {
+	BlitPixman(state, ImageOpacity::Opaque);
+}
+
+BENCHMARK(BM_BlitPixmanOpaque)->Arg(16)->Arg(80)->Arg(320);
+
+static void BM_BlitDirect1Bit(benchmark::State& state) {
+	BlitDirect(state, ImageOpacity::Alpha_1Bit);
+}
+
+BENCHMARK(BM_BlitDirect1Bit)->Arg(16)->Arg(80)->Arg(320);
+
+static void BM_BlitPixman1Bit(benchmark::State& state) {
+	BlitPixman(state, ImageOpacity::Alpha_1Bit);
+}
+
+BENCHMARK(BM_BlitPixman1Bit)->Arg(16)->Arg(80)->Arg(320);
+
+static void BM_TiledBlitDirect(benchmark::State& state) {
+	auto src = MakeSource(ImageOpacity::Opaque);
+	auto dest = Bitmap::Create(320, 240);
+	for (auto _: state) {
+		dest->TiledBlit(5, 7, Rect(0, 0, 16, 16), *src, dest->GetRect(), Opacity::Opaque());
+	}
+}
+
+BENCHMARK(BM_TiledBlitDirect);
+
+static void BM_TiledBlitPixman(benchmark::State& state) {
+	auto src = MakeSource(ImageOpacity::Opaque);
+	auto dest = Bitmap::Create(320, 240);
+	for (auto _: state) {
+		auto* src_img = BitmapAccess::GetImage(*src);
+		auto tile = pixman_image_create_bits(pixman_image_get_format(src_img), 16, 16,
+			pixman_image_get_data(src_img), pixman_image_get_stride(src_img));
+		pixman_image_set_repeat(tile, PIXMAN_REPEAT_NORMAL);
+		pixman_image_composite32(PIXMAN_OP_SRC, tile, nullptr, BitmapAccess::GetImage(*dest),
+			5, 7, 0, 0, 0, 0, 320, 240);
+		pixman_image_unref(tile);
+	}
+}
+
+BENCHMARK(BM_TiledBlitPixman);
+
+// Compares the rotated and zoomed blits without pixman with pixman
+static void AffineBlit(benchmark::State& state, bool pixman, ImageOpacity src_opacity, Opacity opacity, double angle, double zoom) {
+	auto src = MakeSource(src_opacity);
+	auto dest = Bitmap::Create(320, 240);
+	Bitmap::SetPixmanAffineBlit(pixman);
+	for (auto _: state) {
+		if (angle != 0.0) {
+			dest->RotateZoomOpacityBlit(160, 120, 160, 120, *src, src->GetRect(), angle, zoom, zoom, opacity);
+		} else {
+			dest->ZoomOpacityBlit(160, 120, 160, 120, *src, src->GetRect(), zoom, zoom, opacity);
+		}
+	}
+	Bitmap::SetPixmanAffineBlit(false);
+}
+
+static void BM_RotateBlitDirect(benchmark::State& state) {
+	AffineBlit(state, false, ImageOpacity::Alpha_1Bit, Opacity::Opaque(), 0.5, 0.8);
+}
+
+BENCHMARK(BM_RotateBlitDirect);
+
+static void BM_RotateBlitPixman(benchmark::State& state) {
+	AffineBlit(state, true, ImageOpacity::Alpha_1Bit, Opacity::Opaque(), 0.5, 0.8);
+}
+
+BENCHMARK(BM_RotateBlitPixman);
+
+static void BM_RotateBlitBushDirect(benchmark::State& state) {
+	AffineBlit(state, false, ImageOpacity::Opaque, Opacity(255, 128, 40), 2.0, 1.0);
+}
+
+BENCHMARK(BM_RotateBlitBushDirect);
+
+static void BM_RotateBlitBushPixman(benchmark::State& state) {
+	AffineBlit(state, true, ImageOpacity::Opaque, Opacity(255, 128, 40), 2.0, 1.0);
+}
+
+BENCHMARK(BM_RotateBlitBushPixman);
+
+static void BM_ZoomBlitDirect(benchmark::State& state) {
+	AffineBlit(state, false, ImageOpacity::Alpha_1Bit, Opacity(160), 0.0, 1.5);
+}
+
+BENCHMARK(BM_ZoomBlitDirect);
+
+static void BM_ZoomBlitPixman(benchmark::State& state) {
+	AffineBlit(state, true, ImageOpacity::Alpha_1Bit, Opacity(160), 0.0, 1.5);
+}
+
+BENCHMARK(BM_ZoomBlitPixman);
+
+static void WaverBlit(benchmark::State& state, bool pixman, double zoom) {
+	auto src = MakeSource(ImageOpacity::Opaque);
+	auto dest = Bitmap::Create(320, 240);
+	Bitmap::SetPixmanAffineBlit(pixman);
+	double phase = 0.0;
+	for (auto _: state) {
+		dest->WaverBlit(0, 0, zoom, zoom, *src, src->GetRect(), 4, phase, Opacity::Opaque());
+		phase += 0.1;
+	}
+	Bitmap::SetPixmanAffineBlit(false);
+}
+
+static void BM_WaverBlitDirect(benchmark::State& state) {
+	WaverBlit(state, false, 1.0);
+}
+
+BENCHMARK(BM_WaverBlitDirect);
+
+static void BM_WaverBlitPixman(benchmark::State& state) {
+	WaverBlit(state, true, 1.0);
+}
+
+BENCHMARK(BM_WaverBlitPixman);
+
+static void BM_WaverBlitZoomDirect(benchmark::State& state) {
+	WaverBlit(state, false, 1.5);
+}
+
+BENCHMARK(BM_WaverBlitZoomDirect);
+
+static void BM_WaverBlitZoomPixman(benchmark::State& state) {
+	WaverBlit(state, true, 1.5);
+}
+
+BENCHMARK(BM_WaverBlitZoomPixman);
+
 BENCHMARK_MAIN();
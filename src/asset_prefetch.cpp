@@ -0,0 +1,220 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Headers
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include "asset_prefetch.h"
+#include "async_handler.h"
+#include "game_actor.h"
+#include "game_enemy.h"
+#include "game_enemyparty.h"
+#include "game_interpreter_shared.h"
+#include "game_party.h"
+#include "game_system.h"
+#include "main_data.h"
+#include "output.h"
+#include "player.h"
+#include <lcf/data.h>
+#include <lcf/reader_util.h>
+#include <lcf/rpg/eventcommand.h>
+#include <lcf/rpg/map.h>
+#include <lcf/rpg/movecommand.h>
+
+namespace {
+	using Cmd = lcf::rpg::EventCommand::Code;
+
+	class ImageCollector {
+	public:
+		void Add(const char* folder, StringView filename, bool transparent = true) {
+			if (filename.empty()) {
+				return;
+			}
+
+			std::string key = ToString(folder) + ":" + ToString(filename) + (transparent ? ":T" : ": ");
+			if (!seen.insert(std::move(key)).second) {
+				return;
+			}
+
+			images.push_back({ folder, ToString(filename), transparent });
+		}
+
+		void AddMoveCommand(const lcf::rpg::MoveCommand& cmd) {
+			if (cmd.command_id == static_cast<int>(lcf::rpg::MoveCommand::Code::change_graphic)) {
+				Add("CharSet", cmd.parameter_string);
+			}
+		}
+
+		void AddCommands(const std::vector<lcf::rpg::EventCommand>& commands) {
+			for (auto& com: commands) {
+				switch (static_cast<Cmd>(com.code)) {
+					case Cmd::ShowPicture:
+						Add("Picture", com.string, com.parameters.size() > 7 && com.parameters[7] > 0);
+						break;
+					case Cmd::ChangeFaceGraphic:
+					case Cmd::ChangeActorFace:
+						Add("FaceSet", com.string);
+						break;
+					case Cmd::ChangeSpriteAssociation:
+					case Cmd::ChangeVehicleGraphic:
+						Add("CharSet", com.string);
+						break;
+					case Cmd::ChangePBG:
+						Add("Panorama", com.string);
+						break;
+					case Cmd::ShowBattleAnimation:
+						if (!com.parameters.empty()) {
+							auto* animation = lcf::ReaderUtil::GetElement(lcf::Data::animations, com.parameters[0]);
+							if (animation) {
+								Add(animation->large ? "Battle2" : "Battle", animation->animation_name);
+							}
+						}
+						break;
+					case Cmd::MoveEvent:
+						// Same encoding as in Game_Interpreter::CommandMoveEvent
+						for (auto it = com.parameters.begin() + std::min<size_t>(4, com.parameters.size()); it < com.parameters.end(); ) {
+							AddMoveCommand(Game_Interpreter_Shared::DecodeMove(it));
+						}
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		std::vector<Cache::PreloadImage> images;
+
+	private:
+		std::unordered_set<std::string> seen;
+	};
+}
+
+std::vector<Cache::PreloadImage> AssetPrefetch::CollectMapImages(const lcf::rpg::Map& map) {
+	ImageCollector collector;
+
+	if (map.parallax_flag) {
+		collector.Add("Panorama", map.parallax_name);
+	}
+
+	// Graphics that are visible right away or after a page change first
+	for (auto& ev: map.events) {
+		for (auto& page: ev.pages) {
+			collector.Add("CharSet", page.character_name);
+		}
+	}
+
+	for (auto& ev: map.events) {
+		for (auto& page: ev.pages) {
+			for (auto& cmd: page.move_route.move_commands) {
+				collector.AddMoveCommand(cmd);
+			}
+			collector.AddCommands(page.event_commands);
+		}
+	}
+
+	for (auto& ce: lcf::Data::commonevents) {
+		collector.AddCommands(ce.event_commands);
+	}
+
+	return std::move(collector.images);
+}
+
+std::vector<Cache::PreloadImage> AssetPrefetch::CollectTitleImages(bool title_graphic) {
+	ImageCollector collector;
+
+	if (title_graphic) {
+		collector.Add("Title", lcf::Data::system.title_name);
+	}
+	collector.Add("System", Main_Data::game_system->GetSystemName());
+
+	return std::move(collector.images);
+}
+
+std::vector<Cache::PreloadImage> AssetPrefetch::CollectMenuImages() {
+	ImageCollector collector;
+
+	collector.Add("System", Main_Data::game_system->GetSystemName());
+	for (auto* actor: Main_Data::game_party->GetActors()) {
+		collector.Add("FaceSet", actor->GetFaceName());
+	}
+
+	return std::move(collector.images);
+}
+
+std::vector<Cache::PreloadImage> AssetPrefetch::CollectBattleImages(StringView background_name, int terrain_id) {
+	ImageCollector collector;
+
+	// Same selection as in Background
+	if (!background_name.empty()) {
+		collector.Add("Backdrop", background_name);
+	} else if (auto* terrain = lcf::ReaderUtil::GetElement(lcf::Data::terrains, terrain_id)) {
+		if (terrain->background_type == lcf::rpg::Terrain::BGAssociation_background) {
+			collector.Add("Backdrop", terrain->background_name);
+		} else {
+			collector.Add("Frame", terrain->background_a_name);
+			if (terrain->background_b) {
+				collector.Add("Frame", terrain->background_b_name);
+			}
+		}
+	}
+
+	collector.Add("System", Main_Data::game_system->GetSystemName());
+
+	for (auto* enemy: Main_Data::game_enemyparty->GetEnemies()) {
+		collector.Add("Monster", enemy->GetSpriteName());
+	}
+
+	if (Player::IsRPG2k3()) {
+		collector.Add("System2", Main_Data::game_system->GetSystem2Name());
+
+		// Idle pose of the battlers, as shown by Sprite_Actor
+		for (auto* actor: Main_Data::game_party->GetActors()) {
+			auto* anim = lcf::ReaderUtil::GetElement(lcf::Data::battleranimations, actor->GetBattleAnimationId());
+			auto* pose = anim ? lcf::ReaderUtil::GetElement(anim->poses, 1) : nullptr;
+			if (pose && pose->animation_type != lcf::rpg::BattlerAnimationPose::AnimType_battle) {
+				collector.Add("BattleCharSet", pose->battler_name);
+			}
+		}
+	}
+
+	return std::move(collector.images);
+}
+
+void AssetPrefetch::PrefetchScene(const std::vector<Cache::PreloadImage>& images) {
+	const size_t budget = static_cast<size_t>(Player::player_config.prefetch_size.Get()) * 1024 * 1024;
+	if (budget == 0) {
+		return;
+	}
+
+	int loaded = Cache::Preload(images, budget);
+
+	if (loaded > 0) {
+		Output::Debug("Prefetched {} of {} images", loaded, images.size());
+	}
+}
+
+void AssetPrefetch::PrefetchMap(const lcf::rpg::Map& map, size_t budget) {
+	if (budget == 0) {
+		// Stops the prefetch of the previous map
+		AsyncHandler::Prefetch({}, 0);
+		return;
+	}
+
+	AsyncHandler::Prefetch(CollectMapImages(map), budget);
+}
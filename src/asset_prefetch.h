@@ -0,0 +1,96 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_ASSET_PREFETCH_H
+#define EP_ASSET_PREFETCH_H
+
+// Headers
+#include <cstddef>
+#include <vector>
+#include "cache.h"
+#include "string_view.h"
+
+namespace lcf {
+namespace rpg {
+	class Map;
+}
+}
+
+/**
+ * Loads the images that the events of a map can show into the cache in the
+ * background after the map is set up, so that changing a graphic or showing
+ * a picture later does not block on decoding. Scenes load the images they
+ * show on startup at once, so that they are decoded in parallel.
+ */
+namespace AssetPrefetch {
+	/**
+	 * Collects the images used by the events of a map and by the common
+	 * events: Graphics of the event pages, "Change Graphic" of move routes,
+	 * faces, charsets, pictures, battle animations and panoramas of event
+	 * commands and the panorama of the map.
+	 *
+	 * @param map map to scan
+	 * @return images in order of appearance without duplicates
+	 */
+	std::vector<Cache::PreloadImage> CollectMapImages(const lcf::rpg::Map& map);
+
+	/**
+	 * Collects the images shown by the title scene.
+	 *
+	 * @param title_graphic whether the title graphic is shown
+	 * @return images without duplicates
+	 */
+	std::vector<Cache::PreloadImage> CollectTitleImages(bool title_graphic);
+
+	/**
+	 * Collects the images shown by the menu scene: The system graphic and
+	 * the faces of the party.
+	 *
+	 * @return images without duplicates
+	 */
+	std::vector<Cache::PreloadImage> CollectMenuImages();
+
+	/**
+	 * Collects the images shown when a battle starts: Background, monsters,
+	 * system graphics and the battlers of the party (RPG Maker 2003).
+	 * The enemy party must be set up.
+	 *
+	 * @param background_name background of the battle, empty to use the terrain
+	 * @param terrain_id terrain of the battle
+	 * @return images without duplicates
+	 */
+	std::vector<Cache::PreloadImage> CollectBattleImages(StringView background_name, int terrain_id);
+
+	/**
+	 * Loads the images a scene shows on startup in parallel, at most the
+	 * prefetch size of the config. A prefetch size of 0 disables this.
+	 *
+	 * @param images images to load
+	 */
+	void PrefetchScene(const std::vector<Cache::PreloadImage>& images);
+
+	/**
+	 * Starts loading the images of a map in the background, see
+	 * AsyncHandler::Prefetch. Returns immediately.
+	 *
+	 * @param map map to scan
+	 * @param budget size limit of the loaded images in bytes, 0 disables prefetching
+	 */
+	void PrefetchMap(const lcf::rpg::Map& map, size_t budget);
+}
+
+#endif
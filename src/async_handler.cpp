@@ -15,9 +15,17 @@
  * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <map>
+#if defined(HAVE_THREADS) && !defined(EMSCRIPTEN)
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  define EP_ASYNC_THREADS
+#endif
 
 #ifdef EMSCRIPTEN
 #  include <emscripten.h>
@@ -27,6 +35,7 @@
 #endif
 
 #include "async_handler.h"
+#include "bitmap.h"
 #include "cache.h"
 #include "filefinder.h"
 #include "memory_management.h"
@@ -36,6 +45,7 @@
 #include "utils.h"
 #include "transition.h"
 #include "rand.h"
+#include "thread_pool.h"
 
 // When this option is enabled async requests are randomly delayed.
 // This allows testing some aspects of async file fetching locally.
@@ -69,6 +79,205 @@ namespace {
 		return std::make_shared<int>(next_id++);
 	}
 
+#ifdef EP_ASYNC_THREADS
+	bool threaded_requests = false;
+	// Incremented by ClearRequests, jobs of older requests are discarded
+	unsigned request_generation = 0;
+
+	struct DecodeTask {
+		/** Path of the request, empty for images of AsyncHandler::Prefetch */
+		std::string path;
+		unsigned generation;
+		Cache::DecodeJob job;
+	};
+
+	/**
+	 * Decodes the images of graphic requests on worker threads.
+	 * Finished tasks are collected by AsyncHandler::Update on the main thread.
+	 */
+	class DecodeWorkers {
+	public:
+		explicit DecodeWorkers(int num_threads) {
+			threads.reserve(num_threads);
+			for (int i = 0; i < num_threads; ++i) {
+				threads.emplace_back(&DecodeWorkers::WorkerFunction, this);
+			}
+		}
+
+		~DecodeWorkers() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				quit = true;
+			}
+			cv.notify_all();
+
+			for (auto& thread: threads) {
+				thread.join();
+			}
+		}
+
+		void Push(DecodeTask task) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				queued.push_back(std::move(task));
+			}
+			cv.notify_one();
+		}
+
+		std::vector<DecodeTask> TakeFinished() {
+			std::vector<DecodeTask> result;
+			std::lock_guard<std::mutex> lock(mutex);
+			result.swap(finished);
+			return result;
+		}
+
+		int GetNumThreads() const {
+			return static_cast<int>(threads.size());
+		}
+
+	private:
+		void WorkerFunction() {
+			std::unique_lock<std::mutex> lock(mutex);
+
+			for (;;) {
+				cv.wait(lock, [this]() { return quit || !queued.empty(); });
+				if (quit) {
+					return;
+				}
+
+				DecodeTask task = std::move(queued.front());
+				queued.pop_front();
+
+				lock.unlock();
+				task.job.Decode();
+				lock.lock();
+
+				finished.push_back(std::move(task));
+			}
+		}
+
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<DecodeTask> queued;
+		std::vector<DecodeTask> finished;
+		bool quit = false;
+	};
+
+	std::unique_ptr<DecodeWorkers> decode_workers;
+
+	DecodeWorkers& GetDecodeWorkers() {
+		if (!decode_workers) {
+			// One core is left for the main thread
+			decode_workers = std::make_unique<DecodeWorkers>(std::max(1, std::min(4, ThreadPool::GetHardwareThreads() - 1)));
+		}
+		return *decode_workers;
+	}
+
+	bool StartDecode(const std::string& path, const std::string& directory, const std::string& file, bool transparent) {
+		Cache::DecodeJob job;
+		if (!Cache::OpenDecodeJob({ directory, file, transparent }, job)) {
+			return false;
+		}
+
+		GetDecodeWorkers().Push({ path, request_generation, std::move(job) });
+		return true;
+	}
+#endif
+
+	// State of AsyncHandler::Prefetch
+	struct PrefetchQueue {
+		/** Images that were not requested yet */
+		std::deque<Cache::PreloadImage> images;
+		/** Requested images that are not downloaded yet */
+		std::vector<Cache::PreloadImage> downloading;
+		/** Images that are decoded on worker threads */
+		int decoding = 0;
+		/** Bytes that can still be loaded */
+		size_t budget = 0;
+		/** Images that were added to the cache */
+		int loaded = 0;
+	};
+
+	PrefetchQueue prefetch;
+
+	// Images that are downloaded or decoded at the same time. Without worker
+	// threads this is the number of images that are decoded per frame.
+	int GetPrefetchSlots() {
+#ifdef EP_ASYNC_THREADS
+		return GetDecodeWorkers().GetNumThreads() * 2;
+#else
+		return 1;
+#endif
+	}
+
+	void FinishPrefetch(Cache::DecodeJob& job) {
+		const size_t size = job.bitmap ? job.bitmap->GetSize() : 0;
+		if (Cache::AddDecoded(job)) {
+			prefetch.budget -= std::min(prefetch.budget, size);
+			++prefetch.loaded;
+		}
+	}
+
+	void StartPrefetchDecode(const Cache::PreloadImage& image) {
+		// Files are opened on the main thread, the filesystems are not thread safe
+		Cache::DecodeJob job;
+		if (!Cache::OpenDecodeJob(image, job)) {
+			return;
+		}
+
+#ifdef EP_ASYNC_THREADS
+		GetDecodeWorkers().Push({ "", request_generation, std::move(job) });
+		++prefetch.decoding;
+#else
+		job.Decode();
+		FinishPrefetch(job);
+#endif
+	}
+
+	void UpdatePrefetch() {
+		for (auto it = prefetch.downloading.begin(); it != prefetch.downloading.end();) {
+			auto* request = GetRequest(FileFinder::MakePath(it->folder, it->filename));
+			if (request && !request->IsReady()) {
+				++it;
+				continue;
+			}
+
+			StartPrefetchDecode(*it);
+			it = prefetch.downloading.erase(it);
+		}
+
+		const int slots = GetPrefetchSlots();
+		for (int started = 0; started < slots && !prefetch.images.empty(); ++started) {
+			if (prefetch.budget == 0 || Cache::GetAvailableSize() == 0) {
+				prefetch.images.clear();
+				break;
+			}
+
+			if (prefetch.decoding + static_cast<int>(prefetch.downloading.size()) >= slots) {
+				break;
+			}
+
+			auto image = std::move(prefetch.images.front());
+			prefetch.images.pop_front();
+
+			// Not downloaded yet on Emscripten, the request starts the download
+			auto* request = AsyncHandler::RequestFile(image.folder, image.filename);
+			request->Start();
+			if (!request->IsReady()) {
+				prefetch.downloading.push_back(std::move(image));
+				continue;
+			}
+
+			StartPrefetchDecode(image);
+		}
+
+		if (prefetch.loaded > 0 && prefetch.images.empty() && prefetch.downloading.empty() && prefetch.decoding == 0) {
+			Output::Debug("Prefetched {} images", prefetch.loaded);
+			prefetch.loaded = 0;
+		}
+	}
+
 #ifdef EMSCRIPTEN
 	constexpr size_t ASYNC_MAX_RETRY_COUNT{ 16 };
 
@@ -223,6 +432,74 @@ void AsyncHandler::ClearRequests() {
 		}
 	}
 	async_requests.clear();
+
+	prefetch.images.clear();
+	prefetch.downloading.clear();
+
+#ifdef EP_ASYNC_THREADS
+	++request_generation;
+#endif
+}
+
+void AsyncHandler::SetThreaded(bool threaded) {
+#ifdef EP_ASYNC_THREADS
+	threaded_requests = threaded;
+#else
+	(void)threaded;
+#endif
+}
+
+bool AsyncHandler::IsThreaded() {
+#ifdef EP_ASYNC_THREADS
+	return threaded_requests;
+#else
+	return false;
+#endif
+}
+
+void AsyncHandler::Prefetch(std::vector<Cache::PreloadImage> images, size_t budget) {
+	prefetch.images.assign(std::make_move_iterator(images.begin()), std::make_move_iterator(images.end()));
+	prefetch.budget = budget;
+
+	if (budget == 0) {
+		prefetch.images.clear();
+	}
+}
+
+void AsyncHandler::Update() {
+#ifdef EP_ASYNC_THREADS
+	if (decode_workers) {
+		for (auto& task: decode_workers->TakeFinished()) {
+			const bool prefetched = task.path.empty();
+			if (prefetched) {
+				--prefetch.decoding;
+			}
+
+			if (task.generation != request_generation) {
+				continue;
+			}
+
+			if (prefetched) {
+				FinishPrefetch(task.job);
+				continue;
+			}
+
+			// Referenced until the listeners loaded the image, otherwise it
+			// could be freed right away when the cache is full
+			BitmapRef bitmap = task.job.bitmap;
+			Cache::AddDecoded(task.job, true);
+
+			auto* request = GetRequest(task.path);
+			if (request) {
+				request->DownloadDone(true);
+			}
+		}
+	}
+#endif
+
+	if (!prefetch.images.empty() || !prefetch.downloading.empty() || prefetch.loaded > 0) {
+		UpdatePrefetch();
+	}
 }
 
 FileRequestAsync* AsyncHandler::RequestFile(StringView folder_name, StringView file_name) {
@@ -381,6 +658,16 @@ void FileRequestAsync::Start() {
 #    warning EM_GAME_URL set and not an Emscripten build!
 #  endif
 
+#  ifdef EP_ASYNC_THREADS
+	// Only images are decoded in the background, other files are read
+	// where they are used. Pictures are only decoded when their transparency
+	// is known, a wrong guess would be decoded again when loaded.
+	if (threaded_requests && graphic && (transparency_known || directory != "Picture")
+			&& StartDecode(path, directory, file, transparent)) {
+		return;
+	}
+#  endif
+
 #  ifndef EP_DEBUG_SIMULATE_ASYNC
 	DownloadDone(true);
 #  endif
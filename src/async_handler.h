@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "cache.h"
 #include "string_view.h"
 
 class FileRequestAsync;
@@ -30,6 +31,7 @@ struct FileRequestResult;
 /**
  * AsyncHandler supports asynchronous file requests for platforms that don't
  * support synchronous IO (e.g. Emscripten).
+ * On other platforms images can be decoded on worker threads (SetThreaded).
  */
 namespace AsyncHandler {
 	/**
@@ -93,6 +95,38 @@ namespace AsyncHandler {
 	 */
 	bool IsFilePending(bool important, bool graphic);
 
+	/**
+	 * Enables decoding the images of graphic requests on worker threads.
+	 * When disabled all requests finish in FileRequestAsync::Start, which
+	 * makes the game deterministic (e.g. for input replays).
+	 * Only supported on native builds with thread support.
+	 *
+	 * @param threaded whether requests are threaded
+	 */
+	void SetThreaded(bool threaded);
+
+	/** @return whether graphic requests are decoded on worker threads */
+	bool IsThreaded();
+
+	/**
+	 * Loads images into the cache in the background. Update requests and
+	 * opens a few of them at a time and decodes them on worker threads
+	 * until images of the budget size were loaded or the cache is full.
+	 * Without thread support one image is decoded per Update.
+	 * Images of an earlier call that were not started yet are dropped.
+	 *
+	 * @param images images to load, most important first
+	 * @param budget size limit of the loaded images in bytes
+	 */
+	void Prefetch(std::vector<Cache::PreloadImage> images, size_t budget);
+
+	/**
+	 * Finishes the requests that were decoded on worker threads and calls
+	 * their event handlers and continues the prefetch. Called by the Player
+	 * once per frame before the scene is updated.
+	 */
+	void Update();
+
 	/**
 	 * Saves the state of the Save filesystem.
 	 * Only works on emscripten, noop on other platforms.
@@ -159,6 +193,16 @@ public:
 	 */
 	void SetGraphicFile(bool graphic);
 
+	/**
+	 * Sets whether the first palette color of a picture is transparent.
+	 * Threaded graphic requests decode pictures with it, it must be set
+	 * before Start() is invoked. Pictures of requests without it are
+	 * decoded when they are loaded.
+	 *
+	 * @param transparent whether the picture is transparent
+	 */
+	void SetTransparent(bool transparent);
+
 	/**
 	 * Starts the async requests.
 	 * When the request was already started earlier and is pending this call
@@ -221,6 +265,8 @@ private:
 	int state = State_DoneFailure;
 	bool important = false;
 	bool graphic = false;
+	bool transparent = true;
+	bool transparency_known = false;
 };
 
 /**
@@ -259,6 +305,11 @@ inline bool FileRequestAsync::IsGraphicFile() const {
 	return graphic;
 }
 
+inline void FileRequestAsync::SetTransparent(bool transparent) {
+	this->transparent = transparent;
+	transparency_known = true;
+}
+
 inline const std::string& FileRequestAsync::GetPath() const {
 	return path;
 }
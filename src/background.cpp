@@ -22,6 +22,7 @@
 #include "cache.h"
 #include "background.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "main_data.h"
 #include <lcf/reader_util.h>
 #include "output.h"
@@ -115,6 +116,31 @@ int Background::Scale(int x) {
 	return x > 0 ? x / 64 : -(-x / 64);
 }
 
+bool Background::PrepareDraw() {
+	// The tone is applied in place on the whole screen
+	return tone_effect == Tone();
+}
+
+bool Background::TracksDamage() const {
+	return true;
+}
+
+uint64_t Background::GetDrawState(Rect& bounds) {
+	if (!bg_bitmap && !fg_bitmap && tone_effect == Tone()) {
+		bounds = {};
+		return 0;
+	}
+
+	bounds = Rect(0, 0, Player::screen_width, Player::screen_height);
+
+	DrawStateHash state;
+	state.Add(bg_bitmap.get()).Add(bg_bitmap ? bg_bitmap->GetRevision() : 0).Add(Scale(bg_x)).Add(Scale(bg_y));
+	state.Add(fg_bitmap.get()).Add(fg_bitmap ? fg_bitmap->GetRevision() : 0).Add(Scale(fg_x)).Add(Scale(fg_y));
+	state.Add(Main_Data::game_screen->GetShakeOffsetX()).Add(Main_Data::game_screen->GetShakeOffsetY());
+	state.Add(tone_effect);
+	return state.Get();
+}
+
 void Background::Draw(Bitmap& dst) {
 	Rect dst_rect = dst.GetRect();
 
@@ -31,6 +31,10 @@ public:
 	Background(int terrain_id);
 
 	void Draw(Bitmap& dst) override;
+
+	bool PrepareDraw() override;
+	bool TracksDamage() const override;
+	uint64_t GetDrawState(Rect& bounds) override;
 	void Update();
 	Tone GetTone() const;
 	void SetTone(Tone tone);
@@ -0,0 +1,87 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "band_renderer.h"
+#include "bitmap.h"
+#include "drawable.h"
+
+namespace {
+	// More bands than threads balance the load when the drawables
+	// are not spread evenly over the screen
+	constexpr int bands_per_thread = 4;
+	constexpr int min_band_height = 16;
+}
+
+BandRenderer::BandRenderer(int num_threads) : pool(num_threads) {
+}
+
+void BandRenderer::Begin(Bitmap& dst) {
+	this->dst = &dst;
+	pending.clear();
+
+	if (bands_pixels == dst.pixels() && bands_width == dst.width() && bands_height == dst.height() && bands_pitch == dst.pitch()) {
+		return;
+	}
+
+	bands_pixels = dst.pixels();
+	bands_width = dst.width();
+	bands_height = dst.height();
+	bands_pitch = dst.pitch();
+	bands.clear();
+
+	// Without worker threads a single band avoids drawing everything several times
+	const int max_bands = std::max(1, bands_height / min_band_height);
+	const int num_bands = pool.GetNumThreads() > 1 ? std::min(pool.GetNumThreads() * bands_per_thread, max_bands) : 1;
+
+	for (int i = 0; i < num_bands; ++i) {
+		const int y0 = bands_height * i / num_bands;
+		const int y1 = bands_height * (i + 1) / num_bands;
+		bands.push_back(dst.CreateClippedView(Rect(0, y0, bands_width, y1 - y0)));
+	}
+}
+
+void BandRenderer::Draw(Drawable& drawable) {
+	if (drawable.PrepareDraw()) {
+		pending.push_back(&drawable);
+		return;
+	}
+
+	Flush();
+	drawable.DrawPrepared(*dst);
+}
+
+void BandRenderer::End() {
+	Flush();
+	dst = nullptr;
+}
+
+void BandRenderer::Flush() {
+	if (pending.empty()) {
+		return;
+	}
+
+	pool.ParallelFor(static_cast<int>(bands.size()), [this](int band) {
+		auto& band_dst = *bands[band];
+		for (auto* drawable: pending) {
+			drawable->DrawPrepared(band_dst);
+		}
+	});
+
+	pending.clear();
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_BAND_RENDERER_H
+#define EP_BAND_RENDERER_H
+
+// Headers
+#include <vector>
+#include "memory_management.h"
+#include "thread_pool.h"
+
+class Bitmap;
+class Drawable;
+
+/**
+ * Draws drawables in horizontal bands of the screen on several threads.
+ *
+ * Drawables are prepared in z order on the calling thread. Consecutive
+ * drawables that are band safe (Drawable::PrepareDraw returns true) are
+ * collected and drawn band by band on the worker threads. Every band is
+ * owned by one thread and gets the drawables in z order, so the result
+ * is identical to drawing them one after another. Other drawables are
+ * drawn on the calling thread after all collected drawables finished.
+ *
+ * Every band is a view with its own pixman image. The source bitmaps of
+ * the drawables are shared by all threads, so PrepareDraw must call
+ * Bitmap::PrepareParallelRead on sources that are blitted with pixman.
+ */
+class BandRenderer {
+public:
+	/**
+	 * @param num_threads number of threads, 0 uses the number of CPU cores
+	 */
+	explicit BandRenderer(int num_threads = 0);
+
+	/**
+	 * Starts drawing a frame.
+	 *
+	 * @param dst destination bitmap
+	 */
+	void Begin(Bitmap& dst);
+
+	/**
+	 * Draws a drawable on the bitmap passed to Begin.
+	 *
+	 * @param drawable drawable to draw
+	 */
+	void Draw(Drawable& drawable);
+
+	/** Finishes the frame, all drawables are drawn afterwards */
+	void End();
+
+	/** @return number of bands the screen is split into */
+	int GetNumBands() const;
+
+private:
+	void Flush();
+
+	ThreadPool pool;
+
+	Bitmap* dst = nullptr;
+	std::vector<BitmapRef> bands;
+	std::vector<Drawable*> pending;
+
+	void* bands_pixels = nullptr;
+	int bands_width = 0;
+	int bands_height = 0;
+	int bands_pitch = 0;
+};
+
+inline int BandRenderer::GetNumBands() const {
+	return static_cast<int>(bands.size());
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "baseui.h"
 #include "bitmap.h"
 #include "player.h"
+#include "thread_pool.h"
 
 #if USE_SDL==2
 #  include "platform/sdl/sdl2_ui.h"
@@ -68,6 +69,40 @@ void BaseUi::CleanDisplay() {
 	main_surface->Clear();
 }
 
+void BaseUi::AddDisplayDamage(const DamageTracker& damage) {
+	if (display_damage.GetScreenRect() != main_surface->GetRect()) {
+		display_damage.SetSize(main_surface->width(), main_surface->height());
+	}
+
+	if (damage.IsFull()) {
+		display_damage.SetFull();
+	} else {
+		for (const auto& rect: damage.GetRects()) {
+			display_damage.Add(rect);
+		}
+	}
+
+	display_damage_revision = main_surface->GetRevision();
+}
+
+const std::vector<Rect>& BaseUi::TakeDisplayDamage() {
+	// Modified without reporting it (e.g. an error message) or a new surface
+	if (display_damage.GetScreenRect() != main_surface->GetRect() || display_damage_revision != main_surface->GetRevision()) {
+		display_damage.SetSize(main_surface->width(), main_surface->height());
+	}
+
+	// The rects stay valid until the next call
+	display_damage_rects = display_damage.GetRects();
+	display_damage.Clear();
+	display_damage_revision = main_surface->GetRevision();
+
+	return display_damage_rects;
+}
+
+void BaseUi::TogglePartialUpdate() {
+	vcfg.partial_update.Toggle();
+}
+
 void BaseUi::SetGameResolution(ConfigEnum::GameResolution resolution) {
 	vcfg.game_resolution.Set(resolution);
 }
@@ -79,6 +114,14 @@ Game_ConfigVideo BaseUi::GetConfig() const {
 
 	vGetConfig(cfg);
 
+	// Drawing with threads is independent of the backend
+	if (ThreadPool::GetHardwareThreads() > 1) {
+		cfg.threaded_rendering.SetOptionVisible(true);
+	}
+
+	// Drawing only the changed parts is independent of the backend
+	cfg.partial_update.SetOptionVisible(true);
+
 	Rect metrics = GetWindowMetrics();
 	cfg.window_x.Set(metrics.x);
 	cfg.window_y.Set(metrics.y);
@@ -22,9 +22,11 @@
 #include <cstdint>
 #include <string>
 #include <bitset>
+#include <vector>
 
 #include "system.h"
 #include "color.h"
+#include "damage_tracker.h"
 #include "font.h"
 #include "point.h"
 #include "rect.h"
@@ -171,6 +173,18 @@ public:
 	BitmapRef const& GetDisplaySurface() const;
 	BitmapRef& GetDisplaySurface();
 
+	/** @return true if only the changed parts of the screen are drawn and transferred */
+	bool IsPartialUpdate() const;
+
+	/**
+	 * Reports the parts of the display surface that were drawn since the
+	 * last UpdateDisplay. The whole surface is transferred when the surface
+	 * is modified without reporting it.
+	 *
+	 * @param damage changed parts of the display surface
+	 */
+	void AddDisplayDamage(const DamageTracker& damage);
+
 	/**
 	 * Requests a resolution change of the framebuffer.
 	 *
@@ -210,6 +224,15 @@ public:
 	 */
 	void SetPauseWhenFocusLost(bool value);
 
+	/** @return true if the screen is drawn with several threads */
+	bool IsThreadedRendering() const;
+
+	/**
+	 * Set whether the screen is drawn with several threads.
+	 * @param value
+	 */
+	void SetThreadedRendering(bool value);
+
 	/**
 	 * @return the minimum amount of time each physical frame should take.
 	 * If the UI manages time (i.e.) vsync, will return a 0 duration.
@@ -254,6 +277,12 @@ public:
 	/** Turns a touch ui on or off. */
 	virtual void ToggleTouchUi() {};
 
+	/** Turns drawing and transferring only the changed parts of the screen on or off. */
+	virtual void TogglePartialUpdate();
+
+	/** Turns displaying the frame on a separate thread on or off. */
+	virtual void ToggleThreadedPresentation() {};
+
 	/**
 	 * @return current video options.
 	 */
@@ -270,6 +299,14 @@ protected:
 	virtual void vGetConfig(Game_ConfigVideo& cfg) const = 0;
 	virtual bool vChangeDisplaySurfaceResolution(int new_width, int new_height);
 
+	/**
+	 * Returns the parts of the display surface that changed since the last
+	 * call, see AddDisplayDamage.
+	 *
+	 * @return changed rects, the whole surface when the changes are unknown
+	 */
+	const std::vector<Rect>& TakeDisplayDamage();
+
 	Game_ConfigVideo vcfg;
 
 	/**
@@ -293,6 +330,15 @@ protected:
 	/** Surface used for zoom. */
 	BitmapRef main_surface;
 
+	/** Reported changes of main_surface, see AddDisplayDamage */
+	DamageTracker display_damage;
+
+	/** Revision of main_surface when the damage was reported */
+	uint64_t display_damage_revision = 0;
+
+	/** Result of TakeDisplayDamage */
+	std::vector<Rect> display_damage_rects;
+
 	/** Mouse position on screen relative to the window. */
 	Point mouse_pos;
 
@@ -419,6 +465,18 @@ inline void BaseUi::SetPauseWhenFocusLost(bool value) {
 	vcfg.pause_when_focus_lost.Set(value);
 }
 
+inline bool BaseUi::IsPartialUpdate() const {
+	return vcfg.partial_update.Get();
+}
+
+inline bool BaseUi::IsThreadedRendering() const {
+	return vcfg.threaded_rendering.Get();
+}
+
+inline void BaseUi::SetThreadedRendering(bool value) {
+	vcfg.threaded_rendering.Set(value);
+}
+
 inline Game_Clock::duration BaseUi::GetFrameLimit() const {
 	return IsFrameRateSynchronized() ? Game_Clock::duration(0) : frame_limit;
 }
@@ -37,6 +37,9 @@ public:
 	/** Update the animation to the next animation **/
 	void Update();
 
+	/** Animations draw their cells while drawing, the screen is redrawn completely while they are visible */
+	bool TracksDamage() const override;
+
 	/** @return the current timing frame (2x the number of frames in the underlying animation **/
 	int GetFrame() const;
 
@@ -177,4 +180,8 @@ inline int BattleAnimation::GetAnimationCellHeight() const {
 	return (animation.large ? 128 : 96);
 }
 
+inline bool BattleAnimation::TracksDamage() const {
+	return false;
+}
+
 #endif
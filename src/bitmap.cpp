@@ -20,7 +20,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <limits>
 #include <unordered_map>
 
 #include "utils.h"
@@ -38,6 +41,8 @@
 #include "output.h"
 #include "util_macro.h"
 #include "bitmap_hslrgb.h"
+#include "bitmap_tone.h"
+#include "pixel_ops.h"
 #include <iostream>
 
 BitmapRef Bitmap::Create(int width, int height, const Color& color) {
@@ -78,6 +83,58 @@ BitmapRef Bitmap::Create(void *pixels, int width, int height, int pitch, const D
 	return std::make_shared<Bitmap>(pixels, width, height, pitch, format);
 }
 
+Bitmap::DecodedInfo Bitmap::GetDecodedInfo() const {
+	DecodedInfo info;
+	info.original_bpp = original_bpp;
+	info.read_only = read_only;
+	info.image_opacity = image_opacity;
+	info.bg_color = bg_color;
+	info.sh_color = sh_color;
+
+	if (!tile_opacity.Empty()) {
+		const int h = height() / TILE_SIZE;
+		const int w = width() / TILE_SIZE;
+		for (int ty = 0; ty < h; ++ty) {
+			for (int tx = 0; tx < w; ++tx) {
+				info.tile_opacity.push_back(tile_opacity.Get(tx, ty));
+			}
+		}
+	}
+
+	return info;
+}
+
+BitmapRef Bitmap::CreateDecoded(void* pixels, int width, int height, int pitch, bool transparent, const DecodedInfo& info, std::function<void()> release) {
+	BitmapRef bmp = Create(pixels, width, height, pitch, transparent ? pixel_format : opaque_pixel_format);
+
+	if (release) {
+		pixman_image_set_destroy_function(bmp->bitmap.get(), [](pixman_image_t*, void* data) {
+			auto* release = static_cast<std::function<void()>*>(data);
+			(*release)();
+			delete release;
+		}, new std::function<void()>(std::move(release)));
+	}
+
+	bmp->original_bpp = info.original_bpp;
+	bmp->read_only = info.read_only;
+	bmp->image_opacity = info.image_opacity;
+	bmp->bg_color = info.bg_color;
+	bmp->sh_color = info.sh_color;
+
+	const int h = height / TILE_SIZE;
+	const int w = width / TILE_SIZE;
+	if (!info.tile_opacity.empty() && info.tile_opacity.size() == static_cast<size_t>(w * h)) {
+		bmp->tile_opacity = TileOpacity(w, h);
+		for (int ty = 0; ty < h; ++ty) {
+			for (int tx = 0; tx < w; ++tx) {
+				bmp->tile_opacity.Set(tx, ty, info.tile_opacity[tx + ty * w]);
+			}
+		}
+	}
+
+	return bmp;
+}
+
 Bitmap::Bitmap(int width, int height, bool transparent) {
 	format = (transparent ? pixel_format : opaque_pixel_format);
 	pixman_format = find_format(format);
@@ -298,7 +355,44 @@ Color Bitmap::GetColorAt(int x, int y) const {
 	return color;
 }
 
+namespace {
+	/**
+	 * Memoizes RGB_adjust_HSL for one hue. Sprites use few distinct colors,
+	 * so most pixels are found in the table and skip the HSL conversion.
+	 */
+	class HueTable {
+	public:
+		explicit HueTable(int hue) : hue(hue) {
+			// No packed color has bits above 24 set
+			keys.fill(0xFFFFFFFFu);
+		}
+
+		void Adjust(uint8_t& r, uint8_t& g, uint8_t& b) {
+			const uint32_t key = (r << 16) | (g << 8) | b;
+			const size_t slot = (key * 2654435761u) >> (32 - table_bits);
+			if (keys[slot] != key) {
+				RGB_adjust_HSL(r, g, b, hue);
+				keys[slot] = key;
+				values[slot] = (r << 16) | (g << 8) | b;
+				return;
+			}
+			const uint32_t value = values[slot];
+			r = (value >> 16) & 0xFF;
+			g = (value >> 8) & 0xFF;
+			b = value & 0xFF;
+		}
+
+	private:
+		static constexpr int table_bits = 10;
+
+		int hue;
+		std::array<uint32_t, 1 << table_bits> keys;
+		std::array<uint32_t, 1 << table_bits> values;
+	};
+}
+
 void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect_, double hue_) {
+	++revision;
 	Rect dst_rect(x, y, 0, 0), src_rect = src_rect_;
 
 	if (!Rect::AdjustRectangles(src_rect, dst_rect, src.GetRect()))
@@ -312,6 +406,40 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 	else if (hue > 0x600)
 		hue -= (hue / 0x600) * 0x600;
 
+	HueTable table(hue);
+
+	if (IsDirectSource(src)) {
+		if (!Rect::AdjustRectangles(dst_rect, src_rect, GetClipRect()))
+			return;
+
+		// Same result as the temporary bitmap below: The hue of the premultiplied
+		// source pixels is rotated and the result is composited over this bitmap
+		const int r_shift = pixel_format.r.shift;
+		const int g_shift = pixel_format.g.shift;
+		const int b_shift = pixel_format.b.shift;
+		const int a_shift = pixel_format.a.shift;
+		const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+		const uint32_t channel_mask = (0xFFu << r_shift) | (0xFFu << g_shift) | (0xFFu << b_shift);
+
+		for (int row = 0; row < dst_rect.height; ++row) {
+			const uint32_t* src_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src.pixels()) + (src_rect.y + row) * src.pitch()) + src_rect.x;
+			uint32_t* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + (dst_rect.y + row) * pitch()) + dst_rect.x;
+
+			for (int col = 0; col < dst_rect.width; ++col) {
+				uint32_t pixel = src_px[col] | alpha_mask;
+				if ((pixel >> a_shift & 0xFF) != 0) {
+					uint8_t r = (pixel >> r_shift) & 0xFF;
+					uint8_t g = (pixel >> g_shift) & 0xFF;
+					uint8_t b = (pixel >> b_shift) & 0xFF;
+					table.Adjust(r, g, b);
+					pixel = (pixel & ~channel_mask) | ((uint32_t) r << r_shift) | ((uint32_t) g << g_shift) | ((uint32_t) b << b_shift);
+				}
+				dst_px[col] = PixelOps::Over(pixel, dst_px[col], a_shift);
+			}
+		}
+		return;
+	}
+
 	DynamicFormat format(32,8,24,8,16,8,8,8,0,PF::Alpha);
 	std::vector<uint32_t> pixels;
 	pixels.resize(src_rect.width * src_rect.height);
@@ -325,7 +453,7 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 		uint8_t b = (pixel>> 8) & 0xFF;
 		uint8_t a = pixel & 0xFF;
 		if (a > 0)
-			RGB_adjust_HSL(r, g, b, hue);
+			table.Adjust(r, g, b);
 		*p = ((uint32_t) r << 24) | ((uint32_t) g << 16) | ((uint32_t) b << 8) | (uint32_t) a;
 	}
 
@@ -358,6 +486,7 @@ Point Bitmap::TextDraw(Rect const& rect, int color, StringView text, Text::Align
 }
 
 Point Bitmap::TextDraw(int x, int y, int color, StringView text, Text::Alignment align) {
+	++revision;
 	auto f = font ? font : Font::Default();
 	auto system = Cache::SystemOrBlack();
 	return Text::Draw(*this, x, y, *f, *system, color, text, align);
@@ -389,6 +518,7 @@ Point Bitmap::TextDraw(Rect const& rect, Color color, StringView text, Text::Ali
 }
 
 Point Bitmap::TextDraw(int x, int y, Color color, StringView text) {
+	++revision;
 	auto f = font ? font : Font::Default();
 	return Text::Draw(*this, x, y, *f, color, text);
 }
@@ -461,6 +591,7 @@ DynamicFormat Bitmap::pixel_format;
 DynamicFormat Bitmap::opaque_pixel_format;
 DynamicFormat Bitmap::image_format;
 DynamicFormat Bitmap::opaque_image_format;
+bool Bitmap::pixman_affine_blit = false;
 
 void Bitmap::SetFormat(const DynamicFormat& format) {
 	pixel_format = format;
@@ -550,6 +681,32 @@ void Bitmap::ConvertImage(int& width, int& height, void*& pixels, bool transpare
 	free(pixels);
 }
 
+BitmapRef Bitmap::CreateClippedView(Rect const& rect) {
+	auto view = Create(pixels(), width(), height(), pitch(), format);
+
+	view->clip_rect = rect;
+	view->clip_rect.Adjust(GetRect());
+
+	pixman_region32_t region;
+	pixman_region32_init_rect(&region, view->clip_rect.x, view->clip_rect.y, view->clip_rect.width, view->clip_rect.height);
+	pixman_image_set_clip_region32(view->bitmap.get(), &region);
+	pixman_region32_fini(&region);
+
+	return view;
+}
+
+uint64_t Bitmap::CreateRevision() {
+	// Every bitmap starts at its own multiple of 2^32
+	static std::atomic<uint64_t> next_revision { 0 };
+	return next_revision.fetch_add(uint64_t(1) << 32, std::memory_order_relaxed);
+}
+
+void Bitmap::PrepareParallelRead() const {
+	// The image is validated before the empty area is rejected.
+	// Undocumented pixman behaviour, see the header.
+	pixman_image_composite32(PIXMAN_OP_SRC, bitmap.get(), nullptr, bitmap.get(), 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
 void* Bitmap::pixels() {
 	if (!bitmap) {
 		return nullptr;
@@ -578,6 +735,16 @@ int Bitmap::pitch() const {
 }
 
 namespace {
+	Transform CreateMaskTransform(Opacity const& opacity, Rect const& src_rect, Transform const* pxform) {
+		Transform xform = Transform::Scale(1.0 / src_rect.width, 1.0 / src_rect.height);
+		xform *= Transform::Translation(0, opacity.split);
+
+		if (pxform)
+			xform *= *pxform;
+
+		return xform;
+	}
+
 	PixmanImagePtr CreateMask(Opacity const& opacity, Rect const& src_rect, Transform const* pxform = nullptr) {
 		if (opacity.IsOpaque()) {
 			return nullptr;
@@ -593,23 +760,336 @@ namespace {
 		*reinterpret_cast<uint8_t*>(&pixels[0]) = (opacity.top & 0xFF);
 		*reinterpret_cast<uint8_t*>(&pixels[1]) = (opacity.bottom & 0xFF);
 
-		Transform xform = Transform::Scale(1.0 / src_rect.width, 1.0 / src_rect.height);
-		xform *= Transform::Translation(0, opacity.split);
-
-		if (pxform)
-			xform *= *pxform;
-
+		Transform xform = CreateMaskTransform(opacity, src_rect, pxform);
 		pixman_image_set_transform(mask.get(), &xform.matrix);
 
 		return mask;
 	}
+
+	enum class CopyMode {
+		/** Copy the pixels */
+		Copy,
+		/** Copy the pixels and set the alpha channel (source without alpha channel) */
+		CopyOpaque,
+		/** Copy only the opaque pixels (source with 1 bit alpha) */
+		CopyMasked
+	};
+
+	void CopyPixels(uint32_t* dst, const uint32_t* src, int count, CopyMode mode, uint32_t alpha_mask) {
+		switch (mode) {
+			case CopyMode::Copy:
+				std::memcpy(dst, src, count * sizeof(uint32_t));
+				break;
+			case CopyMode::CopyOpaque:
+				for (int i = 0; i < count; ++i) {
+					dst[i] = src[i] | alpha_mask;
+				}
+				break;
+			case CopyMode::CopyMasked:
+				for (int i = 0; i < count; ++i) {
+					if ((src[i] & alpha_mask) != 0) {
+						dst[i] = src[i];
+					}
+				}
+				break;
+		}
+	}
+
+	/** Source position of a scanline in 16.16 fixed point, stepped like the nearest neighbour fetchers of pixman */
+	struct AffineScanline {
+		int64_t x;
+		int64_t y;
+		int64_t ux;
+		int64_t uy;
+
+		AffineScanline(Transform const& xform, int px, int py) {
+			pixman_vector_t v = {{ pixman_int_to_fixed(px) + pixman_fixed_1 / 2, pixman_int_to_fixed(py) + pixman_fixed_1 / 2, pixman_fixed_1 }};
+			pixman_transform_point_3d(&xform.matrix, &v);
+
+			// The sampled pixel is floor(position - epsilon)
+			x = v.vector[0] - pixman_fixed_e;
+			y = v.vector[1] - pixman_fixed_e;
+			ux = xform.matrix.matrix[0][0];
+			uy = xform.matrix.matrix[1][0];
+		}
+	};
+
+	int64_t FloorDiv(int64_t a, int64_t b) {
+		return a >= 0 ? a / b : -((b - 1 - a) / b);
+	}
+
+	/**
+	 * Restricts the pixels [first, last) of a scanline to the pixels i with
+	 * 0 <= pos + i * step < limit.
+	 */
+	void ClipSpan(int64_t pos, int64_t step, int64_t limit, int& first, int& last) {
+		int64_t lo;
+		int64_t hi;
+		if (step > 0) {
+			lo = FloorDiv(step - 1 - pos, step);
+			hi = FloorDiv(limit - 1 - pos, step);
+		} else if (step < 0) {
+			lo = FloorDiv(pos - limit, -step) + 1;
+			hi = FloorDiv(pos, -step);
+		} else if (pos >= 0 && pos < limit) {
+			return;
+		} else {
+			lo = last;
+			hi = first - 1;
+		}
+
+		first = static_cast<int>(std::max<int64_t>(first, std::min<int64_t>(lo, last)));
+		last = static_cast<int>(std::min<int64_t>(last, std::max<int64_t>(hi + 1, first)));
+	}
+
+	enum class AffineMode {
+		/** Copy the pixels (opaque source or operator SRC) */
+		Copy,
+		/** Copy only the opaque pixels (source with 1 bit alpha) */
+		CopyMasked,
+		/** Composite the pixels with an opacity (operator OVER) */
+		Over
+	};
+
+	template <AffineMode mode>
+	void AffineSpan(uint32_t* dst, int count, const uint8_t* src, int src_pitch, AffineScanline const& pos, int first,
+			uint32_t alpha_mask, uint32_t opacity, int a_shift) {
+		int64_t x = pos.x + first * pos.ux;
+		int64_t y = pos.y + first * pos.uy;
+
+		auto draw = [&](uint32_t& dst_px, uint32_t px) {
+			px |= alpha_mask;
+			if (mode == AffineMode::Copy) {
+				dst_px = px;
+			} else if (mode == AffineMode::CopyMasked) {
+				if ((px >> a_shift & 0xFF) != 0) {
+					dst_px = px;
+				}
+			} else {
+				dst_px = PixelOps::OverMask(px, dst_px, opacity, a_shift);
+			}
+		};
+
+		if (pos.uy == 0) {
+			// Scaled without rotation, the source row is the same for the whole span
+			auto* src_row = reinterpret_cast<const uint32_t*>(src + (y >> 16) * src_pitch);
+			for (int i = 0; i < count; ++i) {
+				draw(dst[i], src_row[x >> 16]);
+				x += pos.ux;
+			}
+			return;
+		}
+
+		for (int i = 0; i < count; ++i) {
+			draw(dst[i], reinterpret_cast<const uint32_t*>(src + (y >> 16) * src_pitch)[x >> 16]);
+			x += pos.ux;
+			y += pos.uy;
+		}
+	}
+
+	/**
+	 * Draws a row of the source resampled with a column table.
+	 *
+	 * @param dst destination pixels
+	 * @param src_row source row
+	 * @param cols source column of every destination pixel
+	 * @param count number of pixels
+	 * @param mode how the pixels are drawn
+	 * @param alpha_mask alpha channel of sources without alpha
+	 * @param opacity opacity for AffineMode::Over
+	 * @param a_shift bit position of the alpha channel
+	 */
+	void ResampleRow(uint32_t* dst, const uint32_t* src_row, const int* cols, int count, AffineMode mode,
+			uint32_t alpha_mask, uint32_t opacity, int a_shift) {
+		switch (mode) {
+			case AffineMode::Copy:
+				for (int i = 0; i < count; ++i) {
+					dst[i] = src_row[cols[i]] | alpha_mask;
+				}
+				break;
+			case AffineMode::CopyMasked:
+				for (int i = 0; i < count; ++i) {
+					const uint32_t px = src_row[cols[i]];
+					if ((px >> a_shift & 0xFF) != 0) {
+						dst[i] = px;
+					}
+				}
+				break;
+			case AffineMode::Over:
+				for (int i = 0; i < count; ++i) {
+					dst[i] = PixelOps::OverMask(src_row[cols[i]] | alpha_mask, dst[i], opacity, a_shift);
+				}
+				break;
+		}
+	}
 } // anonymous namespace
 
+bool Bitmap::GetCopyMode(Bitmap const& src, Rect const& src_rect, pixman_op_t op, int& mode) const {
+	if (!IsDirectSource(src)) {
+		return false;
+	}
+
+	// Pixels outside of the source are transparent for pixman, only the pixman path handles this
+	Rect src_bounds = src_rect;
+	src_bounds.Adjust(src.GetRect());
+	if (src_bounds != src_rect) {
+		return false;
+	}
+
+	const auto src_opacity = src.GetImageOpacity();
+	if (op == PIXMAN_OP_SRC || (op == PIXMAN_OP_OVER && src_opacity == ImageOpacity::Opaque)) {
+		mode = static_cast<int>(src.GetTransparent() ? CopyMode::Copy : CopyMode::CopyOpaque);
+		return true;
+	}
+
+	if (op == PIXMAN_OP_OVER && src_opacity == ImageOpacity::Alpha_1Bit) {
+		// Transparent pixels are 0, opaque pixels replace the destination
+		mode = static_cast<int>(CopyMode::CopyMasked);
+		return true;
+	}
+
+	return false;
+}
+
+bool Bitmap::BlitDirect(int x, int y, Bitmap const& src, Rect const& src_rect, pixman_op_t op) {
+	int mode;
+	if (!GetCopyMode(src, src_rect, op, mode)) {
+		return false;
+	}
+
+	Rect dst_rect(x, y, src_rect.width, src_rect.height);
+	dst_rect.Adjust(GetClipRect());
+	if (dst_rect.IsEmpty()) {
+		return true;
+	}
+
+	const int sx = src_rect.x + dst_rect.x - x;
+	const int sy = src_rect.y + dst_rect.y - y;
+	const uint32_t alpha_mask = 0xFFu << pixel_format.a.shift;
+
+	for (int row = 0; row < dst_rect.height; ++row) {
+		auto* src_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src.pixels()) + (sy + row) * src.pitch()) + sx;
+		auto* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + (dst_rect.y + row) * pitch()) + dst_rect.x;
+		CopyPixels(dst_px, src_px, dst_rect.width, static_cast<CopyMode>(mode), alpha_mask);
+	}
+
+	return true;
+}
+
+bool Bitmap::AffineBlitDirect(Bitmap const& src, Rect const& image_rect, Transform const& xform,
+		Opacity const& opacity, Rect const& mask_rect, pixman_op_t op,
+		int src_x, int src_y, int mask_x, int mask_y, Rect const& dst_rect) {
+	if (!IsDirectSource(src)) {
+		return false;
+	}
+
+	if (op != PIXMAN_OP_OVER && !(op == PIXMAN_OP_SRC && opacity.IsOpaque())) {
+		return false;
+	}
+
+	const auto& m = xform.matrix.matrix;
+	if (m[2][0] != 0 || m[2][1] != 0 || m[2][2] != pixman_fixed_1) {
+		// Projective transformation
+		return false;
+	}
+
+	Rect image_bounds = image_rect;
+	image_bounds.Adjust(src.GetRect());
+	if (image_bounds != image_rect || image_rect.IsEmpty()) {
+		return false;
+	}
+
+	Rect rect = dst_rect;
+	rect.Adjust(GetClipRect());
+	if (rect.IsEmpty()) {
+		return true;
+	}
+
+	const int a_shift = pixel_format.a.shift;
+	const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+	const bool src_opaque = alpha_mask != 0 || src.GetImageOpacity() == ImageOpacity::Opaque;
+	const bool src_1bit = src.GetImageOpacity() == ImageOpacity::Alpha_1Bit;
+
+	// Mask values of CreateMask
+	const bool split = opacity.IsSplit();
+	const uint32_t top = opacity.IsOpaque() ? 255 : (opacity.top & 0xFF);
+	const uint32_t bottom = split ? (opacity.bottom & 0xFF) : top;
+	const Transform mask_xform = split ? CreateMaskTransform(opacity, mask_rect, &xform) : xform;
+
+	const int src_pitch = src.pitch();
+	auto* src_pixels = static_cast<const uint8_t*>(src.pixels()) + image_rect.y * src_pitch + image_rect.x * sizeof(uint32_t);
+	const int64_t x_limit = static_cast<int64_t>(image_rect.width) << 16;
+	const int64_t y_limit = static_cast<int64_t>(image_rect.height) << 16;
+
+	auto draw_span = [&](uint32_t* dst_row, int first, int last, AffineScanline const& pos, uint32_t mask_value) {
+		if (first >= last || mask_value == 0) {
+			return;
+		}
+
+		if (op == PIXMAN_OP_SRC || (mask_value == 255 && src_opaque)) {
+			AffineSpan<AffineMode::Copy>(dst_row + first, last - first, src_pixels, src_pitch, pos, first, alpha_mask, mask_value, a_shift);
+		} else if (mask_value == 255 && src_1bit) {
+			AffineSpan<AffineMode::CopyMasked>(dst_row + first, last - first, src_pixels, src_pitch, pos, first, alpha_mask, mask_value, a_shift);
+		} else {
+			AffineSpan<AffineMode::Over>(dst_row + first, last - first, src_pixels, src_pitch, pos, first, alpha_mask, mask_value, a_shift);
+		}
+	};
+
+	for (int y = rect.y; y < rect.y + rect.height; ++y) {
+		auto* dst_row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + y * pitch()) + rect.x;
+		const int dx = rect.x - dst_rect.x;
+		const int dy = y - dst_rect.y;
+
+		// Only the span of the scanline that samples inside of the source image
+		const AffineScanline pos(xform, src_x + dx, src_y + dy);
+		int first = 0;
+		int last = rect.width;
+		ClipSpan(pos.x, pos.ux, x_limit, first, last);
+		ClipSpan(pos.y, pos.uy, y_limit, first, last);
+
+		if (op == PIXMAN_OP_SRC) {
+			// Pixels outside of the source are transparent
+			std::fill(dst_row, dst_row + first, 0);
+			std::fill(dst_row + last, dst_row + rect.width, 0);
+		}
+
+		if (!split) {
+			draw_span(dst_row, first, last, pos, top);
+			continue;
+		}
+
+		// The mask is 1x2 pixels: top opacity in the first row, bottom opacity in the second row
+		const AffineScanline mask_pos(mask_xform, mask_x + dx, mask_y + dy);
+		int mask_first = first;
+		int mask_last = last;
+		ClipSpan(mask_pos.x, mask_pos.ux, 1 << 16, mask_first, mask_last);
+		ClipSpan(mask_pos.y, mask_pos.uy, 2 << 16, mask_first, mask_last);
+
+		int top_first = mask_first;
+		int top_last = mask_last;
+		ClipSpan(mask_pos.y, mask_pos.uy, 1 << 16, top_first, top_last);
+		if (top_first >= top_last) {
+			top_first = top_last = mask_last;
+		}
+
+		draw_span(dst_row, mask_first, top_first, pos, bottom);
+		draw_span(dst_row, top_first, top_last, pos, top);
+		draw_span(dst_row, top_last, mask_last, pos, bottom);
+	}
+
+	return true;
+}
+
 void Bitmap::Blit(int x, int y, Bitmap const& src, Rect const& src_rect, Opacity const& opacity, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
 
+	if (opacity.IsOpaque() && BlitDirect(x, y, src, src_rect, src.GetOperator(nullptr, blend_mode))) {
+		return;
+	}
+
 	auto mask = CreateMask(opacity, src_rect);
 
 	pixman_image_composite32(src.GetOperator(mask.get(), blend_mode),
@@ -622,10 +1102,15 @@ void Bitmap::Blit(int x, int y, Bitmap const& src, Rect const& src_rect, Opacity
 }
 
 void Bitmap::BlitFast(int x, int y, Bitmap const & src, Rect const & src_rect, Opacity const & opacity) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
 
+	if (BlitDirect(x, y, src, src_rect, PIXMAN_OP_SRC)) {
+		return;
+	}
+
 	pixman_image_composite32(PIXMAN_OP_SRC,
 		src.bitmap.get(),
 		nullptr, bitmap.get(),
@@ -646,6 +1131,7 @@ void Bitmap::TiledBlit(Rect const& src_rect, Bitmap const& src, Rect const& dst_
 }
 
 void Bitmap::TiledBlit(int ox, int oy, Rect const& src_rect, Bitmap const& src, Rect const& dst_rect, Opacity const& opacity, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -655,6 +1141,30 @@ void Bitmap::TiledBlit(int ox, int oy, Rect const& src_rect, Bitmap const& src,
 	if (ox < 0) ox += src_rect.width  * ((-ox + src_rect.width  - 1) / src_rect.width);
 	if (oy < 0) oy += src_rect.height * ((-oy + src_rect.height - 1) / src_rect.height);
 
+	int mode;
+	if (opacity.IsOpaque() && GetCopyMode(src, src_rect, src.GetOperator(nullptr, blend_mode), mode)) {
+		Rect rect = dst_rect;
+		rect.Adjust(GetClipRect());
+
+		const uint32_t alpha_mask = 0xFFu << pixel_format.a.shift;
+
+		for (int row = rect.y; row < rect.y + rect.height; ++row) {
+			const int sy = src_rect.y + (oy + row - dst_rect.y) % src_rect.height;
+			auto* src_row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src.pixels()) + sy * src.pitch());
+			auto* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + row * pitch());
+
+			// Copies the row in spans that end at the right edge of the tile
+			int sx = (ox + rect.x - dst_rect.x) % src_rect.width;
+			for (int col = rect.x; col < rect.x + rect.width;) {
+				const int n = std::min(src_rect.width - sx, rect.x + rect.width - col);
+				CopyPixels(dst_px + col, src_row + src_rect.x + sx, n, static_cast<CopyMode>(mode), alpha_mask);
+				col += n;
+				sx = 0;
+			}
+		}
+		return;
+	}
+
 	auto src_bm = GetSubimage(src, src_rect);
 
 	pixman_image_set_repeat(src_bm.get(), PIXMAN_REPEAT_NORMAL);
@@ -674,6 +1184,7 @@ void Bitmap::StretchBlit(Bitmap const&  src, Rect const& src_rect, Opacity const
 }
 
 void Bitmap::StretchBlit(Rect const& dst_rect, Bitmap const& src, Rect const& src_rect, Opacity const& opacity, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -683,6 +1194,15 @@ void Bitmap::StretchBlit(Rect const& dst_rect, Bitmap const& src, Rect const& sr
 
 	Transform xform = Transform::Scale(zoom_x, zoom_y);
 
+	if (!pixman_affine_blit && !dst_rect.IsEmpty()) {
+		// CreateMask never returns nullptr for a mask that is not opaque
+		const auto op = opacity.IsOpaque() || blend_mode != BlendMode::Default ? src.GetOperator(nullptr, blend_mode) : PIXMAN_OP_OVER;
+		if (AffineBlitDirect(src, src.GetRect(), xform, opacity, src_rect, op,
+				src_rect.x / zoom_x, src_rect.y / zoom_y, 0, 0, dst_rect)) {
+			return;
+		}
+	}
+
 	pixman_image_set_transform(src.bitmap.get(), &xform.matrix);
 
 	auto mask = CreateMask(opacity, src_rect, &xform);
@@ -698,41 +1218,170 @@ void Bitmap::StretchBlit(Rect const& dst_rect, Bitmap const& src, Rect const& sr
 }
 
 void Bitmap::WaverBlit(int x, int y, double zoom_x, double zoom_y, Bitmap const& src, Rect const& src_rect, int depth, double phase, Opacity const& opacity, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
 
 	Transform xform = Transform::Scale(1.0 / zoom_x, 1.0 / zoom_y);
 
-	pixman_image_set_transform(src.bitmap.get(), &xform.matrix);
-
-	auto mask = CreateMask(opacity, src_rect, &xform);
-
 	int height = static_cast<int>(std::floor(src_rect.height * zoom_y));
 	int width  = static_cast<int>(std::floor(src_rect.width * zoom_x));
 	const auto xoff = src_rect.x * zoom_x;
 	const auto yoff = src_rect.y * zoom_y;
 	const auto yclip = y < 0 ? -y : 0;
 	const auto yend = std::min(height, this->height() - y);
+	if (yclip >= yend) {
+		return;
+	}
+
+	// Horizontal displacement of every row
+	std::vector<int> offsets(yend - yclip);
 	for (int i = yclip; i < yend; i++) {
-		int dy = y + i;
 		// RPG_RT starts the effect from the top of the screen even if the image is clipped. The result
 		// is that moving images which cross the top of the screen can appear to go too fast or too slow
 		// in RPT_RT. The (i - yclip) is RPG_RT compatible behavior. Just (i) would be more correct.
 		const double sy = (i - yclip) * (2 * M_PI) / (32.0 * zoom_y);
-		const int offset = 2 * zoom_x * depth * std::sin(phase + sy);
+		offsets[i - yclip] = 2 * zoom_x * depth * std::sin(phase + sy);
+	}
+
+	if (!pixman_affine_blit && width > 0) {
+		// CreateMask never returns nullptr for a mask that is not opaque
+		const auto op = opacity.IsOpaque() || blend_mode != BlendMode::Default ? src.GetOperator(nullptr, blend_mode) : PIXMAN_OP_OVER;
+		if (WaverBlitDirect(x, y, xform, src, src_rect, xoff, yoff, yclip, offsets, width, opacity, op)) {
+			return;
+		}
+	}
+
+	pixman_image_set_transform(src.bitmap.get(), &xform.matrix);
 
+	auto mask = CreateMask(opacity, src_rect, &xform);
+
+	for (int i = yclip; i < yend; i++) {
+		int dy = y + i;
 		pixman_image_composite32(src.GetOperator(mask.get(), blend_mode),
 								 src.bitmap.get(), mask.get(), bitmap.get(),
 								 xoff, yoff + i,
 								 0, i,
-								 x + offset, dy,
+								 x + offsets[i - yclip], dy,
 								 width, 1);
 	}
 
 	pixman_image_set_transform(src.bitmap.get(), nullptr);
 }
 
+bool Bitmap::WaverBlitDirect(int x, int y, Transform const& xform, Bitmap const& src, Rect const& src_rect,
+		double xoff, double yoff, int yclip, std::vector<int> const& offsets, int width,
+		Opacity const& opacity, pixman_op_t op) {
+	if (!IsDirectSource(src)) {
+		return false;
+	}
+
+	if (op != PIXMAN_OP_OVER && !(op == PIXMAN_OP_SRC && opacity.IsOpaque())) {
+		return false;
+	}
+
+	const int a_shift = pixel_format.a.shift;
+	const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+	const bool src_opaque = alpha_mask != 0 || src.GetImageOpacity() == ImageOpacity::Opaque;
+	const bool src_1bit = src.GetImageOpacity() == ImageOpacity::Alpha_1Bit;
+
+	// Arguments of the pixman composite of a row, see WaverBlit
+	const int src_x = xoff;
+
+	// The scale has no rotation, so the sampled columns are the same for every row
+	const AffineScanline col_pos(xform, src_x, 0);
+	int first = 0;
+	int last = width;
+	ClipSpan(col_pos.x, col_pos.ux, static_cast<int64_t>(src.width()) << 16, first, last);
+
+	std::vector<int> cols(width);
+	for (int j = first; j < last; ++j) {
+		cols[j] = static_cast<int>((col_pos.x + j * col_pos.ux) >> 16);
+	}
+	const bool unscaled = col_pos.ux == pixman_fixed_1;
+
+	// Mask values of CreateMask, the split mask also limits the columns
+	const bool split = opacity.IsSplit();
+	const uint32_t top = opacity.IsOpaque() ? 255 : (opacity.top & 0xFF);
+	const uint32_t bottom = split ? (opacity.bottom & 0xFF) : top;
+	const Transform mask_xform = split ? CreateMaskTransform(opacity, src_rect, &xform) : xform;
+	if (split) {
+		const AffineScanline mask_pos(mask_xform, 0, 0);
+		ClipSpan(mask_pos.x, mask_pos.ux, 1 << 16, first, last);
+	}
+
+	const Rect clip = GetClipRect();
+	const int64_t y_limit = static_cast<int64_t>(src.height()) << 16;
+
+	for (int i = yclip; i < yclip + static_cast<int>(offsets.size()); ++i) {
+		const int dy = y + i;
+		if (dy < clip.y || dy >= clip.y + clip.height) {
+			continue;
+		}
+
+		const int dx = x + offsets[i - yclip];
+		auto* dst_row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + dy * pitch());
+
+		// Drawn columns of the row: The destination clip and the sampled columns
+		const int clip_first = std::max(0, clip.x - dx);
+		const int clip_last = std::min(width, clip.x + clip.width - dx);
+		if (clip_first >= clip_last) {
+			continue;
+		}
+
+		uint32_t mask_value = top;
+		const AffineScanline row_pos(xform, src_x, static_cast<int>(yoff + i));
+		if (row_pos.y < 0 || row_pos.y >= y_limit) {
+			mask_value = 0;
+		} else if (split) {
+			const AffineScanline mask_pos(mask_xform, 0, i);
+			if (mask_pos.y < 0 || mask_pos.y >= (2 << 16)) {
+				mask_value = 0;
+			} else if (mask_pos.y >= (1 << 16)) {
+				mask_value = bottom;
+			}
+		}
+
+		const int row_first = std::min(std::max(first, clip_first), clip_last);
+		const int row_last = std::max(row_first, std::min(last, clip_last));
+
+		if (op == PIXMAN_OP_SRC) {
+			// Pixels outside of the source are transparent
+			const int fill_first = mask_value != 0 ? row_first : clip_last;
+			std::fill(dst_row + dx + clip_first, dst_row + dx + fill_first, 0);
+			std::fill(dst_row + dx + std::max(fill_first, row_last), dst_row + dx + clip_last, 0);
+		}
+
+		if (mask_value == 0 || row_first >= row_last) {
+			continue;
+		}
+
+		auto* src_row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src.pixels()) + (row_pos.y >> 16) * src.pitch());
+		auto* dst_px = dst_row + dx + row_first;
+		const int count = row_last - row_first;
+
+		AffineMode mode = AffineMode::Over;
+		if (op == PIXMAN_OP_SRC || (mask_value == 255 && src_opaque)) {
+			mode = AffineMode::Copy;
+		} else if (mask_value == 255 && src_1bit) {
+			mode = AffineMode::CopyMasked;
+		}
+
+		if (unscaled && mode != AffineMode::Over) {
+			// Whole rows are copied
+			const auto copy_mode = mode == AffineMode::CopyMasked ? CopyMode::CopyMasked :
+				(alpha_mask != 0 ? CopyMode::CopyOpaque : CopyMode::Copy);
+			CopyPixels(dst_px, src_row + cols[row_first], count, copy_mode, 0xFFu << a_shift);
+			continue;
+		}
+
+		ResampleRow(dst_px, src_row, cols.data() + row_first, count, mode, alpha_mask, mask_value, a_shift);
+	}
+
+	return true;
+}
+
 static pixman_color_t PixmanColor(const Color &color) {
 	pixman_color_t pcolor;
 	pcolor.red = color.red * color.alpha;
@@ -743,6 +1392,7 @@ static pixman_color_t PixmanColor(const Color &color) {
 }
 
 void Bitmap::Fill(const Color &color) {
+	++revision;
 	pixman_color_t pcolor = PixmanColor(color);
 
 	pixman_box32_t box = { 0, 0, width(), height() };
@@ -751,6 +1401,7 @@ void Bitmap::Fill(const Color &color) {
 }
 
 void Bitmap::FillRect(Rect const& dst_rect, const Color &color) {
+	++revision;
 	pixman_color_t pcolor = PixmanColor(color);
 
 	auto timage = PixmanImagePtr{pixman_image_create_solid_fill(&pcolor)};
@@ -764,15 +1415,22 @@ void Bitmap::FillRect(Rect const& dst_rect, const Color &color) {
 }
 
 void Bitmap::Clear() {
+	++revision;
 	if (!pixels()) {
 		// Happens when height or width of bitmap are 0
 		return;
 	}
 
+	if (!clip_rect.IsEmpty()) {
+		ClearRect(clip_rect);
+		return;
+	}
+
 	memset(pixels(), '\0', height() * pitch());
 }
 
 void Bitmap::ClearRect(Rect const& dst_rect) {
+	++revision;
 	pixman_color_t pcolor = {};
 	pixman_box32_t box = {
 		dst_rect.x,
@@ -787,70 +1445,76 @@ void Bitmap::ClearRect(Rect const& dst_rect) {
 	pixman_image_fill_boxes(PIXMAN_OP_CLEAR, bitmap.get(), &pcolor, 1, &box);
 }
 
-// Hard light lookup table mapping source color to destination color
-// FIXME: Replace this with std::array<std::array<uint8_t,256>,256> when we have C++17
-struct HardLightTable {
-	uint8_t table[256][256] = {};
-};
-
-static constexpr HardLightTable make_hard_light_lookup() {
-	HardLightTable hl;
-	for (int i = 0; i < 256; ++i) {
-		for (int j = 0; j < 256; ++j) {
-			int res = 0;
-			if (i <= 128)
-				res = (2 * i * j) / 255;
-			else
-				res = 255 - 2 * (255 - i) * (255 - j) / 255;
-			hl.table[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
-		}
+void Bitmap::FlashFill(const Color &color, Rect const& keep_rect) {
+	++revision;
+	const Rect clip = GetClipRect();
+	Rect keep = keep_rect;
+	keep.Adjust(clip);
+
+	if (color.alpha == 0 && keep == clip) {
+		return;
 	}
-	return hl;
-}
 
-constexpr auto hard_light = make_hard_light_lookup();
+	if (format.bits != 32 || format.alpha_type != PF::Alpha) {
+		if (color.alpha > 0) {
+			FillRect(clip, color);
+		}
+		if (keep.IsEmpty()) {
+			ClearRect(clip);
+			return;
+		}
+		ClearRect({clip.x, clip.y, clip.width, keep.y - clip.y});
+		ClearRect({clip.x, keep.y + keep.height, clip.width, clip.y + clip.height - keep.y - keep.height});
+		ClearRect({clip.x, keep.y, keep.x - clip.x, keep.height});
+		ClearRect({keep.x + keep.width, keep.y, clip.x + clip.width - keep.x - keep.width, keep.height});
+		return;
+	}
 
+	// One table per channel: OVER of the premultiplied color (pixman converts
+	// the 16 bit color of Fill by dropping the low byte) with every channel value
+	const int shifts[4] = { format.r.shift, format.g.shift, format.b.shift, format.a.shift };
+	const uint32_t ia = 255 - color.alpha;
+	const uint32_t premultiplied[4] = {
+		static_cast<uint32_t>(color.red * color.alpha) >> 8,
+		static_cast<uint32_t>(color.green * color.alpha) >> 8,
+		static_cast<uint32_t>(color.blue * color.alpha) >> 8,
+		static_cast<uint32_t>(color.alpha)
+	};
 
-// Saturation Tone Inline: Changes a pixel saturation
-static inline void saturation_tone(uint32_t &src_pixel, const int saturation, const int rs, const int gs, const int bs, const int as) {
-	// Algorithm from OpenPDN (MIT license)
-	// Transformation in Y'CbCr color space
-	uint8_t r = (src_pixel >> rs) & 0xFF;
-	uint8_t g = (src_pixel >> gs) & 0xFF;
-	uint8_t b = (src_pixel >> bs) & 0xFF;
-	uint8_t a = (src_pixel >> as) & 0xFF;
+	std::array<std::array<uint8_t, 256>, 4> lut;
+	for (int c = 0; c < 4; ++c) {
+		for (uint32_t v = 0; v < 256; ++v) {
+			lut[c][v] = static_cast<uint8_t>(std::min<uint32_t>(premultiplied[c] + PixelOps::MulUn8(v, ia), 255));
+		}
+	}
 
-	// Y' = 0.299 R' + 0.587 G' + 0.114 B'
-	uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
+	for (int y = clip.y; y < clip.y + clip.height; ++y) {
+		uint32_t* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + y * pitch());
 
-	// Scale Cb/Cr by scale factor "sat"
-	int red = ((lum * 1024 + (r - lum) * saturation) >> 10);
-	red = red > 255 ? 255 : red < 0 ? 0 : red;
-	int green = ((lum * 1024 + (g - lum) * saturation) >> 10);
-	green = green > 255 ? 255 : green < 0 ? 0 : green;
-	int blue = ((lum * 1024 + (b - lum) * saturation) >> 10);
-	blue = blue > 255 ? 255 : blue < 0 ? 0 : blue;
+		if (keep.IsEmpty() || y < keep.y || y >= keep.y + keep.height) {
+			std::memset(dst_px + clip.x, 0, clip.width * sizeof(uint32_t));
+			continue;
+		}
 
-	src_pixel = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
-}
+		std::memset(dst_px + clip.x, 0, (keep.x - clip.x) * sizeof(uint32_t));
+		std::memset(dst_px + keep.x + keep.width, 0, (clip.x + clip.width - keep.x - keep.width) * sizeof(uint32_t));
 
-// Color Tone Inline: Changes color of a pixel by hard light table
-static inline void color_tone(uint32_t &src_pixel, const Tone& tone, const int rs, const int gs, const int bs, const int as) {
-	src_pixel = ((uint32_t)hard_light.table[tone.red][(src_pixel >> rs) & 0xFF] << rs)
-		| ((uint32_t)hard_light.table[tone.green][(src_pixel >> gs) & 0xFF] << gs)
-		| ((uint32_t)hard_light.table[tone.blue][(src_pixel >> bs) & 0xFF] << bs)
-		| ((uint32_t)((src_pixel >> as) & 0xFF) << as);
-}
+		if (color.alpha == 0) {
+			continue;
+		}
 
-static inline void color_tone_alpha(uint32_t &src_pixel, const Tone& tone, const int rs, const int gs, const int bs, const int as) {
-	uint8_t a = (src_pixel >> as) & 0xFF;
-	uint8_t r = ((uint32_t)hard_light.table[tone.red][(src_pixel >> rs) & 0xFF]) * a / 255;
-	uint8_t g = ((uint32_t)hard_light.table[tone.green][(src_pixel >> gs) & 0xFF]) * a / 255;
-	uint8_t b = ((uint32_t)hard_light.table[tone.blue][(src_pixel >> bs) & 0xFF]) * a / 255;
-	src_pixel = ((uint32_t)r << rs) | ((uint32_t)g << gs) | ((uint32_t)b << bs) | ((uint32_t)a << as);
+		for (int x = keep.x; x < keep.x + keep.width; ++x) {
+			const uint32_t px = dst_px[x];
+			dst_px[x] = ((uint32_t) lut[0][(px >> shifts[0]) & 0xFF] << shifts[0]) |
+				((uint32_t) lut[1][(px >> shifts[1]) & 0xFF] << shifts[1]) |
+				((uint32_t) lut[2][(px >> shifts[2]) & 0xFF] << shifts[2]) |
+				((uint32_t) lut[3][(px >> shifts[3]) & 0xFF] << shifts[3]);
+		}
+	}
 }
 
 void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Tone &tone, Opacity const& opacity) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -888,124 +1552,27 @@ void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, con
 		src_rect.width, src_rect.height);
 	}
 
-	const int as = pixel_format.a.shift;
-	const int rs = pixel_format.r.shift;
-	const int gs = pixel_format.g.shift;
-	const int bs = pixel_format.b.shift;
-	int next_row = pitch() / sizeof(uint32_t);
-	uint32_t* pixels = (uint32_t*)this->pixels();
-	pixels = pixels + (y - 1) * next_row + x;
-
-	const uint16_t limit_height = std::min<uint16_t>(src_rect.height, height());
-	const uint16_t limit_width = std::min<uint16_t>(src_rect.width, width());
-
-	const bool apply_sat = tone.gray != 128;
-	const bool apply_tone = (tone.red != 128 || tone.green != 128 || tone.blue != 128);
-
-	// If Saturation + Color:
-	if (apply_sat && apply_tone) {
-		int sat = tone.gray > 128 ? 1024 + (tone.gray - 128) * 16 : tone.gray * 8;
+	BitmapTone::Layout layout;
+	layout.r_shift = pixel_format.r.shift;
+	layout.g_shift = pixel_format.g.shift;
+	layout.b_shift = pixel_format.b.shift;
+	layout.a_shift = pixel_format.a.shift;
 
-		if (src_opacity == ImageOpacity::Opaque) {
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					saturation_tone(pixels[j], sat, rs, gs, bs, as);
-					color_tone(pixels[j], tone, rs, gs, bs, as);
-				}
-			}
-		} else if (src_opacity == ImageOpacity::Alpha_1Bit) {
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					uint8_t a = (uint8_t)((pixels[j] >> as) & 0xFF);
-					if (a == 0)
-						continue;
-
-					saturation_tone(pixels[j], sat, rs, gs, bs, as);
-					color_tone(pixels[j], tone, rs, gs, bs, as);
-				}
-			}
-		} else { // 8 Bit Alpha
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					uint8_t a = (uint8_t)((pixels[j] >> as) & 0xFF);
-					if (a == 0) {
-						continue;
-					}
-
-					saturation_tone(pixels[j], sat, rs, gs, bs, as);
-					color_tone_alpha(pixels[j], tone, rs, gs, bs, as);
-				}
-			}
-		}
+	// Views only change the pixels inside of their clip rect
+	Rect area = { x, y, src_rect.width, src_rect.height };
+	area.Adjust(GetClipRect());
+	if (area.IsEmpty()) {
+		return;
 	}
 
-	// If Only Saturation:
-	else if (apply_sat) {
-		int sat = tone.gray > 128 ? 1024 + (tone.gray - 128) * 16 : tone.gray * 8;
-
-		if (src_opacity == ImageOpacity::Opaque) {
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					saturation_tone(pixels[j], sat, rs, gs, bs, as);
-				}
-			}
-		} else { // Any kind of alpha
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					uint8_t a = (uint8_t)((pixels[j] >> as) & 0xFF);
-					if (a == 0)
-						continue;
-
-					saturation_tone(pixels[j], sat, rs, gs, bs, as);
-				}
-			}
-		}
-	}
+	const int next_row = pitch() / sizeof(uint32_t);
+	uint32_t* pixels = (uint32_t*)this->pixels() + area.y * next_row + area.x;
 
-	// If Only Color:
-	else if (apply_tone) {
-		if (src_opacity == ImageOpacity::Opaque) {
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					color_tone(pixels[j], tone, rs, gs, bs, as);
-				}
-			}
-		} else if (src_opacity == ImageOpacity::Alpha_1Bit) {
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					uint8_t a = (uint8_t)((pixels[j] >> as) & 0xFF);
-					if (a == 0)
-						continue;
-
-					color_tone(pixels[j], tone, rs, gs, bs, as);
-				}
-			}
-		} else { // 8 Bit Alpha
-			for (uint16_t i = 0; i < limit_height; ++i) {
-				pixels += next_row;
-				for (uint16_t j = 0; j < limit_width; ++j) {
-					uint8_t a = (uint8_t)((pixels[j] >> as) & 0xFF);
-					if (a == 0)
-						continue;
-					else if (a == 255) {
-						color_tone(pixels[j], tone, rs, gs, bs, as);
-					} else {
-						color_tone_alpha(pixels[j], tone, rs, gs, bs, as);
-					}
-				}
-			}
-		}
-	}
+	BitmapTone::Apply(pixels, area.width, area.height, next_row, tone, src_opacity, layout);
 }
 
 void Bitmap::BlendBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Color& color, Opacity const& opacity) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -1036,6 +1603,7 @@ void Bitmap::BlendBlit(int x, int y, Bitmap const& src, Rect const& src_rect, co
 }
 
 void Bitmap::FlipBlit(int x, int y, Bitmap const& src, Rect const& src_rect, bool horizontal, bool vertical, Opacity const& opacity, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -1063,7 +1631,294 @@ void Bitmap::FlipBlit(int x, int y, Bitmap const& src, Rect const& src_rect, boo
 	}
 }
 
+void Bitmap::ToneBlendFlipBlit(int x, int y, Bitmap const& src, Rect const& src_rect,
+		bool flip_x, bool flip_y, const Tone& tone, const Color& color, Opacity const& opacity) {
+	++revision;
+	if (opacity.IsTransparent()) {
+		return;
+	}
+
+	const auto src_opacity = src.GetImageOpacity();
+	if (src_opacity == ImageOpacity::Transparent) {
+		return;
+	}
+
+	Rect src_bounds = src_rect;
+	src_bounds.Adjust(src.GetRect());
+
+	const bool direct = IsDirectSource(src) && src_bounds == src_rect;
+
+	if (!direct) {
+		// Unusual formats: Apply the effects on a temporary bitmap
+		auto effects = Bitmap::Create(src_rect.width, src_rect.height, true);
+		effects->ToneBlit(0, 0, src, src_rect, tone, Opacity::Opaque());
+		effects->BlendBlit(0, 0, *effects, effects->GetRect(), color, Opacity::Opaque());
+		effects->Flip(flip_x, flip_y);
+		Blit(x, y, *effects, effects->GetRect(), opacity, BlendMode::Normal);
+		return;
+	}
+
+	// Clip against the destination, the source offsets are mirrored when flipping
+	const Rect clip = GetClipRect();
+	const int x0 = std::max(x, clip.x);
+	const int x1 = std::min(x + src_rect.width, clip.x + clip.width);
+	const int y0 = std::max(y, clip.y);
+	const int y1 = std::min(y + src_rect.height, clip.y + clip.height);
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	BitmapTone::Layout layout;
+	layout.r_shift = pixel_format.r.shift;
+	layout.g_shift = pixel_format.g.shift;
+	layout.b_shift = pixel_format.b.shift;
+	layout.a_shift = pixel_format.a.shift;
+
+	const int a_shift = pixel_format.a.shift;
+	// Sources without alpha channel are read as opaque, like pixman does
+	const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+
+	const bool has_tone = tone != Tone();
+	const bool has_flash = color.alpha > 0;
+	const uint32_t flash =
+		(static_cast<uint32_t>(color.red * color.alpha >> 8) << pixel_format.r.shift) |
+		(static_cast<uint32_t>(color.green * color.alpha >> 8) << pixel_format.g.shift) |
+		(static_cast<uint32_t>(color.blue * color.alpha >> 8) << pixel_format.b.shift) |
+		(static_cast<uint32_t>(color.alpha) << a_shift);
+
+	const int src_stride = src.pitch() / sizeof(uint32_t);
+	const int dst_stride = pitch() / sizeof(uint32_t);
+	const uint32_t* src_pixels = static_cast<const uint32_t*>(src.pixels());
+	uint32_t* dst_pixels = static_cast<uint32_t*>(pixels());
+
+	// Rows are processed in chunks on the stack, no allocation is needed
+	constexpr int chunk_size = 256;
+	uint32_t buffer[chunk_size];
+
+	for (int dy = y0; dy < y1; ++dy) {
+		const int row = dy - y;
+		const bool bottom = opacity.IsSplit() && row >= src_rect.height - opacity.split;
+		const uint32_t row_opacity = Utils::Clamp(bottom ? opacity.bottom : opacity.top, 0, 255);
+		if (row_opacity == 0) {
+			continue;
+		}
+
+		const int sy = flip_y ? src_rect.y + src_rect.height - 1 - row : src_rect.y + row;
+		const uint32_t* src_row = src_pixels + sy * src_stride;
+		uint32_t* dst_row = dst_pixels + dy * dst_stride;
+
+		for (int cx = x0; cx < x1; cx += chunk_size) {
+			const int n = std::min(chunk_size, x1 - cx);
+			const int col = cx - x;
+
+			if (flip_x) {
+				const uint32_t* src_px = src_row + src_rect.x + src_rect.width - 1 - col;
+				for (int i = 0; i < n; ++i) {
+					buffer[i] = src_px[-i] | alpha_mask;
+				}
+			} else {
+				const uint32_t* src_px = src_row + src_rect.x + col;
+				for (int i = 0; i < n; ++i) {
+					buffer[i] = src_px[i] | alpha_mask;
+				}
+			}
+
+			if (has_tone) {
+				BitmapTone::Apply(buffer, n, 1, n, tone, src_opacity, layout);
+			}
+
+			if (has_flash) {
+				// Flash color masked by the pixel alpha, see BlendBlit
+				for (int i = 0; i < n; ++i) {
+					const uint32_t m = (buffer[i] >> a_shift) & 0xFF;
+					if (m != 0) {
+						buffer[i] = PixelOps::OverMask(flash, buffer[i], m, a_shift);
+					}
+				}
+			}
+
+			uint32_t* dst_px = dst_row + cx;
+			for (int i = 0; i < n; ++i) {
+				dst_px[i] = PixelOps::OverMask(buffer[i], dst_px[i], row_opacity, a_shift);
+			}
+		}
+	}
+}
+
+bool Bitmap::IsDirectSource(Bitmap const& src) const {
+	auto same_layout = [](const DynamicFormat& lhs, const DynamicFormat& rhs) {
+		return lhs.bits == 32 && rhs.bits == 32 &&
+			lhs.r.shift == rhs.r.shift && lhs.g.shift == rhs.g.shift && lhs.b.shift == rhs.b.shift;
+	};
+
+	return &src != this &&
+		pixel_format.alpha_type == PF::Alpha &&
+		format.code_alpha() == pixel_format.code_alpha() &&
+		same_layout(src.format, pixel_format);
+}
+
+void Bitmap::CrossFadeBlit(Bitmap const& src1, Bitmap const& src2, int opacity) {
+	++revision;
+	if (!IsDirectSource(src1) || !IsDirectSource(src2)) {
+		Blit(0, 0, src1, src1.GetRect(), Opacity::Opaque());
+		Blit(0, 0, src2, src2.GetRect(), opacity);
+		return;
+	}
+
+	const Rect clip = GetClipRect();
+	const int x0 = clip.x;
+	const int x1 = std::min({ clip.x + clip.width, src1.width(), src2.width() });
+	const int y0 = clip.y;
+	const int y1 = std::min({ clip.y + clip.height, src1.height(), src2.height() });
+
+	const int a_shift = pixel_format.a.shift;
+	const uint32_t alpha_mask1 = src1.GetTransparent() ? 0 : (0xFFu << a_shift);
+	const uint32_t alpha_mask2 = src2.GetTransparent() ? 0 : (0xFFu << a_shift);
+	const uint32_t a = Utils::Clamp(opacity, 0, 255);
+
+	for (int y = y0; y < y1; ++y) {
+		const uint32_t* src1_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src1.pixels()) + y * src1.pitch());
+		const uint32_t* src2_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src2.pixels()) + y * src2.pitch());
+		uint32_t* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + y * pitch());
+
+		if (alpha_mask1 != 0 && alpha_mask2 != 0) {
+			// Both screens are opaque, this is a linear interpolation
+			for (int x = x0; x < x1; ++x) {
+				dst_px[x] = PixelOps::AddUn8x4(PixelOps::MulUn8x4(src2_px[x] | alpha_mask2, a),
+					PixelOps::MulUn8x4(src1_px[x] | alpha_mask1, 255 - a));
+			}
+			continue;
+		}
+
+		for (int x = x0; x < x1; ++x) {
+			const uint32_t bottom = PixelOps::Over(src1_px[x] | alpha_mask1, dst_px[x], a_shift);
+			dst_px[x] = a == 0 ? bottom : PixelOps::OverMask(src2_px[x] | alpha_mask2, bottom, a, a_shift);
+		}
+	}
+}
+
+void Bitmap::StripeBlit(Bitmap const& src1, Bitmap const& src2, const uint8_t* lines, bool columns) {
+	++revision;
+	const Rect clip = GetClipRect();
+	const int x0 = clip.x;
+	const int x1 = std::min({ clip.x + clip.width, src1.width(), src2.width() });
+	const int y0 = clip.y;
+	const int y1 = std::min({ clip.y + clip.height, src1.height(), src2.height() });
+
+	if (!IsDirectSource(src1) || !IsDirectSource(src2)) {
+		// One blit for every run of lines from the same source
+		const int begin = columns ? x0 : y0;
+		const int end = columns ? x1 : y1;
+		for (int i = begin; i < end;) {
+			int j = i + 1;
+			while (j < end && lines[j] == lines[i]) {
+				++j;
+			}
+			if (lines[i] != 0) {
+				auto& src = lines[i] == 1 ? src1 : src2;
+				const Rect rect = columns ? Rect(i, y0, j - i, y1 - y0) : Rect(x0, i, x1 - x0, j - i);
+				Blit(rect.x, rect.y, src, rect, Opacity::Opaque());
+			}
+			i = j;
+		}
+		return;
+	}
+
+	const int a_shift = pixel_format.a.shift;
+	const Bitmap* sources[] = { nullptr, &src1, &src2 };
+	const uint32_t alpha_masks[] = {
+		0,
+		src1.GetTransparent() ? 0 : (0xFFu << a_shift),
+		src2.GetTransparent() ? 0 : (0xFFu << a_shift)
+	};
+
+	for (int y = y0; y < y1; ++y) {
+		uint32_t* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + y * pitch());
+
+		// Copies or composites a part of a row of the source
+		auto draw = [&](int line, int from, int to) {
+			const uint32_t* src_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(sources[line]->pixels()) + y * sources[line]->pitch());
+			if (alpha_masks[line] != 0) {
+				for (int x = from; x < to; ++x) {
+					dst_px[x] = src_px[x] | alpha_masks[line];
+				}
+			} else {
+				for (int x = from; x < to; ++x) {
+					dst_px[x] = PixelOps::Over(src_px[x], dst_px[x], a_shift);
+				}
+			}
+		};
+
+		if (!columns) {
+			if (lines[y] != 0) {
+				draw(lines[y], x0, x1);
+			}
+			continue;
+		}
+
+		for (int x = x0; x < x1;) {
+			int end = x + 1;
+			while (end < x1 && lines[end] == lines[x]) {
+				++end;
+			}
+			if (lines[x] != 0) {
+				draw(lines[x], x, end);
+			}
+			x = end;
+		}
+	}
+}
+
+void Bitmap::RemapBlit(Bitmap const& src, const int* src_x, const int* src_y) {
+	++revision;
+	const Rect clip = GetClipRect();
+	const int x0 = clip.x;
+	const int x1 = clip.x + clip.width;
+	const int y0 = clip.y;
+	const int y1 = clip.y + clip.height;
+
+	if (!IsDirectSource(src)) {
+		// One blit of a single stretched pixel for every block with the same source pixel
+		for (int y = y0; y < y1;) {
+			int y_end = y + 1;
+			while (y_end < y1 && src_y[y_end] == src_y[y]) {
+				++y_end;
+			}
+			for (int x = x0; x < x1;) {
+				int x_end = x + 1;
+				while (x_end < x1 && src_x[x_end] == src_x[x]) {
+					++x_end;
+				}
+				StretchBlit(Rect(x, y, x_end - x, y_end - y), src, Rect(src_x[x], src_y[y], 1, 1), Opacity::Opaque());
+				x = x_end;
+			}
+			y = y_end;
+		}
+		return;
+	}
+
+	const int a_shift = pixel_format.a.shift;
+	const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+
+	for (int y = y0; y < y1; ++y) {
+		const uint32_t* src_px = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src.pixels()) + src_y[y] * src.pitch());
+		uint32_t* dst_px = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels()) + y * pitch());
+
+		if (alpha_mask != 0 && y > y0 && src_y[y] == src_y[y - 1]) {
+			// Same source row as the row above
+			std::memcpy(dst_px + x0, reinterpret_cast<uint8_t*>(dst_px) - pitch() + x0 * sizeof(uint32_t), (x1 - x0) * sizeof(uint32_t));
+			continue;
+		}
+
+		for (int x = x0; x < x1; ++x) {
+			const uint32_t px = src_px[src_x[x]] | alpha_mask;
+			dst_px[x] = alpha_mask != 0 ? px : PixelOps::Over(px, dst_px[x], a_shift);
+		}
+	}
+}
+
 void Bitmap::Flip(bool horizontal, bool vertical) {
+	++revision;
 	if (!horizontal && !vertical) {
 		return;
 	}
@@ -1088,6 +1943,7 @@ void Bitmap::Flip(bool horizontal, bool vertical) {
 }
 
 void Bitmap::MaskedBlit(Rect const& dst_rect, Bitmap const& mask, int mx, int my, Color const& color) {
+	++revision;
 	pixman_color_t tcolor = {
 		static_cast<uint16_t>(color.red << 8),
 		static_cast<uint16_t>(color.green << 8),
@@ -1105,6 +1961,7 @@ void Bitmap::MaskedBlit(Rect const& dst_rect, Bitmap const& mask, int mx, int my
 }
 
 void Bitmap::MaskedBlit(Rect const& dst_rect, Bitmap const& mask, int mx, int my, Bitmap const& src, int sx, int sy) {
+	++revision;
 	pixman_image_composite32(PIXMAN_OP_OVER,
 							 src.bitmap.get(), mask.bitmap.get(), bitmap.get(),
 							 sx, sy,
@@ -1114,6 +1971,7 @@ void Bitmap::MaskedBlit(Rect const& dst_rect, Bitmap const& mask, int mx, int my
 }
 
 void Bitmap::Blit2x(Rect const& dst_rect, Bitmap const& src, Rect const& src_rect) {
+	++revision;
 	Transform xform = Transform::Scale(0.5, 0.5);
 
 	pixman_image_set_transform(src.bitmap.get(), &xform.matrix);
@@ -1133,6 +1991,7 @@ void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
 						 Opacity const& opacity,
 						 double zoom_x, double zoom_y, double angle,
 						 int waver_depth, double waver_phase, Bitmap::BlendMode blend_mode) {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -1156,10 +2015,62 @@ void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
 	}
 }
 
+Rect Bitmap::GetEffectsBlitRect(int x, int y, int ox, int oy, Rect const& src_rect,
+		double zoom_x, double zoom_y, double angle, int waver_depth) {
+	// Same order of precedence as EffectsBlit
+	if (waver_depth != 0) {
+		const int dst_x = x - ox * zoom_x;
+		const int dst_y = y - oy * zoom_y;
+		const int amplitude = static_cast<int>(std::floor(2 * std::abs(zoom_x * waver_depth)));
+		return Rect(dst_x - amplitude, dst_y,
+			static_cast<int>(std::floor(src_rect.width * zoom_x)) + 2 * amplitude,
+			static_cast<int>(std::floor(src_rect.height * zoom_y)));
+	}
+
+	if (angle != 0.0) {
+		// Calculated with doubles, pixman_transform_bounds is limited to 16 bit coordinates
+		const double c = std::cos(angle);
+		const double s = std::sin(angle);
+		double min_x = std::numeric_limits<double>::max();
+		double min_y = min_x;
+		double max_x = std::numeric_limits<double>::lowest();
+		double max_y = max_x;
+
+		for (int corner = 0; corner < 4; ++corner) {
+			const double px = ((corner & 1) ? src_rect.width - ox : -ox) * zoom_x;
+			const double py = ((corner & 2) ? src_rect.height - oy : -oy) * zoom_y;
+			const double dx = x + c * px - s * py;
+			const double dy = y + s * px + c * py;
+			min_x = std::min(min_x, dx);
+			min_y = std::min(min_y, dy);
+			max_x = std::max(max_x, dx);
+			max_y = std::max(max_y, dy);
+		}
+
+		// One pixel margin for the fixed point rounding of pixman
+		const int x1 = static_cast<int>(std::floor(min_x)) - 1;
+		const int y1 = static_cast<int>(std::floor(min_y)) - 1;
+		const int x2 = static_cast<int>(std::ceil(max_x)) + 1;
+		const int y2 = static_cast<int>(std::ceil(max_y)) + 1;
+		return Rect(x1, y1, x2 - x1, y2 - y1);
+	}
+
+	if (zoom_x != 1.0 || zoom_y != 1.0) {
+		return Rect(
+			x - static_cast<int>(std::floor(ox * zoom_x)),
+			y - static_cast<int>(std::floor(oy * zoom_y)),
+			static_cast<int>(std::floor(src_rect.width * zoom_x)),
+			static_cast<int>(std::floor(src_rect.height * zoom_y)));
+	}
+
+	return Rect(x - ox, y - oy, src_rect.width, src_rect.height);
+}
+
 void Bitmap::RotateZoomOpacityBlit(int x, int y, int ox, int oy,
 		Bitmap const& src, Rect const& src_rect,
 		double angle, double zoom_x, double zoom_y, Opacity const& opacity, Bitmap::BlendMode blend_mode)
 {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -1180,6 +2091,14 @@ void Bitmap::RotateZoomOpacityBlit(int x, int y, int ox, int oy,
 
 	auto inv = fwd.Inverse();
 
+	// OP_SRC draws a black rectangle around the rotated image making this operator unusable here
+	blend_mode = (blend_mode == BlendMode::Default ? BlendMode::Normal : blend_mode);
+
+	if (!pixman_affine_blit && AffineBlitDirect(src, src_rect, inv, opacity, src_rect, GetOperator(nullptr, blend_mode),
+			dst_rect.x, dst_rect.y, dst_rect.x, dst_rect.y, dst_rect)) {
+		return;
+	}
+
 	PixmanImagePtr temp;
 	if (src_rect != src.GetRect()) {
 		temp = GetSubimage(src, src_rect);
@@ -1190,8 +2109,6 @@ void Bitmap::RotateZoomOpacityBlit(int x, int y, int ox, int oy,
 
 	auto mask = CreateMask(opacity, src_rect, &inv);
 
-	// OP_SRC draws a black rectangle around the rotated image making this operator unusable here
-	blend_mode = (blend_mode == BlendMode::Default ? BlendMode::Normal : blend_mode);
 	pixman_image_composite32(GetOperator(mask.get(), blend_mode),
 							 src_img, mask.get(), bitmap.get(),
 							 dst_rect.x, dst_rect.y,
@@ -1207,6 +2124,7 @@ void Bitmap::ZoomOpacityBlit(int x, int y, int ox, int oy,
 							 double zoom_x, double zoom_y,
 							 Opacity const& opacity, Bitmap::BlendMode blend_mode)
 {
+	++revision;
 	if (opacity.IsTransparent()) {
 		return;
 	}
@@ -1265,6 +2183,7 @@ pixman_op_t Bitmap::GetOperator(pixman_image_t* mask, Bitmap::BlendMode blend_mo
 }
 
 void Bitmap::EdgeMirrorBlit(int x, int y, Bitmap const& src, Rect const& src_rect, bool mirror_x, bool mirror_y, Opacity const& opacity) {
+	++revision;
 	if (opacity.IsTransparent())
 		return;
 
@@ -1300,3 +2219,122 @@ void Bitmap::EdgeMirrorBlit(int x, int y, Bitmap const& src, Rect const& src_rec
 	}
 }
 
+void Bitmap::ParticleBlit(int ox, int oy, Rect const& wrap_rect, Bitmap const& src, Rect const& src_rect,
+		const int16_t* x, const int16_t* y, const uint8_t* opacity, int count) {
+	++revision;
+	if (count <= 0 || src_rect.IsEmpty() || src.GetImageOpacity() == ImageOpacity::Transparent) {
+		return;
+	}
+
+	Rect src_bounds = src_rect;
+	src_bounds.Adjust(src.GetRect());
+
+	const bool direct = IsDirectSource(src) && src_bounds == src_rect;
+
+	const Rect clip = GetClipRect();
+	const int clip_x1 = clip.x + clip.width;
+	const int clip_y1 = clip.y + clip.height;
+
+	const int a_shift = pixel_format.a.shift;
+	// Sources without alpha channel are read as opaque, like pixman does
+	const uint32_t alpha_mask = src.GetTransparent() ? 0 : (0xFFu << a_shift);
+	const int src_stride = src.pitch() / sizeof(uint32_t);
+	const int dst_stride = pitch() / sizeof(uint32_t);
+	const uint32_t* src_pixels = static_cast<const uint32_t*>(src.pixels());
+	uint32_t* dst_pixels = static_cast<uint32_t*>(pixels());
+
+	// Draws the part (sx, sy, w, h) of src_rect at dx, dy
+	auto draw = [&](int dx, int dy, int sx, int sy, int w, int h, uint32_t a) {
+		if (!direct) {
+			Blit(dx, dy, src, Rect(src_rect.x + sx, src_rect.y + sy, w, h), static_cast<int>(a), BlendMode::Normal);
+			return;
+		}
+
+		const int x0 = std::max(dx, clip.x);
+		const int x1 = std::min(dx + w, clip_x1);
+		const int y0 = std::max(dy, clip.y);
+		const int y1 = std::min(dy + h, clip_y1);
+
+		for (int row = y0; row < y1; ++row) {
+			const uint32_t* src_px = src_pixels + (src_rect.y + sy + row - dy) * src_stride + src_rect.x + sx - dx;
+			uint32_t* dst_px = dst_pixels + row * dst_stride;
+			for (int col = x0; col < x1; ++col) {
+				const uint32_t px = src_px[col] | alpha_mask;
+				// Skips the transparent pixels, most particles are thin lines
+				if (px != 0) {
+					dst_px[col] = PixelOps::OverMask(px, dst_px[col], a, a_shift);
+				}
+			}
+		}
+	};
+
+	const int w = src_rect.width;
+	const int h = src_rect.height;
+
+	if (wrap_rect.IsEmpty()) {
+		for (int i = 0; i < count; ++i) {
+			if (opacity[i] > 0) {
+				draw(x[i] - ox, y[i] - oy, 0, 0, w, h, opacity[i]);
+			}
+		}
+		return;
+	}
+
+	const int wrap_w = wrap_rect.width;
+	const int wrap_h = wrap_rect.height;
+	ox = (ox % wrap_w + wrap_w) % wrap_w;
+	oy = (oy % wrap_h + wrap_h) % wrap_h;
+
+	// Draws a part of the surface at every place where it is visible in the tiled output
+	auto draw_tiled = [&](int px, int py, uint32_t a) {
+		// Parts outside of the surface are not drawn
+		const int sx0 = std::max(px, 0);
+		const int sx1 = std::min(px + w, wrap_w);
+		const int sy0 = std::max(py, 0);
+		const int sy1 = std::min(py + h, wrap_h);
+		if (sx0 >= sx1 || sy0 >= sy1) {
+			return;
+		}
+
+		int tx0 = sx0 - ox;
+		while (tx0 + (sx1 - sx0) > clip.x) {
+			tx0 -= wrap_w;
+		}
+		tx0 += wrap_w;
+
+		int ty = sy0 - oy;
+		while (ty + (sy1 - sy0) > clip.y) {
+			ty -= wrap_h;
+		}
+
+		for (ty += wrap_h; ty < clip_y1; ty += wrap_h) {
+			for (int tx = tx0; tx < clip_x1; tx += wrap_w) {
+				draw(tx, ty, sx0 - px, sy0 - py, sx1 - sx0, sy1 - sy0, a);
+			}
+		}
+	};
+
+	for (int i = 0; i < count; ++i) {
+		const uint32_t a = opacity[i];
+		if (a == 0) {
+			continue;
+		}
+
+		const int px = x[i];
+		const int py = y[i];
+		const bool clone_x = px + w > wrap_w;
+		const bool clone_y = py + h > wrap_h;
+
+		draw_tiled(px, py, a);
+		if (clone_x) {
+			draw_tiled(px - wrap_w, py, a);
+		}
+		if (clone_y) {
+			draw_tiled(px, py - wrap_h, a);
+		}
+		if (clone_x && clone_y) {
+			draw_tiled(px - wrap_w, py - wrap_h, a);
+		}
+	}
+}
+
@@ -20,6 +20,7 @@
 
 // Headers
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <map>
 #include <vector>
@@ -102,6 +103,42 @@ public:
 	 */
 	static BitmapRef Create(void *pixels, int width, int height, int pitch, const DynamicFormat& format);
 
+	/**
+	 * Properties of an image that are computed from the pixels when it is
+	 * decoded (see Flags). Allows restoring a decoded image without
+	 * decoding it again.
+	 */
+	struct DecodedInfo {
+		/** Bpp of the source image */
+		int original_bpp = 0;
+		/** Whether the image was loaded with Flag_ReadOnly */
+		bool read_only = false;
+		ImageOpacity image_opacity = ImageOpacity::Alpha_8Bit;
+		/** Opacity of the tiles row by row, empty unless loaded with Flag_Chipset */
+		std::vector<ImageOpacity> tile_opacity;
+		/** Colors of a system graphic */
+		Color bg_color;
+		Color sh_color;
+	};
+
+	/** @return properties of the decoded image */
+	DecodedInfo GetDecodedInfo() const;
+
+	/**
+	 * Creates a bitmap around decoded pixels in the pixel format of the
+	 * screen, e.g. from a memory mapped file.
+	 *
+	 * @param pixels pointer to pixel data.
+	 * @param width surface width.
+	 * @param height surface height.
+	 * @param pitch surface pitch.
+	 * @param transparent whether the pixels are in pixel_format or opaque_pixel_format
+	 * @param info properties returned by GetDecodedInfo of the decoded bitmap
+	 * @param release called when the pixels are not used anymore, can be empty
+	 * @return bitmap
+	 */
+	static BitmapRef CreateDecoded(void* pixels, int width, int height, int pitch, bool transparent, const DecodedInfo& info, std::function<void()> release);
+
 	Bitmap(int width, int height, bool transparent);
 	Bitmap(Filesystem_Stream::InputStream stream, bool transparent, uint32_t flags);
 	Bitmap(const uint8_t* data, unsigned bytes, bool transparent, uint32_t flags);
@@ -357,6 +394,30 @@ public:
 	 */
 	void EdgeMirrorBlit(int x, int y, Bitmap const& src, Rect const& src_rect, bool mirror_x, bool mirror_y, Opacity const& opacity);
 
+	/**
+	 * Blits the same source rect at many positions, each with its own opacity.
+	 * All particles are clipped and composited in one pass.
+	 *
+	 * Without wrap_rect this is the same as a Blit at (x - ox, y - oy) for
+	 * every particle.
+	 * With wrap_rect the positions are relative to a surface of that size
+	 * which is tiled over this bitmap like TiledBlit does, starting at
+	 * ox and oy. Particles crossing the right or bottom edge of the surface
+	 * are cloned across the edge like EdgeMirrorBlit does.
+	 *
+	 * @param ox x offset of the particle positions.
+	 * @param oy y offset of the particle positions.
+	 * @param wrap_rect size of the tiled surface, empty rect for no wrapping.
+	 * @param src source bitmap.
+	 * @param src_rect source bitmap rect.
+	 * @param x x positions of the particles.
+	 * @param y y positions of the particles.
+	 * @param opacity opacities of the particles.
+	 * @param count number of particles.
+	 */
+	void ParticleBlit(int ox, int oy, Rect const& wrap_rect, Bitmap const& src, Rect const& src_rect,
+		const int16_t* x, const int16_t* y, const uint8_t* opacity, int count);
+
 	/**
 	 * Blits source bitmap stretched to this one.
 	 *
@@ -478,6 +539,16 @@ public:
 	 */
 	void ClearRect(Rect const& dst_rect);
 
+	/**
+	 * Composites a color over the bitmap and clears the bitmap outside of a
+	 * rect in one pass. Same result as blitting a bitmap filled with the
+	 * color and calling ClearRect for the parts outside of keep_rect.
+	 *
+	 * @param color color composited over the bitmap, skipped when alpha is 0.
+	 * @param keep_rect part of the bitmap that is not cleared.
+	 */
+	void FlashFill(const Color &color, Rect const& keep_rect);
+
 	/**
 	 * Rotates bitmap hue.
 	 *
@@ -513,6 +584,56 @@ public:
 	 */
 	void BlendBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Color &color, Opacity const& opacity);
 
+	/**
+	 * Blits source bitmap with tone, flash color and flip applied.
+	 * Produces the same result as compositing the output of ToneBlit,
+	 * BlendBlit and FlipBlit but without an intermediate bitmap.
+	 *
+	 * @param x x position.
+	 * @param y y position.
+	 * @param src source bitmap.
+	 * @param src_rect source bitmap rect.
+	 * @param flip_x flip horizontally (mirror).
+	 * @param flip_y flip vertically.
+	 * @param tone tone to apply.
+	 * @param color flash color to apply.
+	 * @param opacity opacity to apply.
+	 */
+	void ToneBlendFlipBlit(int x, int y, Bitmap const& src, Rect const& src_rect,
+		bool flip_x, bool flip_y, const Tone& tone, const Color& color, Opacity const& opacity);
+
+	/**
+	 * Blits src1 opaque and src2 with an opacity on top of it.
+	 * Same result as two Blit calls but every pixel is written once.
+	 *
+	 * @param src1 bottom bitmap.
+	 * @param src2 top bitmap.
+	 * @param opacity opacity of src2.
+	 */
+	void CrossFadeBlit(Bitmap const& src1, Bitmap const& src2, int opacity);
+
+	/**
+	 * Blits full rows or columns from one of two bitmaps.
+	 * Line i is taken from src1 when lines[i] is 1, from src2 when it is 2
+	 * and is left unchanged when it is 0. Same result as a Blit per stripe.
+	 *
+	 * @param src1 first bitmap.
+	 * @param src2 second bitmap.
+	 * @param lines source of every row or column of this bitmap.
+	 * @param columns whether lines are columns instead of rows.
+	 */
+	void StripeBlit(Bitmap const& src1, Bitmap const& src2, const uint8_t* lines, bool columns);
+
+	/**
+	 * Blits src with every pixel taken from the source position of its
+	 * column and row. Used for mosaic effects.
+	 *
+	 * @param src source bitmap.
+	 * @param src_x source x position of every column of this bitmap.
+	 * @param src_y source y position of every row of this bitmap.
+	 */
+	void RemapBlit(Bitmap const& src, const int* src_x, const int* src_y);
+
 	/**
 	 * Flips the bitmap pixels.
 	 *
@@ -588,9 +709,39 @@ public:
 		int waver_depth, double waver_phase,
 		BlendMode blend_mode = BlendMode::Default);
 
+	/**
+	 * Calculates the destination rectangle EffectsBlit draws into.
+	 * For rotations the rectangle is the bounding box of the rotated image.
+	 *
+	 * @param x destination x position.
+	 * @param y destination y position.
+	 * @param ox source origin x.
+	 * @param oy source origin y.
+	 * @param src_rect source bitmap rectangle.
+	 * @param zoom_x x scale factor.
+	 * @param zoom_y y scale factor.
+	 * @param angle rotation angle.
+	 * @param waver_depth wave magnitude.
+	 * @return the destination rectangle, it can be outside of the bitmap.
+	 */
+	static Rect GetEffectsBlitRect(int x, int y, int ox, int oy, Rect const& src_rect,
+		double zoom_x, double zoom_y, double angle, int waver_depth);
+
 	static DynamicFormat ChooseFormat(const DynamicFormat& format);
 	static void SetFormat(const DynamicFormat& format);
 
+	/**
+	 * Selects how rotated and scaled blits are drawn.
+	 * By default they are rasterized without pixman when source and
+	 * destination are 32 bit images, the result is the same.
+	 *
+	 * @param enabled whether pixman draws all rotated and scaled blits
+	 */
+	static void SetPixmanAffineBlit(bool enabled);
+
+	/** @return whether pixman draws all rotated and scaled blits */
+	static bool GetPixmanAffineBlit();
+
 	static DynamicFormat pixel_format;
 	static DynamicFormat opaque_pixel_format;
 	static DynamicFormat image_format;
@@ -609,6 +760,42 @@ public:
 	ImageOpacity ComputeImageOpacity() const;
 	ImageOpacity ComputeImageOpacity(Rect rect) const;
 
+	/**
+	 * Creates a bitmap that shares the pixel data of this bitmap.
+	 * Drawing on the view only modifies the pixels inside of the clip rect,
+	 * this allows drawing on different parts of a bitmap from several threads.
+	 *
+	 * @param clip_rect clip rect of the view
+	 * @return bitmap view
+	 */
+	BitmapRef CreateClippedView(Rect const& clip_rect);
+
+	/** @return rect drawing operations are clipped to */
+	Rect GetClipRect() const;
+
+	/**
+	 * The revision changes whenever a drawing operation modifies the bitmap
+	 * and is never shared by two bitmaps. Writes through pixels() and through
+	 * views are not counted.
+	 *
+	 * @return revision of the pixel data
+	 */
+	uint64_t GetRevision() const;
+
+	/**
+	 * pixman caches properties of an image when it is used the first time
+	 * after a change (e.g. after the transformation was reset). Call this
+	 * before using the bitmap as a source on several threads at once to not
+	 * do this concurrently.
+	 *
+	 * There is no public pixman API for this. It relies on
+	 * pixman_image_composite32 validating the images before it rejects an
+	 * empty area, which current pixman versions do. Blits that change
+	 * properties of the source (transformation, repeat) must not be used
+	 * on several threads at once. The "ParallelRead" test covers this.
+	 */
+	void PrepareParallelRead() const;
+
 protected:
 	DynamicFormat format;
 
@@ -620,16 +807,102 @@ protected:
 	std::string id;
 
 	/** Bpp of the source image */
-	int original_bpp;
+	int original_bpp = 0;
 
 	/** Bitmap data. */
 	PixmanImagePtr bitmap;
 	pixman_format_code_t pixman_format;
 
+	/** Clip rect of views, empty when the whole bitmap is drawable */
+	Rect clip_rect;
+
+	/** See GetRevision */
+	uint64_t revision = CreateRevision();
+
+	static uint64_t CreateRevision();
+
 	void Init(int width, int height, void* data, int pitch = 0, bool destroy = true);
 	void ConvertImage(int& width, int& height, void*& pixels, bool transparent);
 
 	static PixmanImagePtr GetSubimage(Bitmap const& src, const Rect& src_rect);
+
+	/**
+	 * Checks whether the pixels of src can be composited on this bitmap
+	 * without conversion by the kernels that bypass pixman.
+	 *
+	 * @param src source bitmap
+	 * @return whether both use the same 32 bit layout
+	 */
+	bool IsDirectSource(Bitmap const& src) const;
+
+	/**
+	 * Checks whether a blit of src with the operator op is a plain copy
+	 * of the source pixels, which is the case for opaque sources and for
+	 * sources with 1 bit alpha (copy of the opaque pixels).
+	 *
+	 * @param src source bitmap
+	 * @param src_rect source bitmap rect
+	 * @param op pixman operator of the blit
+	 * @param mode copy mode used by the copy kernel
+	 * @return whether the blit can be done without pixman
+	 */
+	bool GetCopyMode(Bitmap const& src, Rect const& src_rect, pixman_op_t op, int& mode) const;
+
+	/**
+	 * Unscaled blit without pixman, see GetCopyMode.
+	 *
+	 * @return whether the blit was done
+	 */
+	bool BlitDirect(int x, int y, Bitmap const& src, Rect const& src_rect, pixman_op_t op);
+
+	/**
+	 * Nearest neighbour blit of a transformed source without pixman.
+	 * Same result as pixman_image_composite32 with the transformed source and
+	 * the mask of CreateMask. Supports the operators OVER and, for opaque
+	 * blits, SRC. Opaque sources, sources with 1 bit alpha and the split
+	 * opacity of the mask are drawn as spans of a scanline.
+	 *
+	 * @param src source bitmap
+	 * @param image_rect part of src that is the source image of the composite
+	 * @param xform transformation from destination to source image coordinates
+	 * @param opacity opacity of the mask
+	 * @param mask_rect source rect passed to CreateMask
+	 * @param op pixman operator of the blit
+	 * @param src_x source image x position before the transformation
+	 * @param src_y source image y position before the transformation
+	 * @param mask_x mask x position
+	 * @param mask_y mask y position
+	 * @param dst_rect destination rect
+	 * @return whether the blit was done
+	 */
+	bool AffineBlitDirect(Bitmap const& src, Rect const& image_rect, Transform const& xform,
+		Opacity const& opacity, Rect const& mask_rect, pixman_op_t op,
+		int src_x, int src_y, int mask_x, int mask_y, Rect const& dst_rect);
+
+	/**
+	 * WaverBlit without pixman, same result as the composite of every row.
+	 * Rows without zoom are copied at once, zoomed rows use a column table.
+	 *
+	 * @param x destination x position.
+	 * @param y destination y position.
+	 * @param xform scale from destination to source coordinates
+	 * @param src source bitmap.
+	 * @param src_rect source bitmap rect.
+	 * @param xoff source x position of the composite
+	 * @param yoff source y position of the composite
+	 * @param yclip first drawn row
+	 * @param offsets horizontal displacement of every row starting at yclip
+	 * @param width width of a row
+	 * @param opacity opacity.
+	 * @param op pixman operator of the blit
+	 * @return whether the blit was done
+	 */
+	bool WaverBlitDirect(int x, int y, Transform const& xform, Bitmap const& src, Rect const& src_rect,
+		double xoff, double yoff, int yclip, std::vector<int> const& offsets, int width,
+		Opacity const& opacity, pixman_op_t op);
+
+	/** Whether pixman draws all rotated and scaled blits */
+	static bool pixman_affine_blit;
 	static inline void MultiplyAlpha(uint8_t &r, uint8_t &g, uint8_t &b, const uint8_t &a) {
 		r = (uint8_t)((int)r * a / 0xFF);
 		g = (uint8_t)((int)g * a / 0xFF);
@@ -694,6 +967,22 @@ inline Rect Bitmap::GetRect() const {
 	return Rect(0, 0, width(), height());
 }
 
+inline Rect Bitmap::GetClipRect() const {
+	return clip_rect.IsEmpty() ? GetRect() : clip_rect;
+}
+
+inline uint64_t Bitmap::GetRevision() const {
+	return revision;
+}
+
+inline void Bitmap::SetPixmanAffineBlit(bool enabled) {
+	pixman_affine_blit = enabled;
+}
+
+inline bool Bitmap::GetPixmanAffineBlit() {
+	return pixman_affine_blit;
+}
+
 inline bool Bitmap::GetTransparent() const {
 	return format.alpha_type != PF::NoAlpha;
 }
@@ -0,0 +1,568 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "bitmap_tone.h"
+#include "cpu_features.h"
+
+#if defined(EP_SIMD_X86)
+#  include <immintrin.h>
+#elif defined(EP_SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+namespace {
+
+// Hard light lookup table mapping source color to destination color
+struct HardLightTable {
+	uint8_t table[256][256] = {};
+};
+
+constexpr HardLightTable make_hard_light_lookup() {
+	HardLightTable hl;
+	for (int i = 0; i < 256; ++i) {
+		for (int j = 0; j < 256; ++j) {
+			int res = 0;
+			if (i <= 128)
+				res = (2 * i * j) / 255;
+			else
+				res = 255 - 2 * (255 - i) * (255 - j) / 255;
+			hl.table[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
+		}
+	}
+	return hl;
+}
+
+constexpr auto hard_light = make_hard_light_lookup();
+
+/*
+ * The vector kernels cannot use the lookup table. They use the identity
+ *   hard_light[t][v] = div255(k * (v ^ inv)) ^ inv
+ * with k = 2 * t, inv = 0 for t < 128 and k = 2 * (255 - t), inv = 0xFF for t > 128.
+ * t = 128 is the identity (the table clamps 256 to 255) which is k = 255, inv = 0.
+ * The product is always < 65536 where div255 is exact.
+ */
+struct ChannelTone {
+	int factor;
+	int invert;
+};
+
+constexpr ChannelTone MakeChannelTone(int t) {
+	return t < 128 ? ChannelTone{ 2 * t, 0 } :
+		t == 128 ? ChannelTone{ 255, 0 } :
+		ChannelTone{ 2 * (255 - t), 0xFF };
+}
+
+struct Params {
+	int rs, gs, bs, as;
+	/** Saturation factor, 1024 means no change */
+	int sat;
+	Tone tone;
+	ChannelTone r_tone, g_tone, b_tone;
+};
+
+// Saturation Tone Inline: Changes a pixel saturation
+inline void saturation_tone(uint32_t &src_pixel, const int saturation, const int rs, const int gs, const int bs, const int as) {
+	// Algorithm from OpenPDN (MIT license)
+	// Transformation in Y'CbCr color space
+	uint8_t r = (src_pixel >> rs) & 0xFF;
+	uint8_t g = (src_pixel >> gs) & 0xFF;
+	uint8_t b = (src_pixel >> bs) & 0xFF;
+	uint8_t a = (src_pixel >> as) & 0xFF;
+
+	// Y' = 0.299 R' + 0.587 G' + 0.114 B'
+	uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
+
+	// Scale Cb/Cr by scale factor "sat"
+	int red = ((lum * 1024 + (r - lum) * saturation) >> 10);
+	red = red > 255 ? 255 : red < 0 ? 0 : red;
+	int green = ((lum * 1024 + (g - lum) * saturation) >> 10);
+	green = green > 255 ? 255 : green < 0 ? 0 : green;
+	int blue = ((lum * 1024 + (b - lum) * saturation) >> 10);
+	blue = blue > 255 ? 255 : blue < 0 ? 0 : blue;
+
+	src_pixel = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
+}
+
+// Color Tone Inline: Changes color of a pixel by hard light table
+inline void color_tone(uint32_t &src_pixel, const Tone& tone, const int rs, const int gs, const int bs, const int as) {
+	src_pixel = ((uint32_t)hard_light.table[tone.red][(src_pixel >> rs) & 0xFF] << rs)
+		| ((uint32_t)hard_light.table[tone.green][(src_pixel >> gs) & 0xFF] << gs)
+		| ((uint32_t)hard_light.table[tone.blue][(src_pixel >> bs) & 0xFF] << bs)
+		| ((uint32_t)((src_pixel >> as) & 0xFF) << as);
+}
+
+inline void color_tone_alpha(uint32_t &src_pixel, const Tone& tone, const int rs, const int gs, const int bs, const int as) {
+	uint8_t a = (src_pixel >> as) & 0xFF;
+	uint8_t r = ((uint32_t)hard_light.table[tone.red][(src_pixel >> rs) & 0xFF]) * a / 255;
+	uint8_t g = ((uint32_t)hard_light.table[tone.green][(src_pixel >> gs) & 0xFF]) * a / 255;
+	uint8_t b = ((uint32_t)hard_light.table[tone.blue][(src_pixel >> bs) & 0xFF]) * a / 255;
+	src_pixel = ((uint32_t)r << rs) | ((uint32_t)g << gs) | ((uint32_t)b << bs) | ((uint32_t)a << as);
+}
+
+/*
+ * Row kernels
+ *
+ * Sat: Apply saturation
+ * Col: Apply color tone
+ * Op: Opaque: Alpha check can be skipped
+ *     1 Bit: Premultiplied Alpha can be skipped
+ *     8 Bit: No optimisations possible
+ */
+struct ScalarKernel {
+	template <bool Sat, bool Col, ImageOpacity Op>
+	static void Row(uint32_t* pixels, int begin, int end, const Params& p) {
+		for (int j = begin; j < end; ++j) {
+			if (Op != ImageOpacity::Opaque) {
+				uint8_t a = (uint8_t)((pixels[j] >> p.as) & 0xFF);
+				if (a == 0)
+					continue;
+			}
+
+			if (Sat) {
+				saturation_tone(pixels[j], p.sat, p.rs, p.gs, p.bs, p.as);
+			}
+			if (Col) {
+				if (Op == ImageOpacity::Alpha_8Bit) {
+					color_tone_alpha(pixels[j], p.tone, p.rs, p.gs, p.bs, p.as);
+				} else {
+					color_tone(pixels[j], p.tone, p.rs, p.gs, p.bs, p.as);
+				}
+			}
+		}
+	}
+};
+
+#if defined(EP_SIMD_X86)
+
+/*
+ * SSE2 kernel, processes 4 pixels per iteration.
+ * Every channel is kept in its own register with one 32 bit lane per pixel.
+ * Multiplications use madd_epi16 because SSE2 has no 32 bit multiply. All factors
+ * fit into the lower 16 bit of a lane and the upper 16 bit are zero or contain a
+ * second factor that is added to the result.
+ */
+struct SSE2Kernel {
+	EP_TARGET("sse2") static inline __m128i Div255(__m128i x) {
+		const __m128i one = _mm_set1_epi32(1);
+		__m128i t = _mm_srli_epi32(_mm_add_epi32(x, one), 8);
+		return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, t), one), 8);
+	}
+
+	EP_TARGET("sse2") static inline __m128i Clamp(__m128i x) {
+		const __m128i zero = _mm_setzero_si128();
+		__m128i t = _mm_packs_epi32(x, x);
+		t = _mm_min_epi16(_mm_max_epi16(t, zero), _mm_set1_epi16(255));
+		return _mm_unpacklo_epi16(t, zero);
+	}
+
+	EP_TARGET("sse2") static inline __m128i Saturate(__m128i c, __m128i lum, __m128i sat) {
+		// lum * 1024 + (c - lum) * sat
+		__m128i t = _mm_or_si128(lum, _mm_slli_epi32(_mm_sub_epi32(c, lum), 16));
+		return Clamp(_mm_srai_epi32(_mm_madd_epi16(t, sat), 10));
+	}
+
+	EP_TARGET("sse2") static inline __m128i HardLight(__m128i c, __m128i factor, __m128i invert) {
+		return _mm_xor_si128(Div255(_mm_madd_epi16(_mm_xor_si128(c, invert), factor)), invert);
+	}
+
+	template <bool Sat, bool Col, ImageOpacity Op>
+	EP_TARGET("sse2") static void Row(uint32_t* pixels, int begin, int end, const Params& p) {
+		const __m128i rs = _mm_cvtsi32_si128(p.rs);
+		const __m128i gs = _mm_cvtsi32_si128(p.gs);
+		const __m128i bs = _mm_cvtsi32_si128(p.bs);
+		const __m128i as = _mm_cvtsi32_si128(p.as);
+		const __m128i mask = _mm_set1_epi32(0xFF);
+		const __m128i zero = _mm_setzero_si128();
+
+		const __m128i lum_rg = _mm_set1_epi32(19595 | (19235 << 16));
+		const __m128i lum_bg = _mm_set1_epi32(7471 | (19235 << 16));
+		const __m128i sat = _mm_set1_epi32(1024 | (p.sat << 16));
+
+		const __m128i r_factor = _mm_set1_epi32(p.r_tone.factor);
+		const __m128i g_factor = _mm_set1_epi32(p.g_tone.factor);
+		const __m128i b_factor = _mm_set1_epi32(p.b_tone.factor);
+		const __m128i r_invert = _mm_set1_epi32(p.r_tone.invert);
+		const __m128i g_invert = _mm_set1_epi32(p.g_tone.invert);
+		const __m128i b_invert = _mm_set1_epi32(p.b_tone.invert);
+
+		int j = begin;
+		for (; j + 4 <= end; j += 4) {
+			__m128i* ptr = reinterpret_cast<__m128i*>(pixels + j);
+			const __m128i px = _mm_loadu_si128(ptr);
+
+			__m128i r = _mm_and_si128(_mm_srl_epi32(px, rs), mask);
+			__m128i g = _mm_and_si128(_mm_srl_epi32(px, gs), mask);
+			__m128i b = _mm_and_si128(_mm_srl_epi32(px, bs), mask);
+			const __m128i a = _mm_and_si128(_mm_srl_epi32(px, as), mask);
+
+			if (Sat) {
+				// 38470 does not fit into a signed 16 bit factor: g * 19235 is added twice
+				const __m128i g_hi = _mm_slli_epi32(g, 16);
+				__m128i lum = _mm_add_epi32(
+					_mm_madd_epi16(_mm_or_si128(r, g_hi), lum_rg),
+					_mm_madd_epi16(_mm_or_si128(b, g_hi), lum_bg));
+				lum = _mm_srli_epi32(lum, 16);
+
+				r = Saturate(r, lum, sat);
+				g = Saturate(g, lum, sat);
+				b = Saturate(b, lum, sat);
+			}
+
+			if (Col) {
+				r = HardLight(r, r_factor, r_invert);
+				g = HardLight(g, g_factor, g_invert);
+				b = HardLight(b, b_factor, b_invert);
+
+				if (Op == ImageOpacity::Alpha_8Bit) {
+					r = Div255(_mm_madd_epi16(r, a));
+					g = Div255(_mm_madd_epi16(g, a));
+					b = Div255(_mm_madd_epi16(b, a));
+				}
+			}
+
+			__m128i res = _mm_or_si128(
+				_mm_or_si128(_mm_sll_epi32(r, rs), _mm_sll_epi32(g, gs)),
+				_mm_or_si128(_mm_sll_epi32(b, bs), _mm_sll_epi32(a, as)));
+
+			if (Op != ImageOpacity::Opaque) {
+				// Transparent pixels are not modified
+				const __m128i transparent = _mm_cmpeq_epi32(a, zero);
+				res = _mm_or_si128(_mm_and_si128(transparent, px), _mm_andnot_si128(transparent, res));
+			}
+
+			_mm_storeu_si128(ptr, res);
+		}
+
+		ScalarKernel::Row<Sat, Col, Op>(pixels, j, end, p);
+	}
+};
+
+/*
+ * AVX2 kernel, processes 8 pixels per iteration.
+ * Same algorithm as the SSE2 kernel.
+ */
+struct AVX2Kernel {
+	EP_TARGET("avx2") static inline __m256i Div255(__m256i x) {
+		const __m256i one = _mm256_set1_epi32(1);
+		__m256i t = _mm256_srli_epi32(_mm256_add_epi32(x, one), 8);
+		return _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(x, t), one), 8);
+	}
+
+	EP_TARGET("avx2") static inline __m256i Saturate(__m256i c, __m256i lum, __m256i sat) {
+		__m256i t = _mm256_or_si256(lum, _mm256_slli_epi32(_mm256_sub_epi32(c, lum), 16));
+		t = _mm256_srai_epi32(_mm256_madd_epi16(t, sat), 10);
+		return _mm256_min_epi32(_mm256_max_epi32(t, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+	}
+
+	EP_TARGET("avx2") static inline __m256i HardLight(__m256i c, __m256i factor, __m256i invert) {
+		return _mm256_xor_si256(Div255(_mm256_madd_epi16(_mm256_xor_si256(c, invert), factor)), invert);
+	}
+
+	template <bool Sat, bool Col, ImageOpacity Op>
+	EP_TARGET("avx2") static void Row(uint32_t* pixels, int begin, int end, const Params& p) {
+		const __m128i rs = _mm_cvtsi32_si128(p.rs);
+		const __m128i gs = _mm_cvtsi32_si128(p.gs);
+		const __m128i bs = _mm_cvtsi32_si128(p.bs);
+		const __m128i as = _mm_cvtsi32_si128(p.as);
+		const __m256i mask = _mm256_set1_epi32(0xFF);
+		const __m256i zero = _mm256_setzero_si256();
+
+		const __m256i lum_rg = _mm256_set1_epi32(19595 | (19235 << 16));
+		const __m256i lum_bg = _mm256_set1_epi32(7471 | (19235 << 16));
+		const __m256i sat = _mm256_set1_epi32(1024 | (p.sat << 16));
+
+		const __m256i r_factor = _mm256_set1_epi32(p.r_tone.factor);
+		const __m256i g_factor = _mm256_set1_epi32(p.g_tone.factor);
+		const __m256i b_factor = _mm256_set1_epi32(p.b_tone.factor);
+		const __m256i r_invert = _mm256_set1_epi32(p.r_tone.invert);
+		const __m256i g_invert = _mm256_set1_epi32(p.g_tone.invert);
+		const __m256i b_invert = _mm256_set1_epi32(p.b_tone.invert);
+
+		int j = begin;
+		for (; j + 8 <= end; j += 8) {
+			__m256i* ptr = reinterpret_cast<__m256i*>(pixels + j);
+			const __m256i px = _mm256_loadu_si256(ptr);
+
+			__m256i r = _mm256_and_si256(_mm256_srl_epi32(px, rs), mask);
+			__m256i g = _mm256_and_si256(_mm256_srl_epi32(px, gs), mask);
+			__m256i b = _mm256_and_si256(_mm256_srl_epi32(px, bs), mask);
+			const __m256i a = _mm256_and_si256(_mm256_srl_epi32(px, as), mask);
+
+			if (Sat) {
+				const __m256i g_hi = _mm256_slli_epi32(g, 16);
+				__m256i lum = _mm256_add_epi32(
+					_mm256_madd_epi16(_mm256_or_si256(r, g_hi), lum_rg),
+					_mm256_madd_epi16(_mm256_or_si256(b, g_hi), lum_bg));
+				lum = _mm256_srli_epi32(lum, 16);
+
+				r = Saturate(r, lum, sat);
+				g = Saturate(g, lum, sat);
+				b = Saturate(b, lum, sat);
+			}
+
+			if (Col) {
+				r = HardLight(r, r_factor, r_invert);
+				g = HardLight(g, g_factor, g_invert);
+				b = HardLight(b, b_factor, b_invert);
+
+				if (Op == ImageOpacity::Alpha_8Bit) {
+					r = Div255(_mm256_madd_epi16(r, a));
+					g = Div255(_mm256_madd_epi16(g, a));
+					b = Div255(_mm256_madd_epi16(b, a));
+				}
+			}
+
+			__m256i res = _mm256_or_si256(
+				_mm256_or_si256(_mm256_sll_epi32(r, rs), _mm256_sll_epi32(g, gs)),
+				_mm256_or_si256(_mm256_sll_epi32(b, bs), _mm256_sll_epi32(a, as)));
+
+			if (Op != ImageOpacity::Opaque) {
+				res = _mm256_blendv_epi8(res, px, _mm256_cmpeq_epi32(a, zero));
+			}
+
+			_mm256_storeu_si256(ptr, res);
+		}
+
+		SSE2Kernel::Row<Sat, Col, Op>(pixels, j, end, p);
+	}
+};
+
+#endif
+
+#if defined(EP_SIMD_NEON)
+
+/*
+ * NEON kernel, processes 4 pixels per iteration.
+ * Same algorithm as the SSE2 kernel but with native 32 bit multiplication.
+ */
+struct NEONKernel {
+	static inline uint32x4_t Div255(uint32x4_t x) {
+		const uint32x4_t one = vdupq_n_u32(1);
+		uint32x4_t t = vshrq_n_u32(vaddq_u32(x, one), 8);
+		return vshrq_n_u32(vaddq_u32(vaddq_u32(x, t), one), 8);
+	}
+
+	static inline uint32x4_t Saturate(uint32x4_t c, uint32x4_t lum, int sat) {
+		const int32x4_t l = vreinterpretq_s32_u32(lum);
+		int32x4_t t = vmlaq_n_s32(vmulq_n_s32(l, 1024), vsubq_s32(vreinterpretq_s32_u32(c), l), sat);
+		t = vshrq_n_s32(t, 10);
+		t = vminq_s32(vmaxq_s32(t, vdupq_n_s32(0)), vdupq_n_s32(255));
+		return vreinterpretq_u32_s32(t);
+	}
+
+	static inline uint32x4_t HardLight(uint32x4_t c, uint32_t factor, uint32x4_t invert) {
+		return veorq_u32(Div255(vmulq_n_u32(veorq_u32(c, invert), factor)), invert);
+	}
+
+	template <bool Sat, bool Col, ImageOpacity Op>
+	static void Row(uint32_t* pixels, int begin, int end, const Params& p) {
+		const int32x4_t rs = vdupq_n_s32(p.rs);
+		const int32x4_t gs = vdupq_n_s32(p.gs);
+		const int32x4_t bs = vdupq_n_s32(p.bs);
+		const int32x4_t as = vdupq_n_s32(p.as);
+		// vshlq with a negative shift shifts to the right
+		const int32x4_t rs_neg = vnegq_s32(rs);
+		const int32x4_t gs_neg = vnegq_s32(gs);
+		const int32x4_t bs_neg = vnegq_s32(bs);
+		const int32x4_t as_neg = vnegq_s32(as);
+		const uint32x4_t mask = vdupq_n_u32(0xFF);
+
+		const uint32x4_t r_invert = vdupq_n_u32(p.r_tone.invert);
+		const uint32x4_t g_invert = vdupq_n_u32(p.g_tone.invert);
+		const uint32x4_t b_invert = vdupq_n_u32(p.b_tone.invert);
+
+		int j = begin;
+		for (; j + 4 <= end; j += 4) {
+			const uint32x4_t px = vld1q_u32(pixels + j);
+
+			uint32x4_t r = vandq_u32(vshlq_u32(px, rs_neg), mask);
+			uint32x4_t g = vandq_u32(vshlq_u32(px, gs_neg), mask);
+			uint32x4_t b = vandq_u32(vshlq_u32(px, bs_neg), mask);
+			const uint32x4_t a = vandq_u32(vshlq_u32(px, as_neg), mask);
+
+			if (Sat) {
+				uint32x4_t lum = vmulq_n_u32(r, 19595);
+				lum = vmlaq_n_u32(lum, g, 38470);
+				lum = vmlaq_n_u32(lum, b, 7471);
+				lum = vshrq_n_u32(lum, 16);
+
+				r = Saturate(r, lum, p.sat);
+				g = Saturate(g, lum, p.sat);
+				b = Saturate(b, lum, p.sat);
+			}
+
+			if (Col) {
+				r = HardLight(r, p.r_tone.factor, r_invert);
+				g = HardLight(g, p.g_tone.factor, g_invert);
+				b = HardLight(b, p.b_tone.factor, b_invert);
+
+				if (Op == ImageOpacity::Alpha_8Bit) {
+					r = Div255(vmulq_u32(r, a));
+					g = Div255(vmulq_u32(g, a));
+					b = Div255(vmulq_u32(b, a));
+				}
+			}
+
+			uint32x4_t res = vorrq_u32(
+				vorrq_u32(vshlq_u32(r, rs), vshlq_u32(g, gs)),
+				vorrq_u32(vshlq_u32(b, bs), vshlq_u32(a, as)));
+
+			if (Op != ImageOpacity::Opaque) {
+				res = vbslq_u32(vceqq_u32(a, vdupq_n_u32(0)), px, res);
+			}
+
+			vst1q_u32(pixels + j, res);
+		}
+
+		ScalarKernel::Row<Sat, Col, Op>(pixels, j, end, p);
+	}
+};
+
+#endif
+
+using RowFn = void (*)(uint32_t* pixels, int begin, int end, const Params& p);
+
+template <typename K, bool Sat, bool Col>
+RowFn SelectRow(ImageOpacity op) {
+	switch (op) {
+		case ImageOpacity::Opaque:
+			return &K::template Row<Sat, Col, ImageOpacity::Opaque>;
+		case ImageOpacity::Alpha_1Bit:
+			return &K::template Row<Sat, Col, ImageOpacity::Alpha_1Bit>;
+		default:
+			return &K::template Row<Sat, Col, ImageOpacity::Alpha_8Bit>;
+	}
+}
+
+template <typename K>
+RowFn SelectRow(bool sat, bool col, ImageOpacity op) {
+	if (sat && col) {
+		return SelectRow<K, true, true>(op);
+	} else if (sat) {
+		// Without color tone the premultiplied alpha is irrelevant
+		return SelectRow<K, true, false>(op == ImageOpacity::Opaque ? op : ImageOpacity::Alpha_1Bit);
+	}
+	return SelectRow<K, false, true>(op);
+}
+
+BitmapTone::Kernel active_kernel = BitmapTone::GetBestKernel();
+
+} // anonymous namespace
+
+bool BitmapTone::IsSupported(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return true;
+		case Kernel::SSE2:
+			return CpuFeatures::HasSSE2();
+		case Kernel::AVX2:
+			return CpuFeatures::HasAVX2();
+		case Kernel::NEON:
+			return CpuFeatures::HasNEON();
+	}
+	return false;
+}
+
+BitmapTone::Kernel BitmapTone::GetBestKernel() {
+	if (IsSupported(Kernel::AVX2)) {
+		return Kernel::AVX2;
+	}
+	if (IsSupported(Kernel::SSE2)) {
+		return Kernel::SSE2;
+	}
+	if (IsSupported(Kernel::NEON)) {
+		return Kernel::NEON;
+	}
+	return Kernel::Scalar;
+}
+
+BitmapTone::Kernel BitmapTone::GetKernel() {
+	return active_kernel;
+}
+
+bool BitmapTone::SetKernel(Kernel kernel) {
+	if (!IsSupported(kernel)) {
+		return false;
+	}
+	active_kernel = kernel;
+	return true;
+}
+
+const char* BitmapTone::GetKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::Scalar:
+			return "Scalar";
+		case Kernel::SSE2:
+			return "SSE2";
+		case Kernel::AVX2:
+			return "AVX2";
+		case Kernel::NEON:
+			return "NEON";
+	}
+	return "Unknown";
+}
+
+void BitmapTone::Apply(uint32_t* pixels, int width, int height, int stride,
+		const Tone& tone, ImageOpacity opacity, const Layout& layout) {
+	const bool apply_sat = tone.gray != 128;
+	const bool apply_tone = (tone.red != 128 || tone.green != 128 || tone.blue != 128);
+
+	if (!apply_sat && !apply_tone) {
+		return;
+	}
+
+	if (opacity == ImageOpacity::Transparent) {
+		return;
+	}
+
+	Params p;
+	p.rs = layout.r_shift;
+	p.gs = layout.g_shift;
+	p.bs = layout.b_shift;
+	p.as = layout.a_shift;
+	p.sat = tone.gray > 128 ? 1024 + (tone.gray - 128) * 16 : tone.gray * 8;
+	p.tone = tone;
+	p.r_tone = MakeChannelTone(tone.red);
+	p.g_tone = MakeChannelTone(tone.green);
+	p.b_tone = MakeChannelTone(tone.blue);
+
+	RowFn row = nullptr;
+	switch (active_kernel) {
+#if defined(EP_SIMD_X86)
+		case Kernel::AVX2:
+			row = SelectRow<AVX2Kernel>(apply_sat, apply_tone, opacity);
+			break;
+		case Kernel::SSE2:
+			row = SelectRow<SSE2Kernel>(apply_sat, apply_tone, opacity);
+			break;
+#endif
+#if defined(EP_SIMD_NEON)
+		case Kernel::NEON:
+			row = SelectRow<NEONKernel>(apply_sat, apply_tone, opacity);
+			break;
+#endif
+		default:
+			row = SelectRow<ScalarKernel>(apply_sat, apply_tone, opacity);
+			break;
+	}
+
+	for (int i = 0; i < height; ++i) {
+		row(pixels, 0, width, p);
+		pixels += stride;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_BITMAP_TONE_H
+#define EP_BITMAP_TONE_H
+
+// Headers
+#include <cstdint>
+#include "opacity.h"
+#include "tone.h"
+
+/**
+ * Pixel kernels which apply a Tone (saturation and hard light color) in place.
+ * Used by Bitmap::ToneBlit.
+ *
+ * The vectorized kernels produce exactly the same output as the scalar kernel.
+ */
+namespace BitmapTone {
+	enum class Kernel {
+		Scalar,
+		SSE2,
+		AVX2,
+		NEON
+	};
+
+	/** Bit position of the color channels inside a 32 bit pixel */
+	struct Layout {
+		int r_shift = 0;
+		int g_shift = 0;
+		int b_shift = 0;
+		int a_shift = 0;
+	};
+
+	/**
+	 * @param kernel kernel to check
+	 * @return Whether the kernel can run on this machine
+	 */
+	bool IsSupported(Kernel kernel);
+
+	/** @return The fastest kernel supported by this machine */
+	Kernel GetBestKernel();
+
+	/** @return The kernel used by Apply */
+	Kernel GetKernel();
+
+	/**
+	 * Changes the kernel used by Apply.
+	 * Intended for testing and benchmarking.
+	 *
+	 * @param kernel kernel to use
+	 * @return false when the kernel is not supported, the kernel is not changed then
+	 */
+	bool SetKernel(Kernel kernel);
+
+	/**
+	 * @param kernel kernel
+	 * @return Name of the kernel
+	 */
+	const char* GetKernelName(Kernel kernel);
+
+	/**
+	 * Applies a tone to a block of 32 bit pixels in place.
+	 *
+	 * @param pixels first pixel of the block
+	 * @param width pixels per row
+	 * @param height number of rows
+	 * @param stride distance between two rows in pixels
+	 * @param tone tone to apply
+	 * @param opacity opacity of the pixels: Opaque skips alpha checks, Alpha_1Bit skips
+	 *                transparent pixels, Alpha_8Bit additionally respects premultiplied alpha
+	 * @param layout channel layout of the pixels
+	 */
+	void Apply(uint32_t* pixels, int width, int height, int stride,
+		const Tone& tone, ImageOpacity opacity, const Layout& layout);
+}
+
+#endif
@@ -20,9 +20,8 @@
 #  pragma warning(disable: 4003)
 #endif
 
-#include <map>
-#include <tuple>
-#include <chrono>
+#include <algorithm>
+#include <limits>
 #include <cassert>
 
 #include "async_handler.h"
@@ -34,10 +33,10 @@
 #include "output.h"
 #include "player.h"
 #include <lcf/data.h>
-#include "game_clock.h"
 #include "translation.h"
-
-using namespace std::chrono_literals;
+#include "lru_cache.h"
+#include "image_decoder.h"
+#include "image_disk_cache.h"
 
 namespace {
 	std::string MakeHashKey(StringView folder_name, StringView filename, bool transparent) {
@@ -72,72 +71,207 @@ namespace {
 
 	struct CacheItem {
 		BitmapRef bitmap;
-		Game_Clock::time_point last_access;
 	};
 
 	using key_type = std::string;
-	std::unordered_map<key_type, CacheItem> cache;
+	// Images that are not referenced outside of the cache, in the order they
+	// were released. Only these count towards the size limit.
+	// Entries are evicted by size, not by count.
+	LruCache<key_type, CacheItem> cache(std::numeric_limits<size_t>::max());
+	// Images that were referenced when they were checked the last time.
+	// Checked a few at a time and moved to cache when they were released.
+	LruCache<key_type, CacheItem> cache_pinned(std::numeric_limits<size_t>::max());
 
 	using tile_key_type = std::string;
 	std::unordered_map<tile_key_type, std::weak_ptr<Bitmap>> cache_tiles;
 
-	// rect, flip_x, flip_y, tone, blend
-	using effect_key_type = std::tuple<std::string, bool, Rect, bool, bool, Tone, Color>;
-	std::map<effect_key_type, std::weak_ptr<Bitmap>> cache_effects;
+	struct EffectKey {
+		const Bitmap* src;
+		Rect rect;
+		bool flip_x;
+		bool flip_y;
+		Tone tone;
+		Color blend;
+		/** Hue rotation in degrees, only used by SpriteHue */
+		int hue;
+
+		bool operator==(const EffectKey& other) const {
+			return src == other.src && rect == other.rect && flip_x == other.flip_x && flip_y == other.flip_y &&
+				tone == other.tone && blend == other.blend && hue == other.hue;
+		}
+	};
+
+	struct EffectKeyHash {
+		size_t operator()(const EffectKey& key) const {
+			size_t h = std::hash<const Bitmap*>()(key.src);
+			for (int v: { key.rect.x, key.rect.y, key.rect.width, key.rect.height,
+					key.tone.red, key.tone.green, key.tone.blue, key.tone.gray, key.hue }) {
+				h = h * 31 + static_cast<size_t>(v);
+			}
+			h = h * 31 + ((key.blend.red << 24) | (key.blend.green << 16) | (key.blend.blue << 8) | key.blend.alpha);
+			return h * 4 + key.flip_x * 2 + key.flip_y;
+		}
+	};
+
+	struct EffectItem {
+		/** Detects a new bitmap that was allocated at the address of a freed one */
+		std::weak_ptr<Bitmap> src;
+		BitmapRef bitmap;
+	};
+
+	// Entries are evicted by size, not by count
+	LruCache<EffectKey, EffectItem, EffectKeyHash> cache_effects(std::numeric_limits<size_t>::max());
+
+	size_t effect_cache_limit = Cache::default_effect_size_limit;
+	size_t effect_cache_size = 0;
+	Cache::Stats effect_stats;
+
+	void FreeEffectMemory() {
+		// The most recently added effect is always kept, even when it is larger than the limit
+		while (effect_cache_size > effect_cache_limit && cache_effects.GetSize() > 1) {
+			effect_cache_size -= cache_effects.Oldest().second.bitmap->GetSize();
+			cache_effects.PopOldest();
+			++effect_stats.evictions;
+		}
+	}
 
 	std::string system_name;
 
 	std::string system2_name;
 
-	constexpr int cache_limit = 10 * 1024 * 1024;
+	size_t cache_limit = Cache::default_size_limit;
 	size_t cache_size = 0;
+	size_t pinned_size = 0;
+	Cache::Stats cache_stats;
 
-	void FreeBitmapMemory() {
-		auto cur_ticks = Game_Clock::GetFrameTime();
+	// Pinned images that are checked per insertion, keeps insertions O(1)
+	constexpr int pinned_checks = 4;
+
+	size_t GetItemSize(const CacheItem& item) {
+		return item.bitmap ? item.bitmap->GetSize() : 0;
+	}
+
+	bool IsReferenced(const CacheItem& item) {
+		return item.bitmap.use_count() > 1;
+	}
+
+	void Pin(const key_type& key, CacheItem item) {
+		pinned_size += GetItemSize(item);
+		cache_pinned.Insert(key, std::move(item));
+	}
 
-		for (auto it = cache.begin(); it != cache.end();) {
-			if (it->second.bitmap.use_count() != 1) {
-				// Bitmap is referenced
-				++it;
+	void Unpin(const key_type& key, CacheItem item) {
+		cache_size += GetItemSize(item);
+		cache.Insert(key, std::move(item));
+	}
+
+	void CheckPinned() {
+		for (int i = 0; i < pinned_checks && cache_pinned.GetSize() > 0; ++i) {
+			auto& oldest = cache_pinned.Oldest();
+			if (IsReferenced(oldest.second)) {
+				// Checked again after all other pinned images
+				cache_pinned.Find(oldest.first);
 				continue;
 			}
 
-			auto last_access = cur_ticks - it->second.last_access;
-			bool cache_exhausted = cache_size > cache_limit;
-			if (cache_exhausted) {
-				if (last_access <= 50ms) {
-					// Used during the last 3 frames, must be important, keep it.
-					++it;
-					continue;
-				}
-			} else if (last_access <= 3s) {
-				++it;
+			pinned_size -= GetItemSize(oldest.second);
+			Unpin(oldest.first, std::move(oldest.second));
+			cache_pinned.PopOldest();
+		}
+	}
+
+	void FreeBitmapMemory() {
+		CheckPinned();
+
+		while (cache_size > cache_limit && cache.GetSize() > 0) {
+			auto& oldest = cache.Oldest();
+			cache_size -= GetItemSize(oldest.second);
+
+			if (IsReferenced(oldest.second)) {
+				Pin(oldest.first, std::move(oldest.second));
+				cache.PopOldest();
 				continue;
 			}
 
 #ifdef CACHE_DEBUG
-			Output::Debug("Freeing memory of {}/{}", std::get<0>(i.first), std::get<1>(i.first));
+			Output::Debug("Freeing memory of {}", oldest.first);
 #endif
 
-			cache_size -= it->second.bitmap->GetSize();
-
-			it = cache.erase(it);
+			cache.PopOldest();
+			++cache_stats.evictions;
 		}
 
 #ifdef CACHE_DEBUG
-		Output::Debug("Bitmap cache size: {}", cache_size / 1024.0 / 1024);
+		Output::Debug("Bitmap cache size: {} (pinned {})", cache_size / 1024.0 / 1024, pinned_size / 1024.0 / 1024);
 #endif
 	}
 
-	BitmapRef AddToCache(const std::string& key, BitmapRef bmp) {
-		if (bmp) {
-			cache_size += bmp->GetSize();
+	/**
+	 * Looks up an image. The caller references the returned image, so it
+	 * is pinned.
+	 */
+	BitmapRef FindInCache(const key_type& key) {
+		if (auto* item = cache_pinned.Find(key)) {
+			return item->bitmap;
+		}
+
+		auto* item = cache.Find(key);
+		if (!item) {
+			return nullptr;
+		}
+
+		auto bmp = item->bitmap;
+		cache_size -= GetItemSize(*item);
+		Pin(key, std::move(*item));
+		cache.Erase(key);
+		return bmp;
+	}
+
+	bool IsCached(const key_type& key) {
+		return cache_pinned.Find(key) || cache.Find(key);
+	}
+
+	/**
+	 * Adds an image to the cache.
+	 *
+	 * @param key key of the image
+	 * @param bmp image to add
+	 * @param referenced whether the image is referenced outside of the cache
+	 * @return bmp
+	 */
+	BitmapRef AddToCache(const key_type& key, BitmapRef bmp, bool referenced = true) {
+		if (auto* item = cache_pinned.Find(key)) {
+			pinned_size -= GetItemSize(*item);
+			cache_pinned.Erase(key);
+		} else if (auto* item = cache.Find(key)) {
+			cache_size -= GetItemSize(*item);
+			cache.Erase(key);
+		}
+
+		if (referenced) {
+			Pin(key, {bmp});
+		} else {
+			Unpin(key, {bmp});
+		}
 #ifdef CACHE_DEBUG
-			Output::Debug("Bitmap cache size (Add): {}", cache_size / 1024.0 / 1024.0);
+		Output::Debug("Bitmap cache size (Add): {}", cache_size / 1024.0 / 1024.0);
 #endif
-		}
 
-		return (cache[key] = {bmp, Game_Clock::GetFrameTime()}).bitmap;
+		FreeBitmapMemory();
+
+		return bmp;
+	}
+
+	template <typename T>
+	void AddStats(Cache::Stats& stats, const T& lru_cache) {
+		stats.entries += lru_cache.GetSize();
+		for (auto& entry: lru_cache) {
+			const size_t size = entry.second.bitmap ? entry.second.bitmap->GetSize() : 0;
+			stats.size += size;
+			if (entry.second.bitmap.use_count() > 1) {
+				stats.pinned += size;
+			}
+		}
 	}
 
 	struct Material {
@@ -200,6 +334,18 @@ namespace {
 		{ "Frame", DrawCheckerboard<Material::Frame>, true, 320, 320, 240, 240, true, true },
 	};
 
+	uint32_t GetBitmapFlags(Material::Type type) {
+		return Bitmap::Flag_ReadOnly | (
+			type == Material::Chipset ? Bitmap::Flag_Chipset :
+			type == Material::System ? Bitmap::Flag_System : 0);
+	}
+
+	bool IsHighBitDepthAllowed() {
+		// FIXME: This HasActiveTranslation check will also load 32 bit images in the game directory when
+		// a translation is active and our API does not expose whether the asset was redirected or not.
+		return Player::HasEasyRpgExtensions() || Player::IsPatchManiac() || Tr::HasActiveTranslation();
+	}
+
 	template<Material::Type T>
 	BitmapRef DrawCheckerboard() {
 		static_assert(Material::REND < T && T < Material::END, "Invalid material.");
@@ -248,8 +394,10 @@ namespace {
 		BitmapRef bmp;
 
 		const auto key = MakeHashKey(s.directory, filename, transparent);
-		auto it = cache.find(key);
-		if (it == cache.end()) {
+		bmp = FindInCache(key);
+		if (!bmp) {
+			++cache_stats.misses;
+
 			if (filename == CACHE_DEFAULT_BITMAP) {
 				bmp = LoadDummyBitmap<T>(s.directory, filename, true);
 			}
@@ -257,8 +405,6 @@ namespace {
 			if (!bmp) {
 				auto is = FileFinder::OpenImage(s.directory, filename);
 
-				FreeBitmapMemory();
-
 				if (!is) {
 					if (s.warn_missing) {
 						Output::Warning("Image not found: {}/{}", s.directory, filename);
@@ -267,17 +413,12 @@ namespace {
 						bmp = CreateEmpty<T>();
 					}
 				} else {
-					auto flags = Bitmap::Flag_ReadOnly | (
-							T == Material::Chipset ? Bitmap::Flag_Chipset :
-							T == Material::System ? Bitmap::Flag_System : 0);
-					bmp = Bitmap::Create(std::move(is), transparent, flags);
+					bmp = ImageDiskCache::Create(std::move(is), transparent, GetBitmapFlags(T));
 					if (!bmp) {
 						Output::Warning("Invalid image: {}/{}", s.directory, filename);
 					} else {
 						if (bmp->GetOriginalBpp() > 8) {
-							// FIXME: This HasActiveTranslation check will also load 32 bit images in the game directory when
-							// a translation is active and our API does not expose whether the asset was redirected or not.
-							if (!Player::HasEasyRpgExtensions() && !Player::IsPatchManiac() && !Tr::HasActiveTranslation()) {
+							if (!IsHighBitDepthAllowed()) {
 								Output::Warning("Image {}/{} has a bit depth of {} that is not supported by RPG_RT. Enable EasyRPG Extensions or Maniac Patch to load such images.", s.directory, filename, bmp->GetOriginalBpp());
 								bmp.reset();
 							}
@@ -293,8 +434,7 @@ namespace {
 
 			bmp = AddToCache(key, bmp);
 		} else {
-			it->second.last_access = Game_Clock::GetFrameTime();
-			bmp = it->second.bitmap;
+			++cache_stats.hits;
 		}
 
 		assert(bmp);
@@ -404,9 +544,11 @@ BitmapRef Cache::System(StringView file) {
 BitmapRef Cache::Exfont() {
 	const auto key = MakeHashKey("ExFont", "ExFont", false);
 
-	auto it = cache.find(key);
+	auto bmp = FindInCache(key);
+
+	if (!bmp) {
+		++cache_stats.misses;
 
-	if (it == cache.end()) {
 		// Allow overwriting of built-in exfont with a custom ExFont image file
 		// exfont_custom is filled by Player::CreateGameObjects
 		BitmapRef exfont_img;
@@ -420,8 +562,8 @@ BitmapRef Cache::Exfont() {
 
 		return AddToCache(key, exfont_img);
 	} else {
-		it->second.last_access = Game_Clock::GetFrameTime();
-		return it->second.bitmap;
+		++cache_stats.hits;
+		return bmp;
 	}
 }
 
@@ -463,62 +605,262 @@ BitmapRef Cache::Tile(StringView filename, int tile_id) {
 }
 
 BitmapRef Cache::SpriteEffect(const BitmapRef& src_bitmap, const Rect& rect, bool flip_x, bool flip_y, const Tone& tone, const Color& blend) {
-	const effect_key_type key {
-		src_bitmap->GetId(),
-		src_bitmap->GetTransparent(),
+	const EffectKey key {
+		src_bitmap.get(),
 		rect,
 		flip_x,
 		flip_y,
 		tone,
-		blend
+		blend,
+		0
 	};
 
-	assert(!src_bitmap->GetId().empty());
+	if (auto* item = cache_effects.Find(key)) {
+		if (item->src.lock() == src_bitmap) {
+			++effect_stats.hits;
+			return item->bitmap;
+		}
+
+		// Source bitmap was freed
+		effect_cache_size -= item->bitmap->GetSize();
+		cache_effects.Erase(key);
+	}
 
-	const auto it = cache_effects.find(key);
+	++effect_stats.misses;
 
-	if (it == cache_effects.end() || it->second.expired()) {
-		BitmapRef bitmap_effects;
+	BitmapRef bitmap_effects;
 
-		auto create = [&rect] () -> BitmapRef {
-			return Bitmap::Create(rect.width, rect.height, true);
-		};
+	auto create = [&rect] () -> BitmapRef {
+		return Bitmap::Create(rect.width, rect.height, true);
+	};
+
+	if (tone != Tone()) {
+		bitmap_effects = create();
+		bitmap_effects->ToneBlit(0, 0, *src_bitmap, rect, tone, Opacity::Opaque());
+	}
+
+	if (blend != Color()) {
+		if (bitmap_effects) {
+			// Tone blit was applied
+			bitmap_effects->BlendBlit(0, 0, *bitmap_effects, bitmap_effects->GetRect(), blend, Opacity::Opaque());
+		} else {
+			bitmap_effects = create();
+			bitmap_effects->BlendBlit(0, 0, *src_bitmap, rect, blend, Opacity::Opaque());
+		}
+	}
 
-		if (tone != Tone()) {
+	if (flip_x || flip_y) {
+		if (bitmap_effects) {
+			// Tone or blend blit was applied
+			bitmap_effects->Flip(flip_x, flip_y);
+		} else {
 			bitmap_effects = create();
-			bitmap_effects->ToneBlit(0, 0, *src_bitmap, rect, tone, Opacity::Opaque());
+			bitmap_effects->FlipBlit(0, 0, *src_bitmap, rect, flip_x, flip_y, Opacity::Opaque());
+		}
+	}
+
+	assert(bitmap_effects && "Effect cache used but no effect applied!");
+
+	cache_effects.Insert(key, { src_bitmap, bitmap_effects });
+	effect_cache_size += bitmap_effects->GetSize();
+	FreeEffectMemory();
+
+	return bitmap_effects;
+}
+
+BitmapRef Cache::SpriteHue(const BitmapRef& src_bitmap, const Rect& rect, int hue) {
+	hue %= 360;
+	if (hue < 0) {
+		hue += 360;
+	}
+
+	const EffectKey key {
+		src_bitmap.get(),
+		rect,
+		false,
+		false,
+		Tone(),
+		Color(),
+		hue
+	};
+
+	if (auto* item = cache_effects.Find(key)) {
+		if (item->src.lock() == src_bitmap) {
+			++effect_stats.hits;
+			return item->bitmap;
 		}
 
-		if (blend != Color()) {
-			if (bitmap_effects) {
-				// Tone blit was applied
-				bitmap_effects->BlendBlit(0, 0, *bitmap_effects, bitmap_effects->GetRect(), blend, Opacity::Opaque());
-			} else {
-				bitmap_effects = create();
-				bitmap_effects->BlendBlit(0, 0, *src_bitmap, rect, blend, Opacity::Opaque());
+		// Source bitmap was freed
+		effect_cache_size -= item->bitmap->GetSize();
+		cache_effects.Erase(key);
+	}
+
+	++effect_stats.misses;
+
+	BitmapRef bitmap_hue = Bitmap::Create(rect.width, rect.height, true);
+	bitmap_hue->HueChangeBlit(0, 0, *src_bitmap, rect, hue);
+
+	cache_effects.Insert(key, { src_bitmap, bitmap_hue });
+	effect_cache_size += bitmap_hue->GetSize();
+	FreeEffectMemory();
+
+	return bitmap_hue;
+}
+
+int Cache::Preload(const std::vector<PreloadImage>& images, size_t budget) {
+	if (!FileFinder::Game()) {
+		return 0;
+	}
+
+	// Preloaded images are not referenced. They must fit into the cache
+	// without freeing other images, otherwise they are freed right away.
+	budget = std::min(budget, GetAvailableSize());
+
+	// Requested, opened and decoded in chunks to stop close to the budget
+	const size_t chunk_size = ImageDecoder::GetNumThreads() * 2;
+	size_t loaded_size = 0;
+	int loaded = 0;
+
+	auto it = images.begin();
+	while (it != images.end() && loaded_size < budget) {
+		// Files are opened on this thread, the filesystems are not thread safe
+		std::vector<DecodeJob> jobs;
+		for (; it != images.end() && jobs.size() < chunk_size; ++it) {
+			auto& image = *it;
+			if (image.filename.empty()) {
+				continue;
+			}
+
+			// Not downloaded yet on Emscripten, the request starts the download
+			auto* request = AsyncHandler::RequestFile(image.folder, image.filename);
+			request->Start();
+			if (!request->IsReady()) {
+				continue;
 			}
+
+			DecodeJob job;
+			if (!OpenDecodeJob(image, job) || std::any_of(jobs.begin(), jobs.end(), [&](const DecodeJob& j) { return j.key == job.key; })) {
+				continue;
+			}
+
+			jobs.push_back(std::move(job));
 		}
 
-		if (flip_x || flip_y) {
-			if (bitmap_effects) {
-				// Tone or blend blit was applied
-				bitmap_effects->Flip(flip_x, flip_y);
-			} else {
-				bitmap_effects = create();
-				bitmap_effects->FlipBlit(0, 0, *src_bitmap, rect, flip_x, flip_y, Opacity::Opaque());
+		std::vector<ImageDecoder::Source> sources;
+		for (auto& job: jobs) {
+			sources.push_back({ std::move(job.stream), job.transparent, job.flags });
+		}
+		auto bitmaps = ImageDecoder::Decode(std::move(sources));
+
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			auto& job = jobs[i];
+			job.bitmap = std::move(bitmaps[i]);
+			const size_t size = job.bitmap ? job.bitmap->GetSize() : 0;
+			if (AddDecoded(job)) {
+				loaded_size += size;
+				++loaded;
 			}
 		}
+	}
 
-		assert(bitmap_effects && "Effect cache used but no effect applied!");
+	return loaded;
+}
 
-		return(cache_effects[key] = bitmap_effects).lock();
-	} else { return it->second.lock(); }
+void Cache::DecodeJob::Decode() {
+	bitmap = ImageDiskCache::Create(std::move(stream), transparent, flags);
+}
+
+bool Cache::OpenDecodeJob(const PreloadImage& image, DecodeJob& job) {
+	if (image.filename.empty() || image.filename == CACHE_DEFAULT_BITMAP) {
+		return false;
+	}
+
+	auto* s = std::find_if(std::begin(spec), std::end(spec), [&](const Spec& s) {
+		return image.folder == s.directory;
+	});
+	if (s == std::end(spec)) {
+		return false;
+	}
+	const auto type = static_cast<Material::Type>(s - std::begin(spec));
+	const bool transparent = type == Material::Picture ? image.transparent : s->transparent;
+
+	auto key = MakeHashKey(s->directory, image.filename, transparent);
+	if (IsCached(key)) {
+		return false;
+	}
+
+	auto is = FileFinder::OpenImage(s->directory, image.filename);
+	if (!is) {
+		// Reported when the image is loaded
+		return false;
+	}
+
+	job.key = std::move(key);
+	job.stream = std::move(is);
+	job.transparent = transparent;
+	job.flags = GetBitmapFlags(type);
+	job.bitmap.reset();
+	return true;
+}
+
+bool Cache::AddDecoded(DecodeJob& job, bool referenced) {
+	// Failures and unsupported bit depths are reported when the image is loaded
+	if (!job.bitmap || (job.bitmap->GetOriginalBpp() > 8 && !IsHighBitDepthAllowed())) {
+		return false;
+	}
+
+	// Loaded synchronously while the job was running
+	if (IsCached(job.key)) {
+		return false;
+	}
+
+	++cache_stats.preloaded;
+	AddToCache(job.key, std::move(job.bitmap), referenced);
+	return true;
+}
+
+void Cache::SetSizeLimit(size_t limit) {
+	cache_limit = limit;
+	FreeBitmapMemory();
+}
+
+size_t Cache::GetSizeLimit() {
+	return cache_limit;
+}
+
+size_t Cache::GetAvailableSize() {
+	return cache_size < cache_limit ? cache_limit - cache_size : 0;
+}
+
+void Cache::SetEffectSizeLimit(size_t limit) {
+	effect_cache_limit = limit;
+	FreeEffectMemory();
+}
+
+size_t Cache::GetEffectSizeLimit() {
+	return effect_cache_limit;
+}
+
+Cache::Stats Cache::GetStats() {
+	auto stats = cache_stats;
+	AddStats(stats, cache);
+	AddStats(stats, cache_pinned);
+	return stats;
+}
+
+Cache::Stats Cache::GetSpriteEffectStats() {
+	auto stats = effect_stats;
+	AddStats(stats, cache_effects);
+	return stats;
 }
 
 void Cache::Clear() {
-	cache_effects.clear();
-	cache.clear();
+	cache_effects.Clear();
+	effect_cache_size = 0;
+	cache.Clear();
 	cache_size = 0;
+	cache_pinned.Clear();
+	pinned_size = 0;
 
 	for (auto& kv : cache_tiles) {
 		auto& key = kv.first;
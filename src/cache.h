@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "system.h"
+#include "filesystem_stream.h"
 #include "memory_management.h"
 #include "string_view.h"
 
@@ -58,6 +59,137 @@ namespace Cache {
 	BitmapRef Tile(StringView filename, int tile_id);
 	BitmapRef SpriteEffect(const BitmapRef& src_bitmap, const Rect& rect, bool flip_x, bool flip_y, const Tone& tone, const Color& blend);
 
+	/**
+	 * Returns a copy of a part of a bitmap with rotated hue. The result is
+	 * stored in the sprite effect cache, so every hue is only calculated once.
+	 *
+	 * @param src_bitmap source bitmap
+	 * @param rect part of the source bitmap
+	 * @param hue hue change, degrees
+	 * @return bitmap with the size of rect
+	 */
+	BitmapRef SpriteHue(const BitmapRef& src_bitmap, const Rect& rect, int hue);
+
+	/** Counters of a bitmap cache */
+	struct Stats {
+		/** Lookups that returned a cached bitmap */
+		size_t hits = 0;
+		/** Lookups that created a new bitmap */
+		size_t misses = 0;
+		/** Bitmaps removed to stay below the size limit */
+		size_t evictions = 0;
+		/** Number of cached bitmaps */
+		size_t entries = 0;
+		/** Size of the cached bitmaps in bytes */
+		size_t size = 0;
+		/** Size of the cached bitmaps that are still referenced in bytes */
+		size_t pinned = 0;
+		/** Bitmaps that were decoded in advance or in the background */
+		size_t preloaded = 0;
+	};
+
+	/** An image that is loaded in advance by Preload */
+	struct PreloadImage {
+		/** Folder of the image, e.g. "CharSet" */
+		std::string folder;
+		/** Filename of the image */
+		std::string filename;
+		/** Whether the image is transparent, only used for pictures */
+		bool transparent = true;
+	};
+
+	/**
+	 * Decodes images on worker threads and adds them to the cache, so that
+	 * loading them later is a cache hit. Images that are already cached,
+	 * missing or not downloaded yet are skipped. The images are requested,
+	 * opened and decoded a few at a time until the budget is used up.
+	 *
+	 * @param images images to load, most important first
+	 * @param budget loading stops when images of this size in bytes were
+	 *               loaded, at most GetAvailableSize
+	 * @return number of loaded images
+	 */
+	int Preload(const std::vector<PreloadImage>& images, size_t budget);
+
+	/**
+	 * An image that is opened on the main thread and decoded outside of
+	 * the cache, e.g. on a worker thread.
+	 */
+	struct DecodeJob {
+		std::string key;
+		Filesystem_Stream::InputStream stream;
+		bool transparent = true;
+		uint32_t flags = 0;
+		BitmapRef bitmap;
+
+		/** Decodes the stream. Can be called on any thread. */
+		void Decode();
+	};
+
+	/**
+	 * Opens an image for a DecodeJob.
+	 *
+	 * @param image image to open
+	 * @param job receives the opened image
+	 * @return false when the image is already cached, not in a folder of
+	 *         the cache or missing
+	 */
+	bool OpenDecodeJob(const PreloadImage& image, DecodeJob& job);
+
+	/**
+	 * Adds the image of a finished DecodeJob to the cache. Images that
+	 * failed to decode or are not supported are skipped, they are reported
+	 * when they are loaded.
+	 *
+	 * @param job finished job
+	 * @param referenced whether the caller keeps a reference to the image
+	 *                   until it is loaded, so that it is not freed before
+	 * @return whether the image was added
+	 */
+	bool AddDecoded(DecodeJob& job, bool referenced = false);
+
+	/** Default size limit of the image cache in bytes */
+	constexpr size_t default_size_limit = 10 * 1024 * 1024;
+
+	/**
+	 * Sets the size limit of the image cache. The limit applies to images
+	 * that are not referenced outside of the cache anymore. When it is
+	 * exceeded the least recently released images are freed. Images that
+	 * are still in use do not count towards the limit.
+	 *
+	 * @param limit size limit in bytes
+	 */
+	void SetSizeLimit(size_t limit);
+
+	/** @return size limit of the image cache in bytes */
+	size_t GetSizeLimit();
+
+	/**
+	 * @return bytes of images that are not referenced anymore that can be
+	 *         added before images are freed
+	 */
+	size_t GetAvailableSize();
+
+	/** @return counters of the image cache */
+	Stats GetStats();
+
+	/** Default size limit of the sprite effect cache in bytes */
+	constexpr size_t default_effect_size_limit = 4 * 1024 * 1024;
+
+	/**
+	 * Sets the size limit of the sprite effect cache. When the limit is
+	 * exceeded the least recently used effects are freed.
+	 *
+	 * @param limit size limit in bytes
+	 */
+	void SetEffectSizeLimit(size_t limit);
+
+	/** @return size limit of the sprite effect cache in bytes */
+	size_t GetEffectSizeLimit();
+
+	/** @return counters of the sprite effect cache */
+	Stats GetSpriteEffectStats();
+
 	void Clear();
 	void ClearAll();
 
@@ -0,0 +1,86 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "cpu_features.h"
+
+#if defined(EP_SIMD_X86) && defined(_MSC_VER)
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
+namespace {
+#if defined(EP_SIMD_X86)
+	struct X86Features {
+		bool sse2 = false;
+		bool avx2 = false;
+
+		X86Features() {
+#  if defined(__GNUC__)
+			__builtin_cpu_init();
+			sse2 = __builtin_cpu_supports("sse2");
+			avx2 = __builtin_cpu_supports("avx2");
+#  else
+			int info[4] = {};
+			__cpuid(info, 0);
+			const int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			sse2 = (info[3] & (1 << 26)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+
+			if (max_leaf >= 7 && osxsave && avx) {
+				// The OS must save the YMM registers on context switches
+				const bool ymm_enabled = (_xgetbv(0) & 0x6) == 0x6;
+				__cpuidex(info, 7, 0);
+				avx2 = ymm_enabled && (info[1] & (1 << 5)) != 0;
+			}
+#  endif
+		}
+	};
+
+	const X86Features& GetX86Features() {
+		static X86Features features;
+		return features;
+	}
+#endif
+}
+
+bool CpuFeatures::HasSSE2() {
+#if defined(EP_SIMD_X86)
+	return GetX86Features().sse2;
+#else
+	return false;
+#endif
+}
+
+bool CpuFeatures::HasAVX2() {
+#if defined(EP_SIMD_X86)
+	return GetX86Features().avx2;
+#else
+	return false;
+#endif
+}
+
+bool CpuFeatures::HasNEON() {
+#if defined(EP_SIMD_NEON)
+	return true;
+#else
+	return false;
+#endif
+}
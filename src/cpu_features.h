@@ -0,0 +1,57 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_CPU_FEATURES_H
+#define EP_CPU_FEATURES_H
+
+/**
+ * Compile time detection of the SIMD instruction sets the Player has kernels for.
+ *
+ * EP_SIMD_X86: SSE2 and AVX2 kernels are compiled, usage is decided at runtime.
+ * EP_SIMD_NEON: NEON kernels are compiled, NEON is part of the target baseline.
+ */
+#if (defined(__GNUC__) || defined(_MSC_VER)) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && !defined(EMSCRIPTEN)
+#  define EP_SIMD_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || (defined(_MSC_VER) && defined(_M_ARM64))
+#  define EP_SIMD_NEON 1
+#endif
+
+/**
+ * Marks a function as compiled for a specific instruction set.
+ * Such functions must only be invoked when CpuFeatures reports support.
+ */
+#if defined(EP_SIMD_X86) && defined(__GNUC__)
+#  define EP_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define EP_TARGET(isa)
+#endif
+
+/**
+ * Runtime detection of CPU features.
+ */
+namespace CpuFeatures {
+	/** @return Whether SSE2 instructions are supported */
+	bool HasSSE2();
+
+	/** @return Whether AVX2 instructions are supported (by the CPU and the OS) */
+	bool HasAVX2();
+
+	/** @return Whether NEON instructions are supported */
+	bool HasNEON();
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "damage_tracker.h"
+
+namespace {
+	int Area(const Rect& rect) {
+		return rect.width * rect.height;
+	}
+}
+
+Rect DamageTracker::Union(const Rect& a, const Rect& b) {
+	if (a.IsEmpty()) {
+		return b;
+	}
+	if (b.IsEmpty()) {
+		return a;
+	}
+
+	const int x0 = std::min(a.x, b.x);
+	const int y0 = std::min(a.y, b.y);
+	const int x1 = std::max(a.x + a.width, b.x + b.width);
+	const int y1 = std::max(a.y + a.height, b.y + b.height);
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+void DamageTracker::SetSize(int width, int height) {
+	this->width = width;
+	this->height = height;
+	full_rects.assign(1, GetScreenRect());
+	SetFull();
+}
+
+void DamageTracker::Add(Rect rect) {
+	if (full) {
+		return;
+	}
+
+	rect.Adjust(GetScreenRect());
+	if (rect.IsEmpty()) {
+		return;
+	}
+
+	rects.push_back(rect);
+	Merge(rects.size() - 1);
+
+	while (static_cast<int>(rects.size()) > max_rects) {
+		// Merge the pair that grows the least
+		size_t best_a = 0;
+		size_t best_b = 1;
+		int best_growth = -1;
+		for (size_t a = 0; a < rects.size(); ++a) {
+			for (size_t b = a + 1; b < rects.size(); ++b) {
+				const int growth = Area(Union(rects[a], rects[b])) - Area(rects[a]) - Area(rects[b]);
+				if (best_growth < 0 || growth < best_growth) {
+					best_a = a;
+					best_b = b;
+					best_growth = growth;
+				}
+			}
+		}
+		rects[best_a] = Union(rects[best_a], rects[best_b]);
+		rects.erase(rects.begin() + best_b);
+		Merge(best_a);
+	}
+}
+
+void DamageTracker::Merge(size_t index) {
+	// Overlapping rects are drawn twice, replace them with their union
+	for (size_t i = 0; i < rects.size();) {
+		if (i != index && !rects[i].IsOutOfBounds(rects[index])) {
+			rects[index] = Union(rects[index], rects[i]);
+			rects.erase(rects.begin() + i);
+			if (i < index) {
+				--index;
+			}
+			i = 0;
+			continue;
+		}
+		++i;
+	}
+}
+
+void DamageTracker::SetFull() {
+	full = true;
+	rects.clear();
+}
+
+void DamageTracker::Clear() {
+	full = false;
+	rects.clear();
+}
+
+bool DamageTracker::IsFull() const {
+	if (full) {
+		return true;
+	}
+
+	int area = 0;
+	for (const auto& rect: rects) {
+		area += Area(rect);
+	}
+	return area * 4 >= width * height * 3;
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_DAMAGE_TRACKER_H
+#define EP_DAMAGE_TRACKER_H
+
+// Headers
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "rect.h"
+
+/**
+ * Collects the regions of the screen that must be redrawn.
+ *
+ * Drawables report the area they covered in the last frame and the area
+ * they cover now when they changed. The rects are merged when they overlap
+ * and their number is kept small because every rect is drawn and uploaded
+ * separately.
+ */
+class DamageTracker {
+public:
+	/** Most rects kept apart, more are merged */
+	static constexpr int max_rects = 8;
+
+	/**
+	 * Sets the size of the screen and marks the whole screen as damaged.
+	 *
+	 * @param width screen width
+	 * @param height screen height
+	 */
+	void SetSize(int width, int height);
+
+	/**
+	 * Adds a damaged area.
+	 *
+	 * @param rect area, the part outside of the screen is ignored
+	 */
+	void Add(Rect rect);
+
+	/** Marks the whole screen as damaged */
+	void SetFull();
+
+	/** Forgets all damage, e.g. after the damage was redrawn */
+	void Clear();
+
+	/** @return true when nothing is damaged */
+	bool IsEmpty() const;
+
+	/**
+	 * The whole screen is redrawn when most of it is damaged because
+	 * drawing many rects is slower than a single redraw.
+	 *
+	 * @return true when the whole screen must be redrawn
+	 */
+	bool IsFull() const;
+
+	/** @return damaged rects, the screen rect when the damage is full */
+	const std::vector<Rect>& GetRects() const;
+
+	/** @return screen rect */
+	Rect GetScreenRect() const;
+
+	/**
+	 * @param a rect
+	 * @param b rect
+	 * @return smallest rect containing both rects, empty rects are ignored
+	 */
+	static Rect Union(const Rect& a, const Rect& b);
+
+private:
+	void Merge(size_t index);
+
+	std::vector<Rect> rects;
+	std::vector<Rect> full_rects;
+	int width = 0;
+	int height = 0;
+	bool full = true;
+};
+
+/**
+ * Fingerprint of everything that affects how a drawable looks.
+ * Two frames with the same fingerprint draw the same pixels.
+ */
+class DrawStateHash {
+public:
+	/**
+	 * Adds a value to the fingerprint.
+	 *
+	 * @param value number, enum or struct without padding
+	 * @return this
+	 */
+	template <typename T>
+	DrawStateHash& Add(const T& value);
+
+	/** @return fingerprint */
+	uint64_t Get() const;
+
+private:
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+};
+
+inline bool DamageTracker::IsEmpty() const {
+	return !full && rects.empty();
+}
+
+inline Rect DamageTracker::GetScreenRect() const {
+	return { 0, 0, width, height };
+}
+
+inline const std::vector<Rect>& DamageTracker::GetRects() const {
+	return IsFull() ? full_rects : rects;
+}
+
+template <typename T>
+inline DrawStateHash& DrawStateHash::Add(const T& value) {
+	static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be hashed");
+	unsigned char bytes[sizeof(T)];
+	std::memcpy(bytes, &value, sizeof(T));
+	for (auto byte: bytes) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return *this;
+}
+
+inline uint64_t DrawStateHash::Get() const {
+	return hash;
+}
+
+#endif
@@ -24,8 +24,11 @@ Drawable::~Drawable() {
 }
 
 void Drawable::SetZ(Z_t nz) {
-	if (_z != nz) DrawableMgr::OnUpdateZ(this);
+	if (_z == nz) {
+		return;
+	}
 	_z = nz;
+	DrawableMgr::OnUpdateZ(this);
 }
 
 Drawable::Z_t Drawable::GetPriorityForMapLayer(int which) {
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <memory>
+#include "rect.h"
 
 class Bitmap;
 class Drawable;
@@ -57,6 +58,44 @@ public:
 
 	virtual void Draw(Bitmap& dst) = 0;
 
+	/**
+	 * Used by the band renderer instead of Draw: Runs the part of Draw
+	 * that modifies state. Called on the render thread in z order.
+	 *
+	 * @return true when DrawPrepared only reads state and can be called
+	 *         concurrently for different bands of the screen
+	 */
+	virtual bool PrepareDraw();
+
+	/**
+	 * Draws after PrepareDraw. When PrepareDraw returned true dst is a
+	 * clipped view of the screen and this is called from several threads.
+	 *
+	 * @param dst destination bitmap
+	 */
+	virtual void DrawPrepared(Bitmap& dst);
+
+	/**
+	 * Whether the drawable reports its damage with GetDrawState. While an
+	 * untracked drawable is visible the whole screen is redrawn every frame.
+	 *
+	 * @return true when GetDrawState is implemented
+	 */
+	virtual bool TracksDamage() const;
+
+	/**
+	 * Used for partial screen updates, called after PrepareDraw.
+	 * When the returned state or the bounds differ from the last frame the
+	 * old and the new bounds are redrawn. Only the drawables intersecting a
+	 * redrawn rect are drawn, with DrawPrepared on a view clipped to the
+	 * rect, so DrawPrepared must draw the same every time it is called in
+	 * a frame.
+	 *
+	 * @param bounds set to the screen area the drawable draws on
+	 * @return fingerprint of everything that affects the drawing, see DrawStateHash
+	 */
+	virtual uint64_t GetDrawState(Rect& bounds);
+
 	Z_t GetZ() const;
 
 	void SetZ(Z_t z);
@@ -114,10 +153,19 @@ public:
 	 */
 	static Z_t GetPriorityForBattleLayer(int which);
 private:
+	friend class DrawableList;
+
 	Z_t _z = 0;
 	Flags _flags = Flags::Default;
 	int render_ox = 0;
 	int render_oy = 0;
+	/** Slot in the DrawableList, maintained by the list */
+	uint32_t _list_index = 0;
+	uint8_t _list_layer = 0;
+	/** Bounds and state of the last partial update, maintained by the list */
+	bool _damage_valid = false;
+	Rect _damage_rect;
+	uint64_t _damage_state = 0;
 };
 
 inline Drawable::Flags operator|(Drawable::Flags l, Drawable::Flags r) {
@@ -142,6 +190,23 @@ inline Drawable::Drawable(Z_t z, Flags flags)
 {
 }
 
+inline bool Drawable::PrepareDraw() {
+	return false;
+}
+
+inline void Drawable::DrawPrepared(Bitmap& dst) {
+	Draw(dst);
+}
+
+inline bool Drawable::TracksDamage() const {
+	return false;
+}
+
+inline uint64_t Drawable::GetDrawState(Rect& bounds) {
+	bounds = {};
+	return 0;
+}
+
 inline Drawable::Z_t Drawable::GetZ() const {
 	return _z;
 }
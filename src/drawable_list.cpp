@@ -18,13 +18,27 @@
 // Headers
 #include "drawable_list.h"
 #include "drawable_mgr.h"
+#include "band_renderer.h"
+#include "bitmap.h"
+#include "damage_tracker.h"
 #include <algorithm>
 #include <cassert>
 
+// More pending rects than this are a full redraw
+static constexpr size_t max_pending_damage = 64;
+
 static bool DrawCmp(Drawable* l, Drawable* r) {
 	return l->GetZ() < r->GetZ();
 }
 
+static const auto EntryCmp = [](const auto& l, Drawable::Z_t z) {
+	return l.z < z;
+};
+
+static const auto EntryCmpUpper = [](Drawable::Z_t z, const auto& r) {
+	return z < r.z;
+};
+
 DrawableList::~DrawableList() {
 	if (DrawableMgr::GetLocalListPtr() == this) {
 		DrawableMgr::SetLocalList(nullptr);
@@ -32,82 +46,391 @@ DrawableList::~DrawableList() {
 }
 
 void DrawableList::Clear() {
-	_list.clear();
+	for (auto& layer: _layers) {
+		layer.entries.clear();
+		layer.holes = 0;
+	}
+	_size = 0;
 	SetClean();
+
+	_damage.clear();
+	_damage_full = true;
 }
 
 bool DrawableList::IsSorted() const {
-	return std::is_sorted(_list.begin(), _list.end(), DrawCmp);
+	return std::is_sorted(begin(), end(), DrawCmp);
 }
 
 void DrawableList::Sort() {
+	std::vector<Entry> entries;
+	entries.reserve(_size);
+
+	for (auto* drawable: *this) {
+		entries.push_back({ drawable->GetZ(), drawable });
+	}
+
 	// stable sort to work around a flickering event sprite issue when
 	// the map is scrolling (have same Z value)
-	std::stable_sort(_list.begin(), _list.end(), DrawCmp);
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& l, const Entry& r) { return l.z < r.z; });
+
+	for (auto& layer: _layers) {
+		layer.entries.clear();
+		layer.holes = 0;
+	}
+
+	for (auto& entry: entries) {
+		const int layer = GetLayer(entry.z);
+		auto& lentries = _layers[layer].entries;
+		entry.drawable->_list_layer = static_cast<uint8_t>(layer);
+		entry.drawable->_list_index = static_cast<uint32_t>(lentries.size());
+		lentries.push_back(entry);
+	}
+
 	SetClean();
 }
 
 void DrawableList::Append(Drawable* ptr) {
 	assert(ptr != nullptr);
-	assert(_list.end() == std::find(_list.begin(), _list.end(), ptr));
-
-	const bool ordered = _list.empty() || !DrawCmp(ptr, _list.back());
+	assert(!Contains(ptr));
 
-	_list.push_back(ptr);
-
-	if (!ordered) {
-		SetDirty();
+	if (IsDirty()) {
+		// Sorted on the next Draw anyway
+		PushBack(ptr);
+	} else {
+		Insert(ptr, true);
 	}
 }
 
 Drawable* DrawableList::Take(Drawable* ptr) {
-	auto iter = std::find(_list.begin(), _list.end(), ptr);
-	if (iter == _list.end()) {
+	if (!Contains(ptr)) {
 		return nullptr;
 	}
 
-	auto ret = *iter;
-	// FIXME: Can we remove this O(N) operation here?
-	_list.erase(iter);
-	return ret;
+	AddDamage(ptr);
+	Remove(ptr->_list_layer, ptr->_list_index);
+	return ptr;
 
 	// Removing doesn't change sorted order, so not dirty flag.
 }
 
+void DrawableList::UpdateZ(Drawable* ptr) {
+	if (IsDirty() || !Contains(ptr)) {
+		return;
+	}
+
+	const int layer = ptr->_list_layer;
+	const size_t index = ptr->_list_index;
+	auto& entries = _layers[layer].entries;
+
+	const auto old_z = entries[index].z;
+	const auto new_z = ptr->GetZ();
+	if (old_z == new_z) {
+		return;
+	}
+
+	// The drawable is now drawn in a different order
+	AddDamage(ptr);
+
+	// A stable sort keeps the drawable in front of the drawables with the
+	// new z when it moves up and behind them when it moves down
+	const bool behind_equal = new_z < old_z;
+
+	if (GetLayer(new_z) != layer) {
+		Remove(layer, index);
+		Insert(ptr, behind_equal);
+		return;
+	}
+
+	const auto iter = entries.begin() + index;
+	if (behind_equal) {
+		auto pos = std::upper_bound(entries.begin(), iter, new_z, EntryCmpUpper);
+		std::move_backward(pos, iter, iter + 1);
+		*pos = { new_z, ptr };
+		SetIndices(layer, pos - entries.begin(), index + 1);
+	} else {
+		auto pos = std::lower_bound(iter + 1, entries.end(), new_z, EntryCmp);
+		std::move(iter + 1, pos, iter);
+		*(pos - 1) = { new_z, ptr };
+		SetIndices(layer, index, pos - entries.begin());
+	}
+}
+
 void DrawableList::TakeFrom(DrawableList& other) noexcept {
 	if (&other == this) { return; }
 
-	auto& olist = other._list;
-
-	if (olist.empty()) {
+	if (other.empty()) {
 		return;
 	}
 
-	_list.insert(_list.end(), olist.begin(), olist.end());
-	olist.clear();
+	for (auto* drawable: other) {
+		PushBack(drawable);
+	}
+	other.Clear();
 
 	SetDirty();
-	other.SetClean();
 }
 
-void DrawableList::Draw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z) {
+void DrawableList::PushBack(Drawable* ptr) {
+	const int layer = GetLayer(ptr->GetZ());
+	auto& entries = _layers[layer].entries;
+
+	ptr->_list_layer = static_cast<uint8_t>(layer);
+	ptr->_list_index = static_cast<uint32_t>(entries.size());
+	ptr->_damage_valid = false;
+	entries.push_back({ ptr->GetZ(), ptr });
+	++_size;
+}
+
+void DrawableList::Insert(Drawable* ptr, bool behind_equal) {
+	const auto z = ptr->GetZ();
+	const int layer = GetLayer(z);
+	auto& entries = _layers[layer].entries;
+
+	if (entries.empty() || entries.back().z < z || (behind_equal && entries.back().z == z)) {
+		PushBack(ptr);
+		return;
+	}
+
+	auto pos = behind_equal
+		? std::upper_bound(entries.begin(), entries.end(), z, EntryCmpUpper)
+		: std::lower_bound(entries.begin(), entries.end(), z, EntryCmp);
+	const size_t index = pos - entries.begin();
+
+	ptr->_damage_valid = false;
+	entries.insert(pos, { z, ptr });
+	SetIndices(layer, index, entries.size());
+	++_size;
+}
+
+void DrawableList::Remove(int layer, size_t index) {
+	auto& l = _layers[layer];
+	auto& entries = l.entries;
+
+	// Leave a hole behind, so the slots of the other drawables stay valid
+	entries[index].drawable = nullptr;
+	++l.holes;
+	--_size;
+
+	while (!entries.empty() && entries.back().drawable == nullptr) {
+		entries.pop_back();
+		--l.holes;
+	}
+
+	// Compacting when half of the slots are holes keeps removal amortized O(1)
+	if (l.holes * 2 > entries.size()) {
+		Compact(layer);
+	}
+}
+
+void DrawableList::Compact(int layer) {
+	auto& l = _layers[layer];
+	auto& entries = l.entries;
+
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& e) { return e.drawable == nullptr; }), entries.end());
+	l.holes = 0;
+	SetIndices(layer, 0, entries.size());
+}
+
+void DrawableList::SetIndices(int layer, size_t first, size_t last) {
+	auto& entries = _layers[layer].entries;
+	for (size_t i = first; i < last; ++i) {
+		if (entries[i].drawable) {
+			entries[i].drawable->_list_layer = static_cast<uint8_t>(layer);
+			entries[i].drawable->_list_index = static_cast<uint32_t>(i);
+		}
+	}
+}
+
+void DrawableList::Draw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z, BandRenderer* renderer) {
 	if (IsDirty()) {
 		Sort();
 	} else {
 		assert(IsSorted());
 	}
 
-	for (auto* drawable : _list) {
-		auto z = drawable->GetZ();
-		if (z < min_z) {
-			continue;
+	if (renderer) {
+		renderer->Begin(dst);
+	}
+
+	const int first_layer = GetLayer(min_z);
+	const int last_layer = GetLayer(max_z);
+
+	for (int layer = first_layer; layer <= last_layer; ++layer) {
+		const auto& entries = _layers[layer].entries;
+
+		size_t i = 0;
+		if (layer == first_layer) {
+			i = std::lower_bound(entries.begin(), entries.end(), min_z, EntryCmp) - entries.begin();
+		}
+
+		// Indices instead of iterators, drawing may add drawables to the list
+		for (; i < entries.size(); ++i) {
+			const auto& entry = entries[i];
+			if (entry.z > max_z) {
+				break;
+			}
+			auto* drawable = entry.drawable;
+			if (drawable && drawable->IsVisible()) {
+				if (renderer) {
+					renderer->Draw(*drawable);
+				} else {
+					drawable->Draw(dst);
+				}
+			}
+		}
+	}
+
+	if (renderer) {
+		renderer->End();
+	}
+}
+
+void DrawableList::DrawDamage(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z, DamageTracker& damage,
+		const std::function<void(Bitmap&)>& background, BandRenderer* renderer) {
+	if (IsDirty()) {
+		Sort();
+		damage.SetFull();
+	}
+
+	if (_damage_full) {
+		damage.SetFull();
+	} else {
+		for (const auto& rect: _damage) {
+			damage.Add(rect);
+		}
+	}
+	_damage.clear();
+	_damage_full = false;
+
+	const int first_layer = GetLayer(min_z);
+	const int last_layer = GetLayer(max_z);
+
+	auto in_range = [&](const Entry& entry) {
+		return entry.z >= min_z && entry.z <= max_z && entry.drawable->IsVisible();
+	};
+
+	if (!damage.IsFull()) {
+		for (int layer = first_layer; layer <= last_layer; ++layer) {
+			for (const auto& entry: _layers[layer].entries) {
+				if (entry.drawable && in_range(entry) && !entry.drawable->TracksDamage()) {
+					damage.SetFull();
+					break;
+				}
+			}
+		}
+	}
+
+	if (damage.IsFull()) {
+		background(dst);
+		Draw(dst, min_z, max_z, renderer);
+		StoreDrawState(min_z, max_z, damage.GetScreenRect());
+		return;
+	}
+
+	// Compare the drawables with the last frame, drawables that are not
+	// drawn anymore damage the area they covered
+	_damage_drawables.clear();
+
+	for (int layer = 0; layer < num_layers; ++layer) {
+		// Indices instead of iterators, preparing may add drawables to the list
+		for (size_t i = 0; i < _layers[layer].entries.size(); ++i) {
+			const auto entry = _layers[layer].entries[i];
+			auto* drawable = entry.drawable;
+			if (!drawable) {
+				continue;
+			}
+
+			if (!in_range(entry) || !drawable->TracksDamage()) {
+				AddDamage(drawable);
+				drawable->_damage_rect = {};
+				drawable->_damage_valid = true;
+				continue;
+			}
+
+			drawable->PrepareDraw();
+
+			Rect bounds;
+			const auto state = drawable->GetDrawState(bounds);
+			if (!drawable->_damage_valid || state != drawable->_damage_state || bounds != drawable->_damage_rect) {
+				if (drawable->_damage_valid) {
+					damage.Add(drawable->_damage_rect);
+				}
+				damage.Add(bounds);
+			}
+
+			drawable->_damage_valid = true;
+			drawable->_damage_rect = bounds;
+			drawable->_damage_state = state;
+			_damage_drawables.push_back(drawable);
 		}
-		if (z > max_z) {
-			break;
+	}
+
+	// Drawables that were hidden or left the z range
+	if (_damage_full) {
+		damage.SetFull();
+	} else {
+		for (const auto& rect: _damage) {
+			damage.Add(rect);
 		}
-		if (drawable->IsVisible()) {
-			drawable->Draw(dst);
+	}
+	_damage.clear();
+	_damage_full = false;
+
+	if (damage.IsEmpty()) {
+		return;
+	}
+
+	if (damage.IsFull()) {
+		background(dst);
+		Draw(dst, min_z, max_z, renderer);
+		StoreDrawState(min_z, max_z, damage.GetScreenRect());
+		return;
+	}
+
+	for (const auto& rect: damage.GetRects()) {
+		auto view = dst.CreateClippedView(rect);
+		background(*view);
+
+		for (auto* drawable: _damage_drawables) {
+			if (!drawable->_damage_rect.IsOutOfBounds(rect)) {
+				drawable->DrawPrepared(*view);
+			}
 		}
 	}
 }
 
+void DrawableList::AddDamage(const Drawable* drawable) {
+	if (_damage_full || !drawable->_damage_valid || drawable->_damage_rect.IsEmpty()) {
+		return;
+	}
+
+	if (_damage.size() >= max_pending_damage) {
+		_damage.clear();
+		_damage_full = true;
+		return;
+	}
+
+	_damage.push_back(drawable->_damage_rect);
+}
+
+void DrawableList::StoreDrawState(Drawable::Z_t min_z, Drawable::Z_t max_z, const Rect& screen_rect) {
+	_damage.clear();
+	_damage_full = false;
+
+	for (auto* drawable: *this) {
+		drawable->_damage_valid = true;
+		drawable->_damage_state = 0;
+		drawable->_damage_rect = {};
+
+		if (drawable->GetZ() < min_z || drawable->GetZ() > max_z || !drawable->IsVisible()) {
+			continue;
+		}
+
+		if (drawable->TracksDamage()) {
+			drawable->_damage_state = drawable->GetDrawState(drawable->_damage_rect);
+		} else {
+			// Removing it redraws the whole screen
+			drawable->_damage_rect = screen_rect;
+		}
+	}
+}
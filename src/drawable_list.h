@@ -19,23 +19,61 @@
 #define EP_DRAWABLE_LIST_H
 
 #include "drawable.h"
+#include <array>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <vector>
 #include <limits>
 
+class BandRenderer;
+class DamageTracker;
+
 /** A list of Drawable objects. These are used by the graphics engine store and
  * to render all drawable objects.
+ *
+ * The drawables are kept in one bucket per priority layer (the upper 8 bit of z).
+ * Every drawable knows its slot in the bucket, removal only leaves a hole behind
+ * and a z change moves the drawable to its new place without sorting the list.
  */
 class DrawableList {
 	public:
+		/** Number of priority layers, see Priority */
+		static constexpr int num_layers = 1 << (64 - z_offset);
+
 		/** Default Constructor */
 		DrawableList() = default;
 		DrawableList(const DrawableList&) = delete;
 		DrawableList& operator=(const DrawableList&) = delete;
 		~DrawableList();
 
-		/** Iterator type */
-		using iterator = std::vector<Drawable*>::const_iterator;
+		/** Iterator type, visits the drawables in z order */
+		class iterator {
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = Drawable*;
+				using difference_type = std::ptrdiff_t;
+				using pointer = Drawable* const*;
+				using reference = Drawable* const&;
+
+				iterator() = default;
+
+				reference operator*() const;
+				iterator& operator++();
+				iterator operator++(int);
+
+				bool operator==(const iterator& other) const;
+				bool operator!=(const iterator& other) const;
+
+			private:
+				friend class DrawableList;
+				iterator(const DrawableList* list, int layer);
+				void SkipHoles();
+
+				const DrawableList* list = nullptr;
+				int layer = num_layers;
+				size_t index = 0;
+		};
 
 		/** Sorts the drawables and clears the dirty flag.  */
 		void Sort();
@@ -45,6 +83,7 @@ class DrawableList {
 
 		/**
 		 * Add a drawable to the list.
+		 * The drawable is inserted behind all drawables with the same or a lower z.
 		 *
 		 * @param drawable the Drawable to add
 		 */
@@ -54,7 +93,7 @@ class DrawableList {
 		void Clear();
 
 		/**
-		 * Searches for the given drawable, if found removes from the list and returns it.
+		 * If drawable is in the list, removes it and returns it.
 		 *
 		 * @param drawable the Drawable to remove.
 		 * @return drawable if drawable was in the list and removed.
@@ -62,7 +101,7 @@ class DrawableList {
 		Drawable* Take(Drawable* drawable);
 
 		/**
-		 * Searches for the given drawable, if found removes from the list and returns it.
+		 * If drawable is in the list, removes it and returns it.
 		 *
 		 * @param drawable the Drawable to remove.
 		 * @return drawable if drawable was in the list and removed.
@@ -70,6 +109,22 @@ class DrawableList {
 		template <typename T>
 		T* Take(std::enable_if_t<IsDrawable<T>,T*> drawable);
 
+		/**
+		 * @param drawable the Drawable to search
+		 * @return true if drawable is in the list
+		 */
+		bool Contains(const Drawable* drawable) const;
+
+		/**
+		 * Moves the drawable to the place of its new z value.
+		 * Called after the z value of the drawable changed. The drawable ends up
+		 * where sorting the list would put it. Does nothing when the drawable is
+		 * not in the list or the list is dirty.
+		 *
+		 * @param drawable the Drawable which z value changed
+		 */
+		void UpdateZ(Drawable* drawable);
+
 		/**
 		 * Remove all drawables from other and append them to this.
 		 *
@@ -93,27 +148,16 @@ class DrawableList {
 		void SetDirty();
 
 		/** @return an iterator to the beginning */
-		iterator begin() const { return _list.begin(); }
+		iterator begin() const { return iterator(this, 0); }
 
 		/** @return an iterator to the end */
-		iterator end() const { return _list.end(); }
-
-		/**
-		 * Return drawable at i'th index
-		 *
-		 * @param i index of drawable
-		 * @pre if i < 0 and i >= size(), the result is undefined.
-		 * @return the drawable at i
-		 */
-		Drawable* operator[](size_t i) const {
-			return _list[i];
-		}
+		iterator end() const { return iterator(); }
 
 		/** @return the number of drawables in the list */
-		size_t size() const { return _list.size(); }
+		size_t size() const { return _size; }
 
 		/** @return if the list is empty */
-		bool empty() const { return _list.empty(); }
+		bool empty() const { return _size == 0; }
 
 		/**
 		 * Sort the list if it's dirty, then call Draw() on every drawable in order.
@@ -128,14 +172,62 @@ class DrawableList {
 		 * @param dst The bitmap to draw onto
 		 * @param min_z Skip any drawables with z < min_z
 		 * @param max_z Skip any drawables with z > max_z
+		 * @param renderer When not null the drawables are drawn in bands on several threads
 		 */
-		void Draw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z);
+		void Draw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z, BandRenderer* renderer = nullptr);
+
+		/**
+		 * Sort the list if it's dirty, then redraw the parts of dst that changed since the last call.
+		 * The drawables report their changes with GetDrawState. Added and removed drawables and
+		 * drawables with a new z value damage their area. Everything is redrawn while a visible
+		 * drawable does not track its damage, after sorting and when most of the screen changed.
+		 *
+		 * @param dst The bitmap to draw onto, contains the result of the last call
+		 * @param min_z Skip any drawables with z < min_z
+		 * @param max_z Skip any drawables with z > max_z
+		 * @param damage Damage from elsewhere, e.g. full when dst was modified. Contains the redrawn rects afterwards
+		 * @param background Draws what is behind the drawables, receives a view clipped to the redrawn rect
+		 * @param renderer When not null and everything is redrawn the drawables are drawn in bands on several threads
+		 */
+		void DrawDamage(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z, DamageTracker& damage,
+			const std::function<void(Bitmap&)>& background, BandRenderer* renderer = nullptr);
 
 	private:
-		std::vector<Drawable*> _list;
+		/** Slot of a bucket, drawable is nullptr when the slot is a hole */
+		struct Entry {
+			Drawable::Z_t z;
+			Drawable* drawable;
+		};
+
+		/** Drawables of one priority layer, sorted by z unless the list is dirty */
+		struct Layer {
+			std::vector<Entry> entries;
+			size_t holes = 0;
+		};
+
+		std::array<Layer, num_layers> _layers;
+		size_t _size = 0;
 		bool _dirty = false;
 
+		/** Areas of removed drawables and of drawables with a new z value */
+		std::vector<Rect> _damage;
+		/** Everything is redrawn by the next DrawDamage */
+		bool _damage_full = true;
+		/** Drawables drawn by DrawDamage, kept to reuse the memory */
+		std::vector<Drawable*> _damage_drawables;
+
 		void SetClean();
+
+		void AddDamage(const Drawable* drawable);
+		void StoreDrawState(Drawable::Z_t min_z, Drawable::Z_t max_z, const Rect& screen_rect);
+
+		static int GetLayer(Drawable::Z_t z);
+
+		void PushBack(Drawable* drawable);
+		void Insert(Drawable* drawable, bool behind_equal);
+		void Remove(int layer, size_t index);
+		void Compact(int layer);
+		void SetIndices(int layer, size_t first, size_t last);
 };
 
 template <typename T>
@@ -148,29 +240,27 @@ template <typename F>
 void DrawableList::TakeFrom(DrawableList& other, F&& cond) noexcept {
 	if (&other == this) { return; }
 
-	auto& olist = other._list;
-
-	int shift = 0;
-	const auto end = olist.end();
-	for (auto iter = olist.begin(); iter != end - shift;) {
-		if (shift) {
-			*iter = std::move(*(iter + shift));
+	for (int layer = 0; layer < num_layers; ++layer) {
+		auto& olayer = other._layers[layer];
+
+		for (auto& entry: olayer.entries) {
+			auto* draw = entry.drawable;
+			if (draw && cond(draw)) {
+				entry.drawable = nullptr;
+				++olayer.holes;
+				--other._size;
+				PushBack(draw);
+			}
 		}
 
-		auto* draw = *iter;
-
-		if (cond(draw)) {
-			_list.push_back(draw);
-			++shift;
-			continue;
+		if (olayer.holes > 0) {
+			other.Compact(layer);
 		}
-
-		++iter;
 	}
-	olist.resize(olist.size() - shift);
 
 	SetDirty();
-	if (olist.empty()) {
+	other._damage_full = true;
+	if (other.empty()) {
 		other.SetClean();
 	}
 }
@@ -187,8 +277,60 @@ inline void DrawableList::SetClean() {
 	_dirty = false;
 }
 
+inline int DrawableList::GetLayer(Drawable::Z_t z) {
+	return static_cast<int>(z >> z_offset);
+}
+
+inline bool DrawableList::Contains(const Drawable* drawable) const {
+	const auto& entries = _layers[drawable->_list_layer].entries;
+	return drawable->_list_index < entries.size() && entries[drawable->_list_index].drawable == drawable;
+}
+
 inline void DrawableList::Draw(Bitmap& dst) {
 	Draw(dst, std::numeric_limits<Drawable::Z_t>::min(), std::numeric_limits<Drawable::Z_t>::max());
 }
 
+inline DrawableList::iterator::iterator(const DrawableList* list, int layer)
+	: list(list), layer(layer)
+{
+	SkipHoles();
+}
+
+inline DrawableList::iterator::reference DrawableList::iterator::operator*() const {
+	return list->_layers[layer].entries[index].drawable;
+}
+
+inline DrawableList::iterator& DrawableList::iterator::operator++() {
+	++index;
+	SkipHoles();
+	return *this;
+}
+
+inline DrawableList::iterator DrawableList::iterator::operator++(int) {
+	auto iter = *this;
+	++(*this);
+	return iter;
+}
+
+inline bool DrawableList::iterator::operator==(const iterator& other) const {
+	return layer == other.layer && index == other.index;
+}
+
+inline bool DrawableList::iterator::operator!=(const iterator& other) const {
+	return !(*this == other);
+}
+
+inline void DrawableList::iterator::SkipHoles() {
+	for (; layer < num_layers; ++layer, index = 0) {
+		const auto& entries = list->_layers[layer].entries;
+		while (index < entries.size() && entries[index].drawable == nullptr) {
+			++index;
+		}
+		if (index < entries.size()) {
+			return;
+		}
+	}
+	index = 0;
+}
+
 #endif
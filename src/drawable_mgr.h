@@ -47,8 +47,8 @@ inline DrawableList* DrawableMgr::GetLocalListPtr() {
 	return _local;
 }
 
-inline void DrawableMgr::OnUpdateZ(Drawable* /* drawable */) {
-	GetLocalList().SetDirty();
+inline void DrawableMgr::OnUpdateZ(Drawable* drawable) {
+	GetLocalList().UpdateZ(drawable);
 }
 
 #endif
@@ -50,9 +50,14 @@
 #include "cache.h"
 #include "player.h"
 #include "compiler.h"
+#include "glyph_atlas.h"
+#include "lru_cache.h"
 
 // Static variables.
 namespace {
+	// Number of measured strings cached per font
+	constexpr size_t text_layout_limit = 512;
+
 	template <typename T>
 	BitmapFontGlyph const* find_glyph(const T& glyphset, char32_t code) {
 		auto iter = std::lower_bound(std::begin(glyphset), std::end(glyphset), code);
@@ -132,6 +137,9 @@ namespace {
 #ifdef HAVE_FREETYPE
 	FT_Library library = nullptr;
 
+	// Number of shaped strings cached per font
+	constexpr size_t shape_cache_limit = 256;
+
 	struct FTFont final : public Font  {
 		FTFont(Filesystem_Stream::InputStream is, int size, bool bold, bool italic);
 		~FTFont() override;
@@ -157,9 +165,15 @@ namespace {
 		/** Workaround for bad kerning in RM2000 and RMG2000 fonts */
 		bool rm2000_workaround = false;
 
+		/** Rendered glyphs, keyed by glyph index and size */
+		mutable GlyphAtlas glyph_atlas;
+
 #ifdef HAVE_HARFBUZZ
 		hb_buffer_t* hb_buffer = nullptr;
 		hb_font_t* hb_font = nullptr;
+
+		/** Shaping results of recently drawn strings, the first character of the key is the size */
+		mutable LruCache<std::u32string, std::vector<ShapeRet>> shape_cache { shape_cache_limit };
 #endif
 	}; // class FTFont
 #endif
@@ -263,7 +277,7 @@ Font::GlyphRet BitmapFont::vRender(char32_t glyph) const {
 		for (size_t x_ = 0; x_ < width; ++x_)
 			data[y_ * pitch + x_] = (bm_glyph->data[y_] & (0x1 << x_)) ? 255 : 0;
 
-	return { glyph_bm, {width, 0}, {0, 0} };
+	return { glyph_bm, {width, 0}, {0, 0}, false, glyph_bm->GetRect() };
 }
 
 #ifdef HAVE_FREETYPE
@@ -403,6 +417,10 @@ Font::GlyphRet FTFont::vRenderShaped(char32_t glyph) const {
 		}
 	}
 
+	if (auto* cached = glyph_atlas.Find(glyph, current_style.size)) {
+		return *cached;
+	}
+
 	auto render_glyph = [&](auto flags, auto mode) {
 		if (FT_Load_Glyph(face, glyph, flags) != FT_Err_Ok) {
 			Output::Debug("Couldn't load FreeType character {:#x}", uint32_t(glyph));
@@ -479,7 +497,8 @@ Font::GlyphRet FTFont::vRenderShaped(char32_t glyph) const {
 		advance.x = 6;
 	}
 
-	return { bm, advance, offset, has_color };
+	// The atlas copies the glyph, this also detaches color glyphs from the FreeType buffer
+	return glyph_atlas.Insert(glyph, current_style.size, { bm, advance, offset, has_color, bm->GetRect() });
 }
 
 bool FTFont::vCanShape() const {
@@ -492,6 +511,15 @@ bool FTFont::vCanShape() const {
 
 #ifdef HAVE_HARFBUZZ
 std::vector<Font::ShapeRet> FTFont::vShape(U32StringView txt) const {
+	std::u32string key;
+	key.reserve(txt.size() + 1);
+	key.push_back(static_cast<char32_t>(current_style.size));
+	key.append(txt.data(), txt.size());
+
+	if (auto* cached = shape_cache.Find(key)) {
+		return *cached;
+	}
+
 	hb_buffer_clear_contents(hb_buffer);
 
 	hb_buffer_add_utf32(hb_buffer, reinterpret_cast<const uint32_t*>(txt.data()), txt.size(), 0, txt.size());
@@ -525,7 +553,7 @@ std::vector<Font::ShapeRet> FTFont::vShape(U32StringView txt) const {
 		}
 	}
 
-	return ret;
+	return shape_cache.Insert(key, std::move(ret));
 }
 #endif
 
@@ -692,7 +720,7 @@ void Font::Dispose() {
 
 // Constructor.
 Font::Font(StringView name, int size, bool bold, bool italic)
-	: name(ToString(name))
+	: name(ToString(name)), text_layouts(text_layout_limit)
 {
 	original_style.size = size;
 	original_style.bold = bold;
@@ -762,7 +790,7 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 		return false;
 	}
 
-	auto rect = Rect(x, y, gret.bitmap->width(), gret.bitmap->height());
+	auto rect = Rect(x, y, gret.rect.width, gret.rect.height);
 	if (EP_UNLIKELY(rect.width == 0)) {
 		return false;
 	}
@@ -774,7 +802,7 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 	unsigned src_x = 0;
 	unsigned src_y = 0;
 
-	int glyph_height = gret.bitmap->height() - gret.offset.y;
+	int glyph_height = gret.rect.height - gret.offset.y;
 
 	// Adjust how the mask is applied depending on the glyph size to prevent that
 	// pixels from outside of the mask color are read
@@ -800,7 +828,7 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 			// First draw the shadow, offset by one
 			if (!gret.has_color && current_style.draw_shadow) {
 				auto shadow_rect = Rect(rect.x + 1, rect.y + 1, rect.width, rect.height);
-				dest.MaskedBlit(shadow_rect, *gret.bitmap, 0, 0, *sys_large, 0, 0);
+				dest.MaskedBlit(shadow_rect, *gret.bitmap, gret.rect.x, gret.rect.y, *sys_large, 0, 0);
 			}
 
 			src_x = current_style.size;
@@ -809,15 +837,15 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 
 		if (!gret.has_color) {
 			if (current_style.draw_gradient) {
-				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *sys_large, src_x, src_y);
+				dest.MaskedBlit(rect, *gret.bitmap, gret.rect.x, gret.rect.y, *sys_large, src_x, src_y);
 			} else {
 				auto col = sys.GetColorAt(current_style.color_offset.x + src_x, current_style.color_offset.y + src_y);
-				auto col_bm = Bitmap::Create(gret.bitmap->width(), gret.bitmap->height(), col);
-				dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *col_bm, 0, 0);
+				auto col_bm = Bitmap::Create(gret.rect.width, gret.rect.height, col);
+				dest.MaskedBlit(rect, *gret.bitmap, gret.rect.x, gret.rect.y, *col_bm, 0, 0);
 			}
 		} else {
 			// Color glyphs, emojis etc.
-			dest.Blit(rect.x, rect.y, *gret.bitmap, gret.bitmap->GetRect(), Opacity::Opaque());
+			dest.Blit(rect.x, rect.y, *gret.bitmap, gret.rect, Opacity::Opaque());
 		}
 
 		return true;
@@ -828,7 +856,7 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 		// First draw the shadow, offset by one
 		if (!gret.has_color && current_style.draw_shadow) {
 			auto shadow_rect = Rect(rect.x + 1, rect.y + 1, rect.width, rect.height);
-			dest.MaskedBlit(shadow_rect, *gret.bitmap, 0, 0, sys, 16, 32);
+			dest.MaskedBlit(shadow_rect, *gret.bitmap, gret.rect.x, gret.rect.y, sys, 16, 32);
 		}
 
 		src_x = color % 10 * 16 + 2;
@@ -848,15 +876,15 @@ bool Font::RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys,
 				src_y -= glyph_height - 12;
 			}
 
-			dest.MaskedBlit(rect, *gret.bitmap, 0, 0, sys, src_x, src_y);
+			dest.MaskedBlit(rect, *gret.bitmap, gret.rect.x, gret.rect.y, sys, src_x, src_y);
 		} else {
 			auto col = sys.GetColorAt(current_style.color_offset.x + src_x, current_style.color_offset.y + src_y);
-			auto col_bm = Bitmap::Create(gret.bitmap->width(), gret.bitmap->height(), col);
-			dest.MaskedBlit(rect, *gret.bitmap, 0, 0, *col_bm, 0, 0);
+			auto col_bm = Bitmap::Create(gret.rect.width, gret.rect.height, col);
+			dest.MaskedBlit(rect, *gret.bitmap, gret.rect.x, gret.rect.y, *col_bm, 0, 0);
 		}
 	} else {
 		// Color glyphs, emojis etc.
-		dest.Blit(rect.x, rect.y, *gret.bitmap, gret.bitmap->GetRect(), Opacity::Opaque());
+		dest.Blit(rect.x, rect.y, *gret.bitmap, gret.rect, Opacity::Opaque());
 	}
 
 	return true;
@@ -872,8 +900,8 @@ Point Font::Render(Bitmap& dest, int x, int y, Color const& color, char32_t glyp
 		return {};
 	}
 
-	auto rect = Rect(x, y, gret.bitmap->width(), gret.bitmap->height());
-	dest.MaskedBlit(rect, *gret.bitmap, 0, 0, color);
+	auto rect = Rect(x, y, gret.rect.width, gret.rect.height);
+	dest.MaskedBlit(rect, *gret.bitmap, gret.rect.x, gret.rect.y, color);
 
 	gret.advance.x += current_style.letter_spacing;
 
@@ -892,6 +920,23 @@ std::vector<Font::ShapeRet> Font::Shape(U32StringView text) const {
 
 void Font::SetFallbackFont(FontRef fallback_font) {
 	this->fallback_font = fallback_font;
+
+	// Glyphs that are not in this font are measured with the fallback font
+	text_layouts.Clear();
+}
+
+Font::TextLayout& Font::GetTextLayout(StringView text) const {
+	// The style settings that change the layout are appended to the text
+	std::string key;
+	key.reserve(text.size() + 2 * sizeof(int));
+	key.append(text.data(), text.size());
+	key.append(reinterpret_cast<const char*>(&current_style.size), sizeof(int));
+	key.append(reinterpret_cast<const char*>(&current_style.letter_spacing), sizeof(int));
+
+	if (auto* layout = text_layouts.Find(key)) {
+		return *layout;
+	}
+	return text_layouts.Insert(key, {});
 }
 
 bool Font::IsStyleApplied() const {
@@ -928,7 +973,7 @@ Font::GlyphRet ExFont::vRender(char32_t glyph) const {
 
 	if (!is_lower && !is_upper) {
 		// Invalid ExFont
-		return { bm, {WIDTH, 0}, {0, 0}, false };
+		return { bm, {WIDTH, 0}, {0, 0}, false, bm->GetRect() };
 	}
 
 	glyph = is_lower ? (glyph - 'a' + 26) : (glyph - 'A');
@@ -949,7 +994,7 @@ Font::GlyphRet ExFont::vRender(char32_t glyph) const {
 		}
 	}
 
-	return { bm, {WIDTH, 0}, {0, 0}, has_color };
+	return { bm, {WIDTH, 0}, {0, 0}, has_color, bm->GetRect() };
 }
 
 Rect ExFont::vGetSize(char32_t) const {
@@ -25,7 +25,9 @@
 #include "memory_management.h"
 #include "rect.h"
 #include "string_view.h"
+#include "lru_cache.h"
 #include <string>
+#include <vector>
 #include <lcf/scope_guard.h>
 
 class Color;
@@ -55,6 +57,8 @@ class Font {
 		Point offset;
 		/** When enabled the glyph is colored and not masked with the system graphic */
 		bool has_color = false;
+		/** Area of bitmap that contains the glyph */
+		Rect rect;
 	};
 
 	/** Contains metrics of a glyph shaped by Harfbuzz */
@@ -96,6 +100,32 @@ class Font {
 		int letter_spacing = 0;
 	};
 
+	/** Cached measurement and glyph positions of a string, used by Text */
+	struct TextLayout {
+		/** A glyph drawn by Text::Draw */
+		struct Glyph {
+			/** Codepoint, for shaped glyphs the shaping information */
+			ShapeRet shape = {};
+			/** x offset relative to the start of the string */
+			int x = 0;
+			/** Whether the glyph is drawn with the ExFont */
+			bool is_exfont = false;
+			/** Whether the glyph was shaped by Harfbuzz */
+			bool is_shaped = false;
+		};
+
+		/** Size of the string as returned by Text::GetSize */
+		Rect size;
+		/** Whether size is valid */
+		bool has_size = false;
+		/** Glyphs in drawing order */
+		std::vector<Glyph> glyphs;
+		/** How far the x offset advances after drawing the string */
+		int width = 0;
+		/** Whether glyphs and width are valid */
+		bool has_glyphs = false;
+	};
+
 	virtual ~Font() = default;
 
 	/**
@@ -195,6 +225,16 @@ class Font {
 	 */
 	void SetFallbackFont(FontRef fallback_font);
 
+	/**
+	 * Returns the cached layout of a string for the current style.
+	 * When the string is not cached an empty layout is added.
+	 * The reference is valid until the next call.
+	 *
+	 * @param text utf8 / exfont text
+	 * @return layout of the string
+	 */
+	TextLayout& GetTextLayout(StringView text) const;
+
 	using StyleScopeGuard = lcf::ScopeGuard<std::function<void()>>;
 
 	/**
@@ -264,6 +304,8 @@ class Font {
 	FontRef fallback_font;
 
 private:
+	mutable LruCache<std::string, TextLayout> text_layouts;
+
 	bool RenderImpl(Bitmap& dest, int const x, int const y, const Bitmap& sys, int color, const GlyphRet& gret) const;
 };
 
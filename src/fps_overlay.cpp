@@ -20,10 +20,12 @@
 #include "fps_overlay.h"
 #include "game_clock.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "utils.h"
 #include "input.h"
 #include "font.h"
 #include "drawable_mgr.h"
+#include "player.h"
 
 using namespace std::chrono_literals;
 
@@ -63,6 +65,51 @@ bool FpsOverlay::Update() {
 }
 
 void FpsOverlay::Draw(Bitmap& dst) {
+	Refresh();
+
+	if (draw_fps) {
+		dst.Blit(1, 2, *fps_bitmap, fps_rect, 255);
+	}
+
+	// Always drawn when speedup is on independent of FPS
+	if (last_speed_mod > 1) {
+		const Rect rect = GetSpeedupRect(dst.GetWidth());
+		dst.Blit(rect.x, rect.y, *speedup_bitmap, speedup_rect, 255);
+	}
+}
+
+bool FpsOverlay::PrepareDraw() {
+	Refresh();
+
+	return false;
+}
+
+bool FpsOverlay::TracksDamage() const {
+	return true;
+}
+
+uint64_t FpsOverlay::GetDrawState(Rect& bounds) {
+	bounds = {};
+	DrawStateHash state;
+
+	if (draw_fps) {
+		bounds = Rect(1, 2, fps_rect.width, fps_rect.height);
+		state.Add(fps_bitmap.get()).Add(fps_bitmap->GetRevision()).Add(fps_rect);
+	}
+
+	if (last_speed_mod > 1) {
+		bounds = DamageTracker::Union(bounds, GetSpeedupRect(Player::screen_width));
+		state.Add(speedup_bitmap.get()).Add(speedup_bitmap->GetRevision()).Add(speedup_rect);
+	}
+
+	return state.Get();
+}
+
+Rect FpsOverlay::GetSpeedupRect(int screen_width) const {
+	return { screen_width - speedup_rect.width - 1, 2, speedup_rect.width, speedup_rect.height };
+}
+
+void FpsOverlay::Refresh() {
 	if (draw_fps) {
 		if (fps_dirty) {
 			std::string text = GetFpsString();
@@ -80,11 +127,8 @@ void FpsOverlay::Draw(Bitmap& dst) {
 
 			fps_dirty = false;
 		}
-
-		dst.Blit(1, 2, *fps_bitmap, fps_rect, 255);
 	}
 
-	// Always drawn when speedup is on independent of FPS
 	if (last_speed_mod > 1) {
 		if (speedup_dirty) {
 			std::string text = "> x" + std::to_string(last_speed_mod);
@@ -103,9 +147,6 @@ void FpsOverlay::Draw(Bitmap& dst) {
 
 			speedup_dirty = false;
 		}
-
-		int dwidth = dst.GetWidth();
-		dst.Blit(dwidth - speedup_rect.width - 1, 2, *speedup_bitmap, speedup_rect, 255);
 	}
 }
 
@@ -35,6 +35,12 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool PrepareDraw() override;
+
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	/**
 	 * Update the fps overlay.
 	 *
@@ -59,6 +65,12 @@ public:
 private:
 	void UpdateText();
 
+	/** Draws the FPS and speedup texts into their bitmaps when they changed */
+	void Refresh();
+
+	/** @return position of the speedup text on a screen of the given width */
+	Rect GetSpeedupRect(int screen_width) const;
+
 	BitmapRef fps_bitmap;
 	BitmapRef speedup_bitmap;
 	Game_Clock::time_point last_refresh_time;
@@ -20,6 +20,7 @@
 #include <vector>
 #include "cache.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "main_data.h"
 #include "frame.h"
 #include "drawable_mgr.h"
@@ -47,6 +48,20 @@ void Frame::Draw(Bitmap& dst) {
 	}
 }
 
+bool Frame::TracksDamage() const {
+	return true;
+}
+
+uint64_t Frame::GetDrawState(Rect& bounds) {
+	if (!frame_bitmap) {
+		bounds = {};
+		return 0;
+	}
+
+	bounds = frame_bitmap->GetRect();
+	return DrawStateHash().Add(frame_bitmap.get()).Add(frame_bitmap->GetRevision()).Get();
+}
+
 void Frame::OnFrameGraphicReady(FileRequestResult* result) {
 	frame_bitmap = Cache::Frame(result->file);
 }
@@ -32,6 +32,8 @@ public:
 	Frame();
 
 	void Draw(Bitmap& dst) override;
+	bool TracksDamage() const override;
+	uint64_t GetDrawState(Rect& bounds) override;
 	void Update();
 
 private:
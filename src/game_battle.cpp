@@ -19,6 +19,7 @@
 #include <cassert>
 #include <lcf/data.h>
 #include "player.h"
+#include "asset_prefetch.h"
 #include "game_actors.h"
 #include "game_enemyparty.h"
 #include "game_message.h"
@@ -71,6 +72,10 @@ void Game_Battle::Init(int troop_id) {
 	Main_Data::game_actors->ResetBattle();
 
 	interpreter.reset(new Game_Interpreter_Battle(troop->pages));
+
+	// Decode the graphics of all battlers at once before the sprites request them
+	AssetPrefetch::PrefetchScene(AssetPrefetch::CollectBattleImages(background_name, terrain_id));
+
 	spriteset.reset(new Spriteset_Battle(background_name, terrain_id));
 	spriteset->Update();
 	animation_actors.reset();
@@ -48,6 +48,9 @@ void Game_ConfigPlayer::Hide() {
 	font2.SetOptionVisible(false);
 	font2_size.SetOptionVisible(false);
 #endif
+#if !defined(HAVE_THREADS) || defined(EMSCRIPTEN)
+	threaded_loading.SetOptionVisible(false);
+#endif
 }
 
 void Game_ConfigVideo::Hide() {
@@ -64,6 +67,9 @@ void Game_ConfigVideo::Hide() {
 	scaling_mode.SetOptionVisible(false);
 	stretch.SetOptionVisible(false);
 	touch_ui.SetOptionVisible(false);
+	partial_update.SetOptionVisible(false);
+	threaded_rendering.SetOptionVisible(false);
+	threaded_presentation.SetOptionVisible(false);
 	pause_when_focus_lost.SetOptionVisible(false);
 	game_resolution.SetOptionVisible(false);
 }
@@ -343,6 +349,18 @@ void Game_Config::LoadFromArgs(CmdlineParser& cp) {
 			video.stretch.Set(arg.ArgIsOn());
 			continue;
 		}
+		if (cp.ParseNext(arg, 0, {"--partial-update", "--no-partial-update"})) {
+			video.partial_update.Set(arg.ArgIsOn());
+			continue;
+		}
+		if (cp.ParseNext(arg, 0, {"--threaded-presentation", "--no-threaded-presentation"})) {
+			video.threaded_presentation.Set(arg.ArgIsOn());
+			continue;
+		}
+		if (cp.ParseNext(arg, 0, {"--threaded-rendering", "--no-threaded-rendering"})) {
+			video.threaded_rendering.Set(arg.ArgIsOn());
+			continue;
+		}
 		if (cp.ParseNext(arg, 1, "--scaling")) {
 			if (arg.ParseValue(0, str_value)) {
 				video.scaling_mode.SetFromString(str_value);
@@ -411,6 +429,40 @@ void Game_Config::LoadFromArgs(CmdlineParser& cp) {
 			}
 			continue;
 		}
+		if (cp.ParseNext(arg, 1, "--cache-size")) {
+			if (arg.ParseValue(0, li_value)) {
+				player.cache_size.Set(li_value);
+			}
+			continue;
+		}
+		if (cp.ParseNext(arg, 1, "--effect-cache-size")) {
+			if (arg.ParseValue(0, li_value)) {
+				player.effect_cache_size.Set(li_value);
+			}
+			continue;
+		}
+		if (cp.ParseNext(arg, 1, "--prefetch-size")) {
+			if (arg.ParseValue(0, li_value)) {
+				player.prefetch_size.Set(li_value);
+			}
+			continue;
+		}
+		if (cp.ParseNext(arg, 1, "--image-disk-cache")) {
+			if (arg.NumValues() > 0) {
+				player.image_disk_cache.Set(FileFinder::MakeCanonical(arg.Value(0), 0));
+			}
+			continue;
+		}
+		if (cp.ParseNext(arg, 1, "--image-disk-cache-size")) {
+			if (arg.ParseValue(0, li_value)) {
+				player.image_disk_cache_size.Set(li_value);
+			}
+			continue;
+		}
+		if (cp.ParseNext(arg, 0, {"--threaded-loading", "--no-threaded-loading"})) {
+			player.threaded_loading.Set(arg.ArgIsOn());
+			continue;
+		}
 		if (cp.ParseNext(arg, 1, "--soundfont-path")) {
 			if (arg.NumValues() > 0) {
 				soundfont_path = FileFinder::MakeCanonical(arg.Value(0), 0);
@@ -445,6 +497,9 @@ void Game_Config::LoadFromStream(Filesystem_Stream::InputStream& is) {
 	video.scaling_mode.FromIni(ini);
 	video.stretch.FromIni(ini);
 	video.touch_ui.FromIni(ini);
+	video.partial_update.FromIni(ini);
+	video.threaded_rendering.FromIni(ini);
+	video.threaded_presentation.FromIni(ini);
 	video.pause_when_focus_lost.FromIni(ini);
 	video.game_resolution.FromIni(ini);
 
@@ -521,6 +576,12 @@ void Game_Config::LoadFromStream(Filesystem_Stream::InputStream& is) {
 	player.font1_size.FromIni(ini);
 	player.font2.FromIni(ini);
 	player.font2_size.FromIni(ini);
+	player.cache_size.FromIni(ini);
+	player.effect_cache_size.FromIni(ini);
+	player.prefetch_size.FromIni(ini);
+	player.image_disk_cache.FromIni(ini);
+	player.image_disk_cache_size.FromIni(ini);
+	player.threaded_loading.FromIni(ini);
 }
 
 void Game_Config::WriteToStream(Filesystem_Stream::OutputStream& os) const {
@@ -535,6 +596,9 @@ void Game_Config::WriteToStream(Filesystem_Stream::OutputStream& os) const {
 	video.scaling_mode.ToIni(os);
 	video.stretch.ToIni(os);
 	video.touch_ui.ToIni(os);
+	video.partial_update.ToIni(os);
+	video.threaded_rendering.ToIni(os);
+	video.threaded_presentation.ToIni(os);
 	video.pause_when_focus_lost.ToIni(os);
 	video.game_resolution.ToIni(os);
 
@@ -606,6 +670,12 @@ void Game_Config::WriteToStream(Filesystem_Stream::OutputStream& os) const {
 	player.font1_size.ToIni(os);
 	player.font2.ToIni(os);
 	player.font2_size.ToIni(os);
+	player.cache_size.ToIni(os);
+	player.effect_cache_size.ToIni(os);
+	player.prefetch_size.ToIni(os);
+	player.image_disk_cache.ToIni(os);
+	player.image_disk_cache_size.ToIni(os);
+	player.threaded_loading.ToIni(os);
 
 	os << "\n";
 }
@@ -89,6 +89,12 @@ struct Game_ConfigPlayer {
 	RangeConfigParam<int> font1_size { "Font 1 Size", "", "Player", "Font1Size", 12, 6, 16};
 	PathConfigParam font2 { "Font 2", "The game chooses whether it wants font 1 or 2", "Player", "Font2", "" };
 	RangeConfigParam<int> font2_size { "Font 2 Size", "", "Player", "Font2Size", 12, 6, 16};
+	RangeConfigParam<int> cache_size { "Image Cache Size", "Memory in MiB for images that are not displayed anymore", "Player", "CacheSize", 10, 1, 4096 };
+	RangeConfigParam<int> effect_cache_size { "Effect Cache Size", "Memory in MiB for sprites with tone, flash, flip or hue effects", "Player", "EffectCacheSize", 4, 1, 1024 };
+	RangeConfigParam<int> prefetch_size { "Image Prefetch Size", "Memory in MiB for images of a map that are loaded in advance (0: Off)", "Player", "PrefetchSize", 4, 0, 4096 };
+	PathConfigParam image_disk_cache { "Image Disk Cache", "Folder where decoded images are stored to load them faster (Empty: Off)", "Player", "ImageDiskCache", "" };
+	RangeConfigParam<int> image_disk_cache_size { "Image Disk Cache Size", "Disk space in MiB for decoded images", "Player", "ImageDiskCacheSize", 256, 1, 65536 };
+	BoolConfigParam threaded_loading{ "Threaded Loading", "Decode images in the background while the game continues (Images can appear a few frames later)", "Player", "ThreadedLoading", false };
 
 	void Hide();
 };
@@ -111,6 +117,9 @@ struct Game_ConfigVideo {
 	BoolConfigParam stretch{ "Stretch", "Stretch to the width of the window/screen", "Video", "Stretch", false };
 	BoolConfigParam pause_when_focus_lost{ "Pause when focus lost", "Pause the program when it is in the background", "Video", "PauseWhenFocusLost", true };
 	BoolConfigParam touch_ui{ "Touch Ui", "Display the touch ui", "Video", "TouchUi", true };
+	BoolConfigParam partial_update{ "Partial Screen Update", "Only draw and transfer the changed parts of the screen", "Video", "PartialUpdate", true };
+	BoolConfigParam threaded_rendering{ "Threaded Rendering", "Draw the screen with all CPU cores (Turn OFF on graphical glitches)", "Video", "ThreadedRendering", false };
+	BoolConfigParam threaded_presentation{ "Threaded Presentation", "Display the last frame while the next one is calculated (Turn OFF on graphical glitches)", "Video", "ThreadedPresentation", false };
 	EnumConfigParam<ConfigEnum::GameResolution, 3> game_resolution{ "Resolution", "Game resolution. Changes require a restart.", "Video", "GameResolution", ConfigEnum::GameResolution::Original,
 		Utils::MakeSvArray("Original (Recommended)", "Widescreen (Experimental)", "Ultrawide (Experimental)"),
 		Utils::MakeSvArray("original", "widescreen", "ultrawide"),
@@ -25,6 +25,7 @@
 #include <numeric>
 #include <unordered_set>
 
+#include "asset_prefetch.h"
 #include "async_handler.h"
 #include "options.h"
 #include "system.h"
@@ -354,6 +355,8 @@ void Game_Map::SetupCommon() {
 	map_cache->Clear();
 
 	CreateMapEvents();
+
+	AssetPrefetch::PrefetchMap(*map, static_cast<size_t>(Player::player_config.prefetch_size.Get()) * 1024 * 1024);
 }
 
 void Game_Map::CreateMapEvents() {
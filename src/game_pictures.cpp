@@ -377,6 +377,7 @@ void Game_Pictures::RequestPictureSprite(Picture& pic) {
 
 	FileRequestAsync* request = AsyncHandler::RequestFile("Picture", name);
 	request->SetGraphicFile(true);
+	request->SetTransparent(pic.data.use_transparent_color);
 	pic.request_id = request->Bind(&Game_Pictures::OnPictureSpriteReady, this, pic.data.ID);
 	request->Start();
 }
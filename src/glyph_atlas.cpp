@@ -0,0 +1,92 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "glyph_atlas.h"
+#include "bitmap.h"
+
+GlyphAtlas::Page::Page(int slot_size) :
+	bitmap(Bitmap::Create(slot_size * slots_per_row, slot_size * slots_per_row, true)),
+	glyphs(slots_per_row * slots_per_row),
+	slot_size(slot_size) {
+}
+
+uint64_t GlyphAtlas::MakeKey(char32_t glyph, int size) {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(size)) << 32) | glyph;
+}
+
+const Font::GlyphRet* GlyphAtlas::Find(char32_t glyph, int size) {
+	const auto key = MakeKey(glyph, size);
+
+	auto it = page_index.find(key);
+	if (it == page_index.end()) {
+		return nullptr;
+	}
+
+	return &pages[it->second]->glyphs.Find(key)->gret;
+}
+
+Font::GlyphRet GlyphAtlas::Insert(char32_t glyph, int size, const Font::GlyphRet& gret) {
+	if (!gret.bitmap) {
+		return gret;
+	}
+
+	const int glyph_size = std::max(gret.rect.width, gret.rect.height);
+	if (glyph_size > max_glyph_size) {
+		return gret;
+	}
+
+	const int page_id = std::max(0, glyph_size - 1) / slot_step;
+	auto& page = pages[page_id];
+	if (!page) {
+		page = std::make_unique<Page>((page_id + 1) * slot_step);
+	}
+
+	int slot;
+	if (page->glyphs.IsFull()) {
+		// Reuse the slot of the least recently used glyph
+		auto& oldest = page->glyphs.Oldest();
+		slot = oldest.second.slot;
+		page_index.erase(oldest.first);
+		page->glyphs.PopOldest();
+	} else {
+		slot = page->next_slot++;
+	}
+
+	const int slot_size = page->slot_size;
+	const int x = slot % slots_per_row * slot_size;
+	const int y = slot / slots_per_row * slot_size;
+
+	page->bitmap->ClearRect(Rect(x, y, slot_size, slot_size));
+	page->bitmap->BlitFast(x, y, *gret.bitmap, gret.rect, Opacity::Opaque());
+
+	const auto key = MakeKey(glyph, size);
+	Entry entry;
+	entry.gret = { page->bitmap, gret.advance, gret.offset, gret.has_color, Rect(x, y, gret.rect.width, gret.rect.height) };
+	entry.slot = slot;
+
+	page_index[key] = page_id;
+	return page->glyphs.Insert(key, std::move(entry)).gret;
+}
+
+void GlyphAtlas::Clear() {
+	for (auto& page: pages) {
+		page.reset();
+	}
+	page_index.clear();
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_GLYPH_ATLAS_H
+#define EP_GLYPH_ATLAS_H
+
+// Headers
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include "font.h"
+#include "lru_cache.h"
+#include "memory_management.h"
+
+/**
+ * Stores rendered glyphs of a font in a few large bitmaps.
+ *
+ * Glyphs are sorted by their size into pages with square slots. A page
+ * holds a fixed number of glyphs, when it is full the least recently
+ * used glyph of the page is replaced.
+ */
+class GlyphAtlas {
+public:
+	/** Glyphs with a larger width or height are not stored */
+	static constexpr int max_glyph_size = 64;
+
+	/** Slot size difference between two pages */
+	static constexpr int slot_step = 8;
+
+	/** Slots per row and column of a page */
+	static constexpr int slots_per_row = 16;
+
+	/**
+	 * Looks up a glyph.
+	 *
+	 * @param glyph glyph index
+	 * @param size font size the glyph was rendered at
+	 * @return glyph or nullptr when the glyph is not in the atlas
+	 */
+	const Font::GlyphRet* Find(char32_t glyph, int size);
+
+	/**
+	 * Copies a rendered glyph into the atlas.
+	 * The glyph must not be in the atlas.
+	 *
+	 * @param glyph glyph index
+	 * @param size font size the glyph was rendered at
+	 * @param gret rendered glyph
+	 * @return glyph that references the atlas or gret when the glyph is too large
+	 */
+	Font::GlyphRet Insert(char32_t glyph, int size, const Font::GlyphRet& gret);
+
+	/** Removes all glyphs */
+	void Clear();
+
+	/** @return number of glyphs in the atlas */
+	int GetNumGlyphs() const;
+
+private:
+	static constexpr int num_pages = max_glyph_size / slot_step;
+
+	struct Entry {
+		Font::GlyphRet gret;
+		int slot = 0;
+	};
+
+	struct Page {
+		explicit Page(int slot_size);
+
+		BitmapRef bitmap;
+		LruCache<uint64_t, Entry> glyphs;
+		int slot_size = 0;
+		int next_slot = 0;
+	};
+
+	static uint64_t MakeKey(char32_t glyph, int size);
+
+	std::array<std::unique_ptr<Page>, num_pages> pages;
+	/** Page index of every stored glyph */
+	std::unordered_map<uint64_t, int> page_index;
+};
+
+inline int GlyphAtlas::GetNumGlyphs() const {
+	return static_cast<int>(page_index.size());
+}
+
+#endif
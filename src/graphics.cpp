@@ -30,6 +30,10 @@
 #include "drawable_mgr.h"
 #include "baseui.h"
 #include "game_clock.h"
+#include "band_renderer.h"
+#include "damage_tracker.h"
+#include "game_system.h"
+#include "main_data.h"
 
 using namespace std::chrono_literals;
 
@@ -40,8 +44,30 @@ namespace Graphics {
 
 	std::unique_ptr<MessageOverlay> message_overlay;
 	std::unique_ptr<FpsOverlay> fps_overlay;
+	std::unique_ptr<BandRenderer> band_renderer;
 
 	std::string window_title_key;
+
+	BandRenderer* GetBandRenderer();
+
+	/** Changed parts of the screen for partial updates */
+	DamageTracker damage;
+
+	/** Screen content of the last partial update, everything is redrawn when it does not match */
+	struct DrawKey {
+		const Bitmap* dst = nullptr;
+		uint64_t revision = 0;
+		const DrawableList* drawable_list = nullptr;
+		Drawable::Z_t min_z = 0;
+		bool erased = false;
+		Color background;
+
+		bool operator==(const DrawKey& other) const {
+			return dst == other.dst && revision == other.revision && drawable_list == other.drawable_list &&
+				min_z == other.min_z && erased == other.erased && background == other.background;
+		}
+	};
+	DrawKey last_draw;
 }
 
 void Graphics::Init() {
@@ -53,6 +79,7 @@ void Graphics::Init() {
 }
 
 void Graphics::Quit() {
+	band_renderer.reset();
 	fps_overlay.reset();
 	message_overlay.reset();
 
@@ -109,13 +136,55 @@ void Graphics::Draw(Bitmap& dst) {
 
 	auto min_z = std::numeric_limits<Drawable::Z_t>::min();
 	auto max_z = std::numeric_limits<Drawable::Z_t>::max();
+	bool erased = false;
 	if (transition.IsActive()) {
 		min_z = transition.GetZ();
 	} else if (transition.IsErasedNotActive()) {
 		min_z = transition.GetZ() + 1;
-		dst.Clear();
+		erased = true;
+	}
+
+	if (!DisplayUi->IsPartialUpdate()) {
+		last_draw = {};
+		if (erased) {
+			dst.Clear();
+		}
+		LocalDraw(dst, min_z, max_z);
+		return;
+	}
+
+	auto& drawable_list = DrawableMgr::GetLocalList();
+
+	DrawKey key;
+	key.dst = &dst;
+	key.revision = dst.GetRevision();
+	key.drawable_list = &drawable_list;
+	key.min_z = min_z;
+	key.erased = erased;
+	if (Main_Data::game_system) {
+		key.background = Main_Data::game_system->GetBackgroundColor();
 	}
-	LocalDraw(dst, min_z, max_z);
+
+	// The screen was modified elsewhere or shows something else
+	if (!(key == last_draw) || damage.GetScreenRect() != dst.GetRect()) {
+		damage.SetSize(dst.width(), dst.height());
+	}
+
+	auto background = [&](Bitmap& area) {
+		if (erased) {
+			area.Clear();
+		} else if (!drawable_list.empty() && min_z == std::numeric_limits<Drawable::Z_t>::min()) {
+			current_scene->DrawBackground(area);
+		}
+	};
+
+	drawable_list.DrawDamage(dst, min_z, max_z, damage, background, GetBandRenderer());
+
+	DisplayUi->AddDisplayDamage(damage);
+	damage.Clear();
+
+	key.revision = dst.GetRevision();
+	last_draw = key;
 }
 
 void Graphics::LocalDraw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z) {
@@ -125,7 +194,20 @@ void Graphics::LocalDraw(Bitmap& dst, Drawable::Z_t min_z, Drawable::Z_t max_z)
 		current_scene->DrawBackground(dst);
 	}
 
-	drawable_list.Draw(dst, min_z, max_z);
+	drawable_list.Draw(dst, min_z, max_z, GetBandRenderer());
+}
+
+BandRenderer* Graphics::GetBandRenderer() {
+	// The worker threads only exist while the option is enabled
+	if (DisplayUi->IsThreadedRendering()) {
+		if (!band_renderer) {
+			band_renderer = std::make_unique<BandRenderer>();
+		}
+	} else {
+		band_renderer.reset();
+	}
+
+	return band_renderer.get();
 }
 
 std::shared_ptr<Scene> Graphics::UpdateSceneCallback() {
@@ -0,0 +1,48 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <memory>
+#include "image_decoder.h"
+#include "image_disk_cache.h"
+#include "thread_pool.h"
+
+namespace {
+	std::unique_ptr<ThreadPool> pool;
+
+	ThreadPool& GetPool() {
+		if (!pool) {
+			pool = std::make_unique<ThreadPool>();
+		}
+		return *pool;
+	}
+}
+
+std::vector<BitmapRef> ImageDecoder::Decode(std::vector<Source> sources) {
+	std::vector<BitmapRef> bitmaps(sources.size());
+
+	GetPool().ParallelFor(static_cast<int>(sources.size()), [&](int i) {
+		auto& source = sources[i];
+		bitmaps[i] = ImageDiskCache::Create(std::move(source.stream), source.transparent, source.flags);
+	});
+
+	return bitmaps;
+}
+
+int ImageDecoder::GetNumThreads() {
+	return GetPool().GetNumThreads();
+}
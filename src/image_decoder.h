@@ -0,0 +1,58 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_IMAGE_DECODER_H
+#define EP_IMAGE_DECODER_H
+
+// Headers
+#include <cstdint>
+#include <vector>
+#include "filesystem_stream.h"
+#include "memory_management.h"
+
+/**
+ * Decodes several images (PNG, XYZ, BMP) at the same time on a pool of
+ * worker threads. Decoding includes the conversion to the pixel format of
+ * the screen, so the returned bitmaps are ready to be drawn. Images in the
+ * ImageDiskCache are loaded from there.
+ */
+namespace ImageDecoder {
+	/** An image to decode */
+	struct Source {
+		/** Stream of the image file */
+		Filesystem_Stream::InputStream stream;
+		/** Whether the first palette color is transparent */
+		bool transparent = true;
+		/** Bitmap::Flags passed to Bitmap::Create */
+		uint32_t flags = 0;
+	};
+
+	/**
+	 * Decodes images concurrently and waits until all are decoded.
+	 * The streams must be opened on the calling thread, the filesystems are
+	 * not thread safe.
+	 *
+	 * @param sources images to decode, the streams are consumed
+	 * @return bitmaps in the order of sources, nullptr when decoding failed
+	 */
+	std::vector<BitmapRef> Decode(std::vector<Source> sources);
+
+	/** @return number of images that are decoded at the same time */
+	int GetNumThreads();
+}
+
+#endif
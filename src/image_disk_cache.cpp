@@ -0,0 +1,446 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <tuple>
+#include <vector>
+#include "image_disk_cache.h"
+#include "bitmap.h"
+#include "output.h"
+#include "platform.h"
+#include "utils.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#  define EP_IMAGE_DISK_CACHE
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+	std::string cache_path;
+
+	std::atomic<size_t> hits{0};
+	std::atomic<size_t> misses{0};
+	std::atomic<size_t> stored{0};
+	std::atomic<size_t> removed{0};
+
+	std::atomic<uint64_t> size_limit{ImageDiskCache::default_size_limit};
+
+#ifdef EP_IMAGE_DISK_CACHE
+	// Bump the version when the layout or the pixel conversion changes
+	constexpr char file_magic[8] = { 'E', 'P', 'I', 'M', 'G', 'C', '1', '\0' };
+	constexpr uint32_t pixel_alignment = 64;
+
+	using FormatDescription = std::array<int32_t, 10>;
+
+	/** Identifies a decoded image */
+	struct Key {
+		std::string name;
+		uint64_t file_size = 0;
+		uint32_t crc = 0;
+		uint32_t flags = 0;
+		uint32_t transparent = 0;
+		FormatDescription format = {};
+	};
+
+	/** Start of a cache file, followed by the name, tile opacities and pixels */
+	struct FileHeader {
+		char magic[8];
+		uint64_t file_size;
+		uint32_t crc;
+		uint32_t flags;
+		uint32_t transparent;
+		FormatDescription format;
+		int32_t width;
+		int32_t height;
+		int32_t pitch;
+		int32_t original_bpp;
+		uint32_t read_only;
+		uint32_t image_opacity;
+		uint8_t bg_color[4];
+		uint8_t sh_color[4];
+		uint32_t name_size;
+		uint32_t tile_count;
+		uint32_t pixel_offset;
+	};
+
+	FormatDescription DescribeFormat(const DynamicFormat& format) {
+		return {{
+			format.bits,
+			format.r.bits, format.r.shift,
+			format.g.bits, format.g.shift,
+			format.b.bits, format.b.shift,
+			format.a.bits, format.a.shift,
+			static_cast<int32_t>(format.alpha_type)
+		}};
+	}
+
+	std::string GetCacheFilename(const Key& key) {
+		// FNV-1a, the header contains the full key to detect collisions
+		uint64_t hash = 14695981039346656037ull;
+		auto add = [&](const void* data, size_t size) {
+			for (size_t i = 0; i < size; ++i) {
+				hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+			}
+		};
+		add(key.name.data(), key.name.size());
+		add(&key.file_size, sizeof(key.file_size));
+		add(&key.crc, sizeof(key.crc));
+		add(&key.flags, sizeof(key.flags));
+		add(&key.transparent, sizeof(key.transparent));
+		add(key.format.data(), key.format.size() * sizeof(int32_t));
+
+		return cache_path + "/" + fmt::format("{:016x}.img", hash);
+	}
+
+	/** A stored image in the cache folder */
+	struct CacheFile {
+		std::string filename;
+		uint64_t size = 0;
+		std::time_t mtime = 0;
+		long mtime_nsec = 0;
+	};
+
+	// Size of the files in the folder. Only approximate when other
+	// processes use the same folder.
+	std::atomic<uint64_t> folder_size{0};
+	std::atomic<bool> trimming{false};
+
+	std::vector<CacheFile> ListFiles() {
+		std::vector<CacheFile> files;
+		if (cache_path.empty()) {
+			return files;
+		}
+
+		Platform::Directory dir(cache_path);
+		while (dir && dir.Read()) {
+			const std::string name = dir.GetEntryName();
+			if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".img") != 0) {
+				continue;
+			}
+
+			CacheFile file;
+			file.filename = cache_path + "/" + name;
+			struct stat st;
+			if (stat(file.filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+				continue;
+			}
+			file.size = static_cast<uint64_t>(st.st_size);
+			file.mtime = st.st_mtime;
+#ifdef __APPLE__
+			file.mtime_nsec = st.st_mtimespec.tv_nsec;
+#else
+			file.mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+			files.push_back(std::move(file));
+		}
+
+		return files;
+	}
+
+	/**
+	 * Removes the least recently used files until the folder uses 3/4 of
+	 * the size limit, so that the folder is not scanned on every store.
+	 * Removing a file does not affect bitmaps that still map it.
+	 *
+	 * @param keep file that is not removed
+	 */
+	void Trim(const std::string& keep) {
+		// Only one thread removes files, the others continue storing
+		bool expected = false;
+		if (!trimming.compare_exchange_strong(expected, true)) {
+			return;
+		}
+
+		auto files = ListFiles();
+		uint64_t total = 0;
+		uint64_t removed_size = 0;
+		for (const auto& file: files) {
+			total += file.size;
+		}
+
+		// Loading an image updates the modification time. Many files are
+		// stored within the same second, the name keeps the order stable.
+		std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+			return std::tie(a.mtime, a.mtime_nsec, a.filename) < std::tie(b.mtime, b.mtime_nsec, b.filename);
+		});
+
+		const uint64_t target = size_limit / 4 * 3;
+		for (const auto& file: files) {
+			if (total <= target) {
+				break;
+			}
+			if (file.filename == keep) {
+				continue;
+			}
+			if (std::remove(file.filename.c_str()) == 0) {
+				total -= file.size;
+				removed_size += file.size;
+				++removed;
+			}
+		}
+
+		// Files stored by other threads meanwhile are still counted
+		folder_size -= std::min<uint64_t>(removed_size, folder_size);
+		trimming = false;
+	}
+
+	bool MatchesKey(const FileHeader& header, const char* name, const Key& key) {
+		return header.file_size == key.file_size
+			&& header.crc == key.crc
+			&& header.flags == key.flags
+			&& header.transparent == key.transparent
+			&& header.format == key.format
+			&& header.name_size == key.name.size()
+			&& std::memcmp(name, key.name.data(), key.name.size()) == 0;
+	}
+
+	BitmapRef Load(const Key& key) {
+		const std::string filename = GetCacheFilename(key);
+
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return nullptr;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+			close(fd);
+			return nullptr;
+		}
+
+		// Private mapping: The pixels are never written back to the file
+		const size_t length = static_cast<size_t>(st.st_size);
+		void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			// Marks the file as recently used for the size limit
+			futimens(fd, nullptr);
+		}
+		close(fd);
+		if (data == MAP_FAILED) {
+			return nullptr;
+		}
+
+		auto* bytes = static_cast<uint8_t*>(data);
+		FileHeader header;
+		std::memcpy(&header, bytes, sizeof(header));
+
+		const char* name = reinterpret_cast<const char*>(bytes + sizeof(header));
+		const DynamicFormat& format = key.transparent ? Bitmap::pixel_format : Bitmap::opaque_pixel_format;
+		const uint64_t data_end = static_cast<uint64_t>(sizeof(header)) + header.name_size + header.tile_count;
+
+		if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0
+				|| data_end > header.pixel_offset
+				|| header.width <= 0 || header.height <= 0 || header.pitch < header.width * format.bytes
+				|| static_cast<uint64_t>(header.pixel_offset) + static_cast<uint64_t>(header.pitch) * header.height != length
+				|| !MatchesKey(header, name, key)) {
+			munmap(data, length);
+			return nullptr;
+		}
+
+		Bitmap::DecodedInfo info;
+		info.original_bpp = header.original_bpp;
+		info.read_only = header.read_only != 0;
+		info.image_opacity = static_cast<ImageOpacity>(header.image_opacity);
+		info.bg_color = Color(header.bg_color[0], header.bg_color[1], header.bg_color[2], header.bg_color[3]);
+		info.sh_color = Color(header.sh_color[0], header.sh_color[1], header.sh_color[2], header.sh_color[3]);
+		const uint8_t* tiles = bytes + sizeof(header) + header.name_size;
+		for (uint32_t i = 0; i < header.tile_count; ++i) {
+			info.tile_opacity.push_back(static_cast<ImageOpacity>(tiles[i]));
+		}
+
+		return Bitmap::CreateDecoded(bytes + header.pixel_offset, header.width, header.height, header.pitch,
+			key.transparent != 0, info, [data, length]() { munmap(data, length); });
+	}
+
+	bool Store(const Key& key, const Bitmap& bmp) {
+		const auto info = bmp.GetDecodedInfo();
+
+		FileHeader header = {};
+		std::memcpy(header.magic, file_magic, sizeof(file_magic));
+		header.file_size = key.file_size;
+		header.crc = key.crc;
+		header.flags = key.flags;
+		header.transparent = key.transparent;
+		header.format = key.format;
+		header.width = bmp.width();
+		header.height = bmp.height();
+		header.pitch = bmp.pitch();
+		header.original_bpp = info.original_bpp;
+		header.read_only = info.read_only ? 1 : 0;
+		header.image_opacity = static_cast<uint32_t>(info.image_opacity);
+		auto set_color = [](uint8_t* out, const Color& color) {
+			out[0] = color.red;
+			out[1] = color.green;
+			out[2] = color.blue;
+			out[3] = color.alpha;
+		};
+		set_color(header.bg_color, info.bg_color);
+		set_color(header.sh_color, info.sh_color);
+		header.name_size = static_cast<uint32_t>(key.name.size());
+		header.tile_count = static_cast<uint32_t>(info.tile_opacity.size());
+		const uint32_t data_end = sizeof(header) + header.name_size + header.tile_count;
+		header.pixel_offset = (data_end + pixel_alignment - 1) / pixel_alignment * pixel_alignment;
+
+		std::vector<char> meta(header.pixel_offset);
+		std::memcpy(meta.data(), &header, sizeof(header));
+		std::memcpy(meta.data() + sizeof(header), key.name.data(), key.name.size());
+		for (size_t i = 0; i < info.tile_opacity.size(); ++i) {
+			meta[sizeof(header) + key.name.size() + i] = static_cast<char>(info.tile_opacity[i]);
+		}
+
+		// Written to a temporary file and renamed, so that other threads
+		// and processes never map a partially written file
+		static std::atomic<unsigned> tmp_counter{0};
+		const std::string filename = GetCacheFilename(key);
+		const std::string tmp_filename = fmt::format("{}.{}.{}.tmp", filename, getpid(), tmp_counter++);
+
+		{
+			std::ofstream os(tmp_filename, std::ios_base::binary | std::ios_base::trunc);
+			if (!os) {
+				return false;
+			}
+
+			os.write(meta.data(), meta.size());
+			const size_t row_size = static_cast<size_t>(bmp.pitch());
+			for (int y = 0; y < bmp.height(); ++y) {
+				os.write(static_cast<const char*>(bmp.pixels()) + y * row_size, row_size);
+			}
+
+			if (!os) {
+				os.close();
+				std::remove(tmp_filename.c_str());
+				return false;
+			}
+		}
+
+		if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+			std::remove(tmp_filename.c_str());
+			return false;
+		}
+
+		const uint64_t file_size = meta.size() + static_cast<uint64_t>(bmp.pitch()) * bmp.height();
+		if ((folder_size += file_size) > size_limit) {
+			Trim(filename);
+		}
+
+		return true;
+	}
+#endif
+}
+
+bool ImageDiskCache::IsSupported() {
+#ifdef EP_IMAGE_DISK_CACHE
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ImageDiskCache::SetPath(std::string path) {
+	if (!path.empty() && !IsSupported()) {
+		Output::Warning("The image disk cache is not supported on this platform");
+		path.clear();
+	}
+
+	if (!path.empty() && !Platform::File(path).MakeDirectory(true)) {
+		Output::Warning("Image disk cache: Cannot create {}", path);
+		path.clear();
+	}
+
+	cache_path = std::move(path);
+
+#ifdef EP_IMAGE_DISK_CACHE
+	uint64_t total = 0;
+	for (const auto& file: ListFiles()) {
+		total += file.size;
+	}
+	folder_size = total;
+	if (total > size_limit) {
+		Trim("");
+	}
+#endif
+}
+
+bool ImageDiskCache::IsEnabled() {
+	return !cache_path.empty();
+}
+
+void ImageDiskCache::SetSizeLimit(uint64_t limit) {
+	size_limit = limit;
+
+#ifdef EP_IMAGE_DISK_CACHE
+	if (IsEnabled() && folder_size > size_limit) {
+		Trim("");
+	}
+#endif
+}
+
+uint64_t ImageDiskCache::GetSizeLimit() {
+	return size_limit;
+}
+
+BitmapRef ImageDiskCache::Create(Filesystem_Stream::InputStream stream, bool transparent, uint32_t flags) {
+#ifdef EP_IMAGE_DISK_CACHE
+	if (cache_path.empty() || !stream) {
+		return Bitmap::Create(std::move(stream), transparent, flags);
+	}
+
+	Key key;
+	key.name = ToString(stream.GetName());
+	key.file_size = static_cast<uint64_t>(stream.GetSize());
+	key.flags = flags;
+	key.transparent = transparent ? 1 : 0;
+	key.format = DescribeFormat(transparent ? Bitmap::pixel_format : Bitmap::opaque_pixel_format);
+	// Reading the file is much faster than decoding it
+	key.crc = Utils::CRC32(stream);
+	stream.clear();
+	stream.seekg(0, std::ios_base::beg);
+
+	if (auto bmp = Load(key)) {
+		++hits;
+		return bmp;
+	}
+
+	++misses;
+	auto bmp = Bitmap::Create(std::move(stream), transparent, flags);
+	if (bmp && Store(key, *bmp)) {
+		++stored;
+	}
+	return bmp;
+#else
+	return Bitmap::Create(std::move(stream), transparent, flags);
+#endif
+}
+
+ImageDiskCache::Stats ImageDiskCache::GetStats() {
+	Stats stats;
+	stats.hits = hits;
+	stats.misses = misses;
+	stats.stored = stored;
+	stats.removed = removed;
+	return stats;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_IMAGE_DISK_CACHE_H
+#define EP_IMAGE_DISK_CACHE_H
+
+// Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "filesystem_stream.h"
+#include "memory_management.h"
+
+/**
+ * Stores decoded images in a folder, so that they are not decoded again
+ * on the next start. A stored image contains the pixels in the format of
+ * the screen and the opacity information of the bitmap. Stored images are
+ * memory mapped when they are loaded.
+ *
+ * An image is identified by the name, size and CRC32 of its file, the
+ * pixel format and the load flags. Changed files are decoded again.
+ * When the folder grows beyond the size limit the least recently used
+ * images are removed. The cache is disabled by default and only supported
+ * on platforms with memory mapped files.
+ */
+namespace ImageDiskCache {
+	/** @return whether this platform supports the cache */
+	bool IsSupported();
+
+	/**
+	 * Sets the folder of the cache. Must be called before images are loaded
+	 * on worker threads.
+	 *
+	 * @param path native path of the folder, empty disables the cache
+	 */
+	void SetPath(std::string path);
+
+	/** @return whether the cache is enabled */
+	bool IsEnabled();
+
+	/** Default size limit of the cache folder in bytes */
+	constexpr uint64_t default_size_limit = 256 * 1024 * 1024;
+
+	/**
+	 * Sets the size limit of the cache folder. When storing an image
+	 * exceeds it, the least recently used images are removed until the
+	 * folder uses 3/4 of the limit. The image that was stored last is kept.
+	 *
+	 * @param limit size limit in bytes
+	 */
+	void SetSizeLimit(uint64_t limit);
+
+	/** @return size limit of the cache folder in bytes */
+	uint64_t GetSizeLimit();
+
+	/**
+	 * Loads an image like Bitmap::Create. When the cache is enabled the
+	 * decoded image is loaded from the cache or stored after decoding.
+	 * Can be called on any thread.
+	 *
+	 * @param stream stream of the image file
+	 * @param transparent whether the first palette color is transparent
+	 * @param flags Bitmap::Flags
+	 * @return bitmap or nullptr when decoding failed
+	 */
+	BitmapRef Create(Filesystem_Stream::InputStream stream, bool transparent, uint32_t flags);
+
+	/** Counters of the cache */
+	struct Stats {
+		/** Images loaded from the cache */
+		size_t hits = 0;
+		/** Images that were decoded */
+		size_t misses = 0;
+		/** Images written to the cache */
+		size_t stored = 0;
+		/** Images removed to stay below the size limit */
+		size_t removed = 0;
+	};
+
+	/** @return counters of the cache */
+	Stats GetStats();
+}
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_LRU_CACHE_H
+#define EP_LRU_CACHE_H
+
+// Headers
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * A map with a limited number of entries.
+ * When the cache is full the least recently used entry is evicted.
+ * Lookup, insertion and eviction are O(1).
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+private:
+	using list_type = std::list<std::pair<const K, V>>;
+
+public:
+	using value_type = typename list_type::value_type;
+	using const_iterator = typename list_type::const_iterator;
+
+	/**
+	 * @param capacity maximum number of entries, must be > 0
+	 */
+	explicit LruCache(size_t capacity);
+
+	LruCache(const LruCache&) = delete;
+	LruCache& operator=(const LruCache&) = delete;
+	LruCache(LruCache&&) = default;
+	LruCache& operator=(LruCache&&) = default;
+
+	/**
+	 * Looks up an entry and marks it as most recently used.
+	 *
+	 * @param key key to look up
+	 * @return value or nullptr when not cached
+	 */
+	V* Find(const K& key);
+
+	/**
+	 * Inserts or replaces an entry and marks it as most recently used.
+	 * Evicts the least recently used entry when the cache is full.
+	 *
+	 * @param key key of the entry
+	 * @param value value of the entry
+	 * @return inserted value
+	 */
+	V& Insert(const K& key, V value);
+
+	/**
+	 * Removes an entry.
+	 *
+	 * @param key key of the entry
+	 * @return whether an entry was removed
+	 */
+	bool Erase(const K& key);
+
+	/** @return least recently used entry, the cache must not be empty */
+	value_type& Oldest();
+
+	/** Removes the least recently used entry, the cache must not be empty */
+	void PopOldest();
+
+	/** Removes all entries */
+	void Clear();
+
+	/** @return number of entries */
+	size_t GetSize() const;
+
+	/** @return maximum number of entries */
+	size_t GetCapacity() const;
+
+	/** @return whether the next insertion of a new key evicts an entry */
+	bool IsFull() const;
+
+	/** @return iterator to the most recently used entry */
+	const_iterator begin() const;
+
+	/** @return iterator past the least recently used entry */
+	const_iterator end() const;
+
+private:
+	list_type entries;
+	std::unordered_map<K, typename list_type::iterator, Hash> index;
+	size_t capacity;
+};
+
+template <typename K, typename V, typename Hash>
+inline LruCache<K, V, Hash>::LruCache(size_t capacity) : capacity(capacity) {
+	assert(capacity > 0);
+}
+
+template <typename K, typename V, typename Hash>
+inline V* LruCache<K, V, Hash>::Find(const K& key) {
+	auto it = index.find(key);
+	if (it == index.end()) {
+		return nullptr;
+	}
+
+	entries.splice(entries.begin(), entries, it->second);
+	return &it->second->second;
+}
+
+template <typename K, typename V, typename Hash>
+inline V& LruCache<K, V, Hash>::Insert(const K& key, V value) {
+	auto it = index.find(key);
+	if (it != index.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+		it->second->second = std::move(value);
+		return it->second->second;
+	}
+
+	if (IsFull()) {
+		PopOldest();
+	}
+
+	entries.emplace_front(key, std::move(value));
+	index.emplace(key, entries.begin());
+	return entries.front().second;
+}
+
+template <typename K, typename V, typename Hash>
+inline bool LruCache<K, V, Hash>::Erase(const K& key) {
+	auto it = index.find(key);
+	if (it == index.end()) {
+		return false;
+	}
+
+	entries.erase(it->second);
+	index.erase(it);
+	return true;
+}
+
+template <typename K, typename V, typename Hash>
+inline typename LruCache<K, V, Hash>::value_type& LruCache<K, V, Hash>::Oldest() {
+	assert(!entries.empty());
+	return entries.back();
+}
+
+template <typename K, typename V, typename Hash>
+inline void LruCache<K, V, Hash>::PopOldest() {
+	assert(!entries.empty());
+	index.erase(entries.back().first);
+	entries.pop_back();
+}
+
+template <typename K, typename V, typename Hash>
+inline void LruCache<K, V, Hash>::Clear() {
+	index.clear();
+	entries.clear();
+}
+
+template <typename K, typename V, typename Hash>
+inline size_t LruCache<K, V, Hash>::GetSize() const {
+	return entries.size();
+}
+
+template <typename K, typename V, typename Hash>
+inline size_t LruCache<K, V, Hash>::GetCapacity() const {
+	return capacity;
+}
+
+template <typename K, typename V, typename Hash>
+inline bool LruCache<K, V, Hash>::IsFull() const {
+	return entries.size() >= capacity;
+}
+
+template <typename K, typename V, typename Hash>
+inline typename LruCache<K, V, Hash>::const_iterator LruCache<K, V, Hash>::begin() const {
+	return entries.begin();
+}
+
+template <typename K, typename V, typename Hash>
+inline typename LruCache<K, V, Hash>::const_iterator LruCache<K, V, Hash>::end() const {
+	return entries.end();
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "message_overlay.h"
 #include "player.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "game_message.h"
 #include "drawable_mgr.h"
 #include "baseui.h"
@@ -35,8 +36,34 @@ void MessageOverlay::Draw(Bitmap& dst) {
 		return;
 	}
 
+	Refresh();
+
 	dst.Blit(ox, oy, *bitmap, bitmap->GetRect(), 255);
+}
+
+bool MessageOverlay::PrepareDraw() {
+	if (IsAnyMessageVisible() || show_all) {
+		Refresh();
+	}
+
+	return false;
+}
+
+bool MessageOverlay::TracksDamage() const {
+	return true;
+}
+
+uint64_t MessageOverlay::GetDrawState(Rect& bounds) {
+	if (!IsAnyMessageVisible() && !show_all) {
+		bounds = {};
+		return 0;
+	}
+
+	bounds = Rect(ox, oy, bitmap->GetWidth(), bitmap->GetHeight());
+	return DrawStateHash().Add(bitmap.get()).Add(bitmap->GetRevision()).Get();
+}
 
+void MessageOverlay::Refresh() {
 	if (!dirty) return;
 
 	bitmap->Clear();
@@ -45,6 +45,12 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool PrepareDraw() override;
+
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	void Update();
 
 	void AddMessage(const std::string& message, Color color);
@@ -56,6 +62,9 @@ public:
 private:
 	bool IsAnyMessageVisible() const;
 
+	/** Draws the messages into the bitmap when they changed */
+	void Refresh();
+
 	BitmapRef bitmap;
 	BitmapRef black;
 
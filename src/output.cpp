@@ -24,6 +24,9 @@
 #include <fstream>
 #include <thread>
 #include <chrono>
+#ifdef HAVE_THREADS
+#  include <mutex>
+#endif
 #include <fmt/color.h>
 #include <fmt/ostream.h>
 #ifdef EMSCRIPTEN
@@ -112,6 +115,18 @@ namespace {
 
 	LogCallbackFn log_cb = LogCallback;
 	LogCallbackUserData log_cb_udata = nullptr;
+
+#ifdef HAVE_THREADS
+	// Messages of worker threads (e.g. image decoders) are written by the main thread
+	struct DeferredMessage {
+		LogLevel lvl;
+		std::string msg;
+		Color color;
+	};
+	const std::thread::id main_thread_id = std::this_thread::get_id();
+	std::mutex deferred_mutex;
+	std::vector<DeferredMessage> deferred_messages;
+#endif
 }
 
 std::string Output::LogLevelToString(LogLevel lvl) {
@@ -140,6 +155,17 @@ void Output::SetLogCallback(LogCallbackFn fn, LogCallbackUserData userdata) {
 }
 
 static void WriteLog(LogLevel lvl, std::string const& msg, Color const& c = Color()) {
+#ifdef HAVE_THREADS
+	if (std::this_thread::get_id() != main_thread_id) {
+		std::lock_guard<std::mutex> lock(deferred_mutex);
+		deferred_messages.push_back({ lvl, msg, c });
+		return;
+	}
+
+	// Keeps the order of the messages
+	Output::Update();
+#endif
+
 // skip writing log file
 #ifndef EMSCRIPTEN
 	std::string prefix = Output::LogLevelToString(lvl) + ": ";
@@ -222,6 +248,22 @@ static void HandleErrorOutput(const std::string& err) {
 	}
 }
 
+void Output::Update() {
+#ifdef HAVE_THREADS
+	std::vector<DeferredMessage> deferred;
+	{
+		std::lock_guard<std::mutex> lock(deferred_mutex);
+		if (deferred_messages.empty()) {
+			return;
+		}
+		deferred.swap(deferred_messages);
+	}
+	for (auto& deferred_msg: deferred) {
+		WriteLog(deferred_msg.lvl, deferred_msg.msg, deferred_msg.color);
+	}
+#endif
+}
+
 void Output::Quit() {
 	if (LOG_FILE) {
 		LOG_FILE.Close();
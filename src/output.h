@@ -61,6 +61,13 @@ namespace Output {
 	 */
 	void Quit();
 
+	/**
+	 * Writes the log messages of worker threads. They are queued because
+	 * the log file and the message overlay are only used by the main
+	 * thread. Called once per frame and on exit.
+	 */
+	void Update();
+
 	/**
 	 * Takes screenshot and save it in the save directory.
 	 *
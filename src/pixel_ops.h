@@ -0,0 +1,122 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_PIXEL_OPS_H
+#define EP_PIXEL_OPS_H
+
+// Headers
+#include <cstdint>
+
+/**
+ * Arithmetic on packed premultiplied 32 bit pixels.
+ *
+ * The operations work on all four 8 bit channels at once and are
+ * independent of the channel order, only the position of the alpha
+ * channel is needed for compositing.
+ * Rounding and saturation are identical to the pixman combiners
+ * (UN8x4_MUL_UN8, UN8x4_ADD_UN8x4), so the results are bit exact
+ * with the pixman code paths they replace.
+ */
+namespace PixelOps {
+	constexpr uint32_t rb_mask = 0x00FF00FF;
+	constexpr uint32_t rb_one_half = 0x00800080;
+	constexpr uint32_t rb_mask_plus_one = 0x10000100;
+
+	/**
+	 * Multiplies two 8 bit values, result is rounded (a * b / 255).
+	 *
+	 * @param a first value
+	 * @param b second value
+	 * @return product
+	 */
+	constexpr uint32_t MulUn8(uint32_t a, uint32_t b) {
+		return (((a * b + 0x80) >> 8) + a * b + 0x80) >> 8;
+	}
+
+	/**
+	 * Multiplies every channel of a pixel with an 8 bit value.
+	 *
+	 * @param px pixel
+	 * @param a factor (0 - 255)
+	 * @return scaled pixel
+	 */
+	inline uint32_t MulUn8x4(uint32_t px, uint32_t a) {
+		uint32_t t = (px & rb_mask) * a + rb_one_half;
+		t = ((t + ((t >> 8) & rb_mask)) >> 8) & rb_mask;
+
+		px = ((px >> 8) & rb_mask) * a + rb_one_half;
+		px = (px + ((px >> 8) & rb_mask)) & ~rb_mask;
+
+		return px | t;
+	}
+
+	/**
+	 * Adds two pixels channel wise, saturating at 255.
+	 *
+	 * @param x first pixel
+	 * @param y second pixel
+	 * @return sum
+	 */
+	inline uint32_t AddUn8x4(uint32_t x, uint32_t y) {
+		uint32_t t = (x & rb_mask) + (y & rb_mask);
+		t |= rb_mask_plus_one - ((t >> 8) & rb_mask);
+		t &= rb_mask;
+
+		uint32_t u = ((x >> 8) & rb_mask) + ((y >> 8) & rb_mask);
+		u |= rb_mask_plus_one - ((u >> 8) & rb_mask);
+		u &= rb_mask;
+
+		return t | (u << 8);
+	}
+
+	/**
+	 * Composites src over dst (Porter-Duff OVER).
+	 *
+	 * @param src source pixel
+	 * @param dst destination pixel
+	 * @param a_shift bit position of the alpha channel
+	 * @return composited pixel
+	 */
+	inline uint32_t Over(uint32_t src, uint32_t dst, int a_shift) {
+		const uint32_t ia = ~src >> a_shift & 0xFF;
+		if (ia == 0) {
+			return src;
+		}
+		if (ia == 0xFF && src == 0) {
+			return dst;
+		}
+		return AddUn8x4(src, MulUn8x4(dst, ia));
+	}
+
+	/**
+	 * Composites src scaled by an opacity over dst (OVER with a solid mask).
+	 *
+	 * @param src source pixel
+	 * @param dst destination pixel
+	 * @param opacity mask value (0 - 255)
+	 * @param a_shift bit position of the alpha channel
+	 * @return composited pixel
+	 */
+	inline uint32_t OverMask(uint32_t src, uint32_t dst, uint32_t opacity, int a_shift) {
+		if (opacity == 0xFF) {
+			return Over(src, dst, a_shift);
+		}
+		return Over(MulUn8x4(src, opacity), dst, a_shift);
+	}
+}
+
+#endif
@@ -33,6 +33,9 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	/** Panoramas are redrawn completely, only an empty plane is tracked */
+	bool TracksDamage() const override;
+
 	BitmapRef const& GetBitmap() const;
 	void SetBitmap(BitmapRef const& bitmap);
 	int GetOx() const;
@@ -53,6 +56,10 @@ private:
 	bool needs_refresh = false;
 };
 
+inline bool Plane::TracksDamage() const {
+	return !bitmap;
+}
+
 inline BitmapRef const& Plane::GetBitmap() const {
 	return bitmap;
 }
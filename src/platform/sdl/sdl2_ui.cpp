@@ -15,8 +15,10 @@
  * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
  */
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 #include "game_config.h"
 #include "system.h"
 #include "sdl2_ui.h"
@@ -41,6 +43,7 @@
 #include "output.h"
 #include "player.h"
 #include "bitmap.h"
+#include "game_clock.h"
 #include "lcf/scope_guard.h"
 
 #if defined(__APPLE__) && TARGET_OS_OSX
@@ -148,6 +151,24 @@ HWND GetWindowHandle(SDL_Window* window) {
 #endif
 
 static int FilterUntilFocus(const SDL_Event* evnt);
+static int FilterRendererEvents(void* userdata, SDL_Event* evnt);
+
+// The renderer is used from another thread, this is not possible with the
+// SDL ports that depend on a specific thread for drawing
+#if defined(HAVE_THREADS) && !defined(__WIIU__) && !defined(__ANDROID__)
+constexpr bool threaded_presentation_supported = true;
+#else
+constexpr bool threaded_presentation_supported = false;
+#endif
+
+static void ReleaseRenderContext() {
+	// An OpenGL context can only be current on one thread.
+	// SDL makes it current again when the renderer is used the next time.
+	SDL_Window* window = SDL_GL_GetCurrentWindow();
+	if (window) {
+		SDL_GL_MakeCurrent(window, nullptr);
+	}
+}
 
 #if defined(USE_KEYBOARD) && defined(SUPPORT_KEYBOARD)
 static Input::Keys::InputKey SdlKey2InputKey(SDL_Keycode sdlkey);
@@ -157,7 +178,7 @@ static Input::Keys::InputKey SdlKey2InputKey(SDL_Keycode sdlkey);
 static Input::Keys::InputKey SdlJKey2InputKey(int button_index);
 #endif
 
-Sdl2Ui::Sdl2Ui(long width, long height, const Game_Config& cfg) : BaseUi(cfg)
+Sdl2Ui::Sdl2Ui(long width, long height, const Game_Config& cfg) : BaseUi(cfg), present_thread(ReleaseRenderContext)
 {
 	// Set some SDL environment variables before starting. These are platform
 	// dependent, so every port needs to set them manually
@@ -182,6 +203,11 @@ Sdl2Ui::Sdl2Ui(long width, long height, const Game_Config& cfg) : BaseUi(cfg)
 
 	SetTitle(GAME_TITLE);
 
+	if (threaded_presentation_supported) {
+		// Runs before SDL updates the renderer state for these events
+		SDL_SetEventFilter(FilterRendererEvents, &present_thread);
+	}
+
 #if (defined(USE_JOYSTICK) && defined(SUPPORT_JOYSTICK)) || (defined(USE_JOYSTICK_AXIS) && defined(SUPPORT_JOYSTICK_AXIS))
 	if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) < 0) {
 		Output::Warning("Couldn't initialize joystick. {}", SDL_GetError());
@@ -206,6 +232,10 @@ Sdl2Ui::Sdl2Ui(long width, long height, const Game_Config& cfg) : BaseUi(cfg)
 }
 
 Sdl2Ui::~Sdl2Ui() {
+	present_thread.Stop();
+	SetZeroCopy(false);
+	SDL_SetEventFilter(nullptr, nullptr);
+
 	if (sdl_joystick) {
 		SDL_JoystickClose(sdl_joystick);
 	}
@@ -225,6 +255,9 @@ Sdl2Ui::~Sdl2Ui() {
 }
 
 bool Sdl2Ui::vChangeDisplaySurfaceResolution(int new_width, int new_height) {
+	present_thread.Stop();
+	SetZeroCopy(false);
+
 	SDL_Texture* new_sdl_texture_game = SDL_CreateTexture(sdl_renderer,
 		texture_format,
 		SDL_TEXTUREACCESS_STREAMING,
@@ -240,6 +273,8 @@ bool Sdl2Ui::vChangeDisplaySurfaceResolution(int new_width, int new_height) {
 	}
 
 	sdl_texture_game = new_sdl_texture_game;
+	texture_valid = false;
+	zero_copy_faster = CalibrateZeroCopy();
 
 	BitmapRef new_main_surface = Bitmap::Create(new_width, new_height, Color(0, 0, 0, 255));
 
@@ -250,6 +285,7 @@ bool Sdl2Ui::vChangeDisplaySurfaceResolution(int new_width, int new_height) {
 
 	main_surface = new_main_surface;
 	window.size_changed = true;
+	SetZeroCopy(zero_copy_faster && !IsThreadedPresentation());
 
 	BeginDisplayModeChange();
 
@@ -436,6 +472,8 @@ bool Sdl2Ui::RefreshDisplayMode() {
 			Output::Debug("SDL_CreateTexture failed : {}", SDL_GetError());
 			return false;
 		}
+		texture_valid = false;
+		zero_copy_faster = CalibrateZeroCopy();
 
 #ifdef _WIN32
 		HWND window = GetWindowHandle(sdl_window);
@@ -483,12 +521,14 @@ bool Sdl2Ui::RefreshDisplayMode() {
 		// Drawing surface will be the window itself
 		main_surface = Bitmap::Create(
 			display_width, display_height, Color(0, 0, 0, 255));
+		SetZeroCopy(zero_copy_faster && !IsThreadedPresentation());
 	}
 
 	return true;
 }
 
 void Sdl2Ui::ToggleFullscreen() {
+	present_thread.Stop();
 	BeginDisplayModeChange();
 	if ((current_display_mode.flags & SDL_WINDOW_FULLSCREEN_DESKTOP) == SDL_WINDOW_FULLSCREEN_DESKTOP) {
 		current_display_mode.flags &= ~SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -503,6 +543,7 @@ void Sdl2Ui::ToggleFullscreen() {
 
 void Sdl2Ui::ToggleZoom() {
 #ifdef SUPPORT_ZOOM
+	present_thread.Stop();
 	BeginDisplayModeChange();
 	// Work around a SDL bug which doesn't demaximize the window when the size
 	// is changed
@@ -559,17 +600,32 @@ bool Sdl2Ui::ProcessEvents() {
 }
 
 void Sdl2Ui::SetScalingMode(ConfigEnum::ScalingMode mode) {
+	present_thread.Stop();
 	window.size_changed = true;
 	vcfg.scaling_mode.Set(mode);
 }
 
 void Sdl2Ui::ToggleStretch() {
+	present_thread.Stop();
 	window.size_changed = true;
 	vcfg.stretch.Toggle();
 }
 
+void Sdl2Ui::TogglePartialUpdate() {
+	present_thread.Stop();
+	BaseUi::TogglePartialUpdate();
+	texture_valid = false;
+}
+
+void Sdl2Ui::ToggleThreadedPresentation() {
+	present_thread.Stop();
+	vcfg.threaded_presentation.Toggle();
+}
+
 void Sdl2Ui::ToggleVsync() {
 #if SDL_VERSION_ATLEAST(2, 0, 18)
+	present_thread.Stop();
+
 	// Modifying vsync requires recreating the renderer
 	vcfg.vsync.Toggle();
 
@@ -584,25 +640,64 @@ void Sdl2Ui::ToggleVsync() {
 #endif
 }
 
+bool Sdl2Ui::IsThreadedPresentation() const {
+	return threaded_presentation_supported && vcfg.threaded_presentation.Get();
+}
+
 void Sdl2Ui::UpdateDisplay() {
-#ifdef __WIIU__
-	if (vcfg.scaling_mode.Get() == ConfigEnum::ScalingMode::Bilinear && window.scale > 0.f) {
-		// Workaround WiiU bug: Bilinear uses a render target and for these the format is not converted
-		void* target_pixels;
-		int target_pitch;
+	if (!IsThreadedPresentation()) {
+		present_thread.Stop();
+		SetZeroCopy(zero_copy_faster);
+		UpdateViewport();
+		if (zero_copy) {
+			PresentZeroCopy();
+		} else {
+			PresentFrame(*main_surface, TakePresentRects());
+		}
+		return;
+	}
 
-		SDL_LockTexture(sdl_texture_game, nullptr, &target_pixels, &target_pitch);
-		SDL_ConvertPixels(main_surface->width(), main_surface->height(), GetDefaultFormat(), main_surface->pixels(),
-			main_surface->pitch(), SDL_PIXELFORMAT_RGBA8888, target_pixels, target_pitch);
-		SDL_UnlockTexture(sdl_texture_game);
-	} else {
-		SDL_UpdateTexture(sdl_texture_game, nullptr, main_surface->pixels(), main_surface->pitch());
+	// The next frame is drawn while the texture is in use
+	SetZeroCopy(false);
+
+	// Only one frame is in flight, this bounds the input latency to one frame
+	present_thread.Wait();
+
+	if (window.size_changed && window.width > 0 && window.height > 0) {
+		// The renderer is changed, this is not possible while a frame is displayed
+		present_thread.Stop();
+		UpdateViewport();
+	}
+
+	auto rects = TakePresentRects();
+	if (!present_surface || present_surface->GetRect() != main_surface->GetRect()) {
+		present_surface = Bitmap::Create(main_surface->width(), main_surface->height(), false);
+		rects = { main_surface->GetRect() };
 	}
-#else
-	// SDL_UpdateTexture was found to be faster than SDL_LockTexture / SDL_UnlockTexture.
-	SDL_UpdateTexture(sdl_texture_game, nullptr, main_surface->pixels(), main_surface->pitch());
-#endif
 
+	// The frame is copied because the next frame is drawn into main_surface
+	// while this one is displayed. present_surface holds the last frame,
+	// only the changed parts are copied.
+	auto* src = static_cast<const uint8_t*>(main_surface->pixels());
+	auto* dst = static_cast<uint8_t*>(present_surface->pixels());
+	for (const auto& rect: rects) {
+		const size_t row_size = rect.width * main_surface->bpp();
+		const size_t offset = rect.x * main_surface->bpp();
+		for (int y = rect.y; y < rect.y + rect.height; ++y) {
+			memcpy(dst + y * present_surface->pitch() + offset, src + y * main_surface->pitch() + offset, row_size);
+		}
+	}
+
+	if (!present_thread.IsRunning()) {
+		ReleaseRenderContext();
+	}
+
+	present_thread.Submit([this, rects = std::move(rects)]() {
+		PresentFrame(*present_surface, rects);
+	});
+}
+
+void Sdl2Ui::UpdateViewport() {
 	if (window.size_changed && window.width > 0 && window.height > 0) {
 		// Based on SDL2 function UpdateLogicalSize
 		window.size_changed = false;
@@ -678,7 +773,53 @@ void Sdl2Ui::UpdateDisplay() {
 			}
 		}
 	}
+}
+
+std::vector<Rect> Sdl2Ui::TakePresentRects() {
+	const auto& rects = TakeDisplayDamage();
+
+	if (!texture_valid || !IsPartialUpdate()) {
+		texture_valid = true;
+		return { main_surface->GetRect() };
+	}
 
+	return rects;
+}
+
+void Sdl2Ui::PresentFrame(const Bitmap& frame, const std::vector<Rect>& rects) {
+#ifdef __WIIU__
+	(void)rects;
+
+	if (vcfg.scaling_mode.Get() == ConfigEnum::ScalingMode::Bilinear && window.scale > 0.f) {
+		// Workaround WiiU bug: Bilinear uses a render target and for these the format is not converted
+		void* target_pixels;
+		int target_pitch;
+
+		SDL_LockTexture(sdl_texture_game, nullptr, &target_pixels, &target_pitch);
+		SDL_ConvertPixels(frame.width(), frame.height(), GetDefaultFormat(), frame.pixels(),
+			frame.pitch(), SDL_PIXELFORMAT_RGBA8888, target_pixels, target_pitch);
+		SDL_UnlockTexture(sdl_texture_game);
+	} else {
+		SDL_UpdateTexture(sdl_texture_game, nullptr, frame.pixels(), frame.pitch());
+	}
+#else
+	if (rects.size() == 1 && rects[0] == frame.GetRect()) {
+		SDL_UpdateTexture(sdl_texture_game, nullptr, frame.pixels(), frame.pitch());
+	} else {
+		// Only transfer the parts of the screen that changed since the last frame
+		auto* pixels = static_cast<const uint8_t*>(frame.pixels());
+		for (const auto& rect: rects) {
+			SDL_Rect sdl_rect = { rect.x, rect.y, rect.width, rect.height };
+			SDL_UpdateTexture(sdl_texture_game, &sdl_rect,
+				pixels + rect.y * frame.pitch() + rect.x * frame.bpp(), frame.pitch());
+		}
+	}
+#endif
+
+	RenderFrame();
+}
+
+void Sdl2Ui::RenderFrame() {
 	SDL_RenderClear(sdl_renderer);
 	if (vcfg.scaling_mode.Get() == ConfigEnum::ScalingMode::Bilinear && window.scale > 0.f) {
 		// Render game texture on the scaled texture
@@ -694,6 +835,171 @@ void Sdl2Ui::UpdateDisplay() {
 	SDL_RenderPresent(sdl_renderer);
 }
 
+bool Sdl2Ui::CalibrateZeroCopy() {
+#ifdef __WIIU__
+	// The texture is converted on upload, see PresentFrame
+	return false;
+#else
+	// Streaming textures are write-only and the locked memory may be a staging
+	// buffer that is uploaded completely on unlock (OpenGL, GLES, Direct3D),
+	// which saves nothing. Only renderers where the locked memory is the
+	// texture itself are considered.
+	static constexpr const char* zero_copy_renderers[] = { "software" };
+
+	SDL_RendererInfo rinfo = {};
+	if (SDL_GetRendererInfo(sdl_renderer, &rinfo) != 0 || !rinfo.name) {
+		return false;
+	}
+	if (std::none_of(std::begin(zero_copy_renderers), std::end(zero_copy_renderers),
+			[&](const char* name) { return std::strcmp(name, rinfo.name) == 0; })) {
+		return false;
+	}
+
+	int width, height;
+	if (SDL_QueryTexture(sdl_texture_game, nullptr, nullptr, &width, &height) != 0) {
+		return false;
+	}
+
+	// The frame is drawn over several frames, so the texture memory must not move
+	// and must keep its content when the texture is locked again
+	void* pixels;
+	int pitch;
+	if (SDL_LockTexture(sdl_texture_game, nullptr, &pixels, &pitch) != 0) {
+		return false;
+	}
+
+	auto* words = static_cast<uint32_t*>(pixels);
+	const int num_words = pitch / 4 * height;
+	for (int i = 0; i < num_words; ++i) {
+		words[i] = i * 2654435761u;
+	}
+	SDL_UnlockTexture(sdl_texture_game);
+
+	void* relocked_pixels;
+	int relocked_pitch;
+	if (SDL_LockTexture(sdl_texture_game, nullptr, &relocked_pixels, &relocked_pitch) != 0) {
+		return false;
+	}
+
+	bool persistent = relocked_pixels == pixels && relocked_pitch == pitch;
+	for (int i = 0; persistent && i < num_words; ++i) {
+		persistent = words[i] == i * 2654435761u;
+	}
+	std::memset(relocked_pixels, 0, relocked_pitch * height);
+	SDL_UnlockTexture(sdl_texture_game);
+
+	if (!persistent) {
+		Output::Debug("SDL2: Texture memory is not persistent, frames are uploaded");
+		return false;
+	}
+
+	// Compares the upload of a full frame with the unlock of a drawn frame
+	constexpr int warmup_rounds = 4;
+	constexpr int rounds = 16;
+	std::vector<uint8_t> frame(pitch * height);
+
+	auto update = [&]() {
+		SDL_UpdateTexture(sdl_texture_game, nullptr, frame.data(), pitch);
+	};
+	auto lock = [&]() {
+		void* locked_pixels;
+		int locked_pitch;
+		SDL_LockTexture(sdl_texture_game, nullptr, &locked_pixels, &locked_pitch);
+		SDL_UnlockTexture(sdl_texture_game);
+	};
+	auto measure = [&](auto&& upload) {
+		const auto start = Game_Clock::now();
+		upload();
+		SDL_RenderCopy(sdl_renderer, sdl_texture_game, nullptr, nullptr);
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+		SDL_RenderFlush(sdl_renderer);
+#endif
+		return Game_Clock::now() - start;
+	};
+
+	for (int i = 0; i < warmup_rounds; ++i) {
+		measure(update);
+		measure(lock);
+	}
+
+	// The order alternates, so neither method always runs with warm caches
+	Game_Clock::duration update_time = {};
+	Game_Clock::duration lock_time = {};
+	for (int i = 0; i < rounds; ++i) {
+		if (i % 2 == 0) {
+			update_time += measure(update);
+			lock_time += measure(lock);
+		} else {
+			lock_time += measure(lock);
+			update_time += measure(update);
+		}
+	}
+	SDL_RenderClear(sdl_renderer);
+
+	Output::Debug("SDL2: Frame upload {}us, texture lock {}us",
+		std::chrono::duration_cast<std::chrono::microseconds>(update_time).count() / rounds,
+		std::chrono::duration_cast<std::chrono::microseconds>(lock_time).count() / rounds);
+
+	// Measurements are noisy, only switch when it is clearly faster
+	return lock_time * 4 < update_time * 3;
+#endif
+}
+
+void Sdl2Ui::SetZeroCopy(bool enable) {
+	if (enable == zero_copy || !main_surface) {
+		return;
+	}
+
+	if (enable) {
+		void* pixels;
+		int pitch;
+		if (SDL_LockTexture(sdl_texture_game, nullptr, &pixels, &pitch) != 0) {
+			Output::Debug("SDL2: SDL_LockTexture failed: {}", SDL_GetError());
+			zero_copy_faster = false;
+			return;
+		}
+
+		auto surface = Bitmap::Create(pixels, main_surface->width(), main_surface->height(), pitch, Bitmap::pixel_format);
+		surface->BlitFast(0, 0, *main_surface, main_surface->GetRect(), Opacity::Opaque());
+		main_surface = surface;
+		zero_copy = true;
+		Output::Debug("SDL2: Drawing directly into the texture");
+	} else {
+		auto surface = Bitmap::Create(main_surface->width(), main_surface->height(), Color(0, 0, 0, 255));
+		surface->BlitFast(0, 0, *main_surface, main_surface->GetRect(), Opacity::Opaque());
+		SDL_UnlockTexture(sdl_texture_game);
+		main_surface = surface;
+		zero_copy = false;
+	}
+}
+
+void Sdl2Ui::PresentZeroCopy() {
+	// The whole texture is uploaded, the reported changes are not needed
+	TakeDisplayDamage();
+
+	// Unlocking uploads the frame
+	SDL_UnlockTexture(sdl_texture_game);
+	RenderFrame();
+
+	void* pixels = nullptr;
+	int pitch = 0;
+	const bool locked = SDL_LockTexture(sdl_texture_game, nullptr, &pixels, &pitch) == 0;
+	if (locked && pixels == main_surface->pixels() && pitch == main_surface->pitch()) {
+		return;
+	}
+
+	// The texture memory moved (e.g. the renderer was reset), the content of
+	// main_surface is lost and the next frame is drawn completely anyway
+	Output::Debug("SDL2: Texture memory moved, frames are uploaded");
+	if (locked) {
+		SDL_UnlockTexture(sdl_texture_game);
+	}
+	main_surface = Bitmap::Create(main_surface->width(), main_surface->height(), Color(0, 0, 0, 255));
+	zero_copy = false;
+	zero_copy_faster = false;
+	texture_valid = false;
+}
+
 void Sdl2Ui::SetTitle(const std::string &title) {
 	SDL_SetWindowTitle(sdl_window, title.c_str());
 }
@@ -708,6 +1014,8 @@ bool Sdl2Ui::ShowCursor(bool flag) {
 bool Sdl2Ui::HandleErrorOutput(const std::string &message) {
 	std::string title = Player::GetFullVersionString();
 
+	present_thread.Stop();
+
 	// Manually Restore window from fullscreen, since message would not be visible otherwise
 	if ((current_display_mode.flags & SDL_WINDOW_FULLSCREEN_DESKTOP)
 		== SDL_WINDOW_FULLSCREEN_DESKTOP) {
@@ -776,6 +1084,13 @@ void Sdl2Ui::ProcessEvent(SDL_Event &evnt) {
 		case SDL_FINGERMOTION:
 			ProcessFingerEvent(evnt);
 			return;
+
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			// Texture content is lost, the next frame must be transferred completely
+			present_thread.Stop();
+			texture_valid = false;
+			return;
 	}
 }
 
@@ -1260,6 +1575,20 @@ int FilterUntilFocus(const SDL_Event* evnt) {
 	}
 }
 
+int FilterRendererEvents(void* userdata, SDL_Event* evnt) {
+	// SDL changes the renderer when these events are queued, the present
+	// thread must not use the renderer at the same time
+	switch (evnt->type) {
+	case SDL_WINDOWEVENT:
+	case SDL_RENDER_TARGETS_RESET:
+	case SDL_RENDER_DEVICE_RESET:
+		static_cast<PresentThread*>(userdata)->Stop();
+		break;
+	}
+
+	return 1;
+}
+
 void Sdl2Ui::vGetConfig(Game_ConfigVideo& cfg) const {
 #ifdef EMSCRIPTEN
 	cfg.renderer.Lock("SDL2 (Software, Emscripten)");
@@ -1282,6 +1611,7 @@ void Sdl2Ui::vGetConfig(Game_ConfigVideo& cfg) const {
 	cfg.stretch.SetOptionVisible(true);
 	cfg.game_resolution.SetOptionVisible(true);
 	cfg.pause_when_focus_lost.SetOptionVisible(true);
+	cfg.threaded_presentation.SetOptionVisible(threaded_presentation_supported);
 
 	cfg.vsync.Set(current_display_mode.vsync);
 	cfg.window_zoom.Set(current_display_mode.zoom);
@@ -21,6 +21,7 @@
 // Headers
 #include "baseui.h"
 #include "color.h"
+#include "present_thread.h"
 #include "rect.h"
 #include "system.h"
 
@@ -69,6 +70,8 @@ public:
 	void SetScalingMode(ConfigEnum::ScalingMode) override;
 	void ToggleStretch() override;
 	void ToggleVsync() override;
+	void TogglePartialUpdate() override;
+	void ToggleThreadedPresentation() override;
 	void vGetConfig(Game_ConfigVideo& cfg) const override;
 	bool OpenURL(StringView url) override;
 	Rect GetWindowMetrics() const override;
@@ -124,6 +127,51 @@ private:
 
 	void RequestVideoMode(int width, int height, int zoom, bool fullscreen, bool vsync);
 
+	/** @return whether frames are displayed on the present thread */
+	bool IsThreadedPresentation() const;
+
+	/** Recalculates the viewport after the window size or the scaling changed. */
+	void UpdateViewport();
+
+	/**
+	 * Returns the parts of main_surface that must be uploaded to the game
+	 * texture. This is everything when the texture content is unknown.
+	 *
+	 * @return rects to upload
+	 */
+	std::vector<Rect> TakePresentRects();
+
+	/**
+	 * Uploads the changed parts of the frame to the game texture and displays it.
+	 *
+	 * @param frame frame to display
+	 * @param rects parts of the frame that changed since the last upload
+	 */
+	void PresentFrame(const Bitmap& frame, const std::vector<Rect>& rects);
+
+	/** Displays the game texture. */
+	void RenderFrame();
+
+	/**
+	 * Measures whether drawing directly into the locked game texture is
+	 * possible and faster than uploading the frame with SDL_UpdateTexture.
+	 * Only renderers known to lock the texture memory itself are measured.
+	 *
+	 * @return whether drawing into the texture is clearly faster
+	 */
+	bool CalibrateZeroCopy();
+
+	/**
+	 * Switches main_surface between the locked game texture and an own bitmap.
+	 * The content of the screen is kept.
+	 *
+	 * @param enable draw into the game texture
+	 */
+	void SetZeroCopy(bool enable);
+
+	/** Displays main_surface when it is drawn into the game texture. */
+	void PresentZeroCopy();
+
 	/** Last display mode. */
 	DisplayMode last_display_mode;
 
@@ -145,6 +193,24 @@ private:
 
 	uint32_t texture_format = SDL_PIXELFORMAT_UNKNOWN;
 
+	/** The game texture contains the last uploaded frame */
+	bool texture_valid = false;
+
+	/** Copy of the last frame that is displayed by the present thread */
+	BitmapRef present_surface;
+
+	/** main_surface points to the memory of the locked game texture */
+	bool zero_copy = false;
+
+	/** Result of CalibrateZeroCopy for the current game texture */
+	bool zero_copy_faster = false;
+
+	/**
+	 * Displays frames while the next frame is calculated.
+	 * Must be stopped before the renderer is used on the main thread.
+	 */
+	PresentThread present_thread;
+
 #ifdef SUPPORT_AUDIO
 	std::unique_ptr<AudioInterface> audio_;
 #endif
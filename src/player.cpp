@@ -35,6 +35,7 @@
 #include "async_handler.h"
 #include "audio.h"
 #include "cache.h"
+#include "image_disk_cache.h"
 #include "rand.h"
 #include "cmdline_parser.h"
 #include "dynrpg.h"
@@ -145,6 +146,9 @@ namespace {
 	// Overwritten by --encoding
 	std::string forced_encoding;
 
+	// Set by --cache-report
+	bool cache_report = false;
+
 	FileRequestBinding system_request_id;
 	FileRequestBinding save_request_id;
 	FileRequestBinding map_request_id;
@@ -196,6 +200,12 @@ void Player::Init(std::vector<std::string> args) {
 	Input::AddRecordingData(Input::RecordingData::CommandLine, command_line);
 
 	player_config = std::move(cfg.player);
+	Cache::SetSizeLimit(static_cast<size_t>(player_config.cache_size.Get()) * 1024 * 1024);
+	Cache::SetEffectSizeLimit(static_cast<size_t>(player_config.effect_cache_size.Get()) * 1024 * 1024);
+	ImageDiskCache::SetSizeLimit(static_cast<uint64_t>(player_config.image_disk_cache_size.Get()) * 1024 * 1024);
+	ImageDiskCache::SetPath(player_config.image_disk_cache.Get());
+	// Input logs only replay correctly when files are loaded in the same frame
+	AsyncHandler::SetThreaded(player_config.threaded_loading.Get() && replay_input_path.empty() && record_input_path.empty());
 	speed_modifier_a = cfg.input.speed_modifier_a.Get();
 	speed_modifier_b = cfg.input.speed_modifier_b.Get();
 }
@@ -340,6 +350,10 @@ void Player::Update(bool update_scene) {
 		IncFrame();
 	}
 
+	// Images decoded on worker threads are passed to their listeners here
+	AsyncHandler::Update();
+	Output::Update();
+
 	Audio().Update();
 	Input::Update();
 
@@ -398,6 +412,21 @@ void Player::Exit() {
 	}
 
 	Graphics::UpdateSceneCallback();
+
+	if (cache_report) {
+		auto report = [](StringView name, const Cache::Stats& stats) {
+			Output::Info("{}: {} hits, {} misses, {} preloaded, {} evictions, {} images, {} KiB resident, {} KiB pinned",
+				name, stats.hits, stats.misses, stats.preloaded, stats.evictions, stats.entries, stats.size / 1024, stats.pinned / 1024);
+		};
+		report("Image cache", Cache::GetStats());
+		report("Sprite effect cache", Cache::GetSpriteEffectStats());
+		if (ImageDiskCache::IsEnabled()) {
+			auto disk_stats = ImageDiskCache::GetStats();
+			Output::Info("Image disk cache: {} hits, {} misses, {} stored, {} removed",
+				disk_stats.hits, disk_stats.misses, disk_stats.stored, disk_stats.removed);
+		}
+	}
+
 #ifdef EMSCRIPTEN
 	BitmapRef surface = DisplayUi->GetDisplaySurface();
 	std::string message = "It's now safe to turn off\n      your browser.";
@@ -411,6 +440,8 @@ void Player::Exit() {
 	Player::ResetGameObjects();
 	Font::Dispose();
 	DynRpg::Reset();
+	// Written while the message overlay exists
+	Output::Update();
 	Graphics::Quit();
 	Output::Quit();
 	FileFinder::Quit();
@@ -632,6 +663,10 @@ Game_Config Player::ParseCommandLine() {
 			}
 			continue;
 		}
+		if (cp.ParseNext(arg, 0, "--cache-report")) {
+			cache_report = true;
+			continue;
+		}
 		if (cp.ParseNext(arg, 0, "--no-log-color")) {
 			Output::SetTermColor(false);
 			continue;
@@ -1386,8 +1421,14 @@ Engine options:
                                  fixes.
                        ATTACK  - Like RPG_RT+ but only physical attacks, no
                                  skills.
+ --cache-report       Log statistics of the image cache on exit.
+ --cache-size MIB     Memory in MiB for images that are not displayed anymore.
+                      The default is 10.
  -c, --config-path P  Set a custom configuration path. When not specified, the
                       configuration folder in the users home directory is used.
+ --effect-cache-size MIB
+                      Memory in MiB for sprites that are drawn with tone, flash,
+                      flip or hue effects. The default is 4.
  --encoding N         Instead of autodetecting the encoding or using the one in
                       RPG_RT.ini, the encoding N is used.
  --enemyai-algo A     Which EnemyAI algorithm to use.
@@ -1411,6 +1452,13 @@ Engine options:
  --font2-size PX      Size of font 2 in pixel. The default is 12.
  --font-path PATH     The path in which the settings scene looks for fonts.
                       The default is config-path/Font.
+ --image-disk-cache PATH
+                      Store decoded images in PATH and load them from there on
+                      the next start instead of decoding them again.
+ --image-disk-cache-size MIB
+                      Disk space in MiB for the image disk cache. The least
+                      recently used images are removed when it is exceeded.
+                      The default is 256.
  --language LANG      Load the game translation in language/LANG folder.
  --load-game-id N     Skip the title scene and load SaveN.lsd (N is padded to
                       two digits).
@@ -1438,6 +1486,10 @@ Engine options:
                       of the engine.
  --no-patch           Disable all engine patches. To disable a single patch,
                       prefix any of the patch options with --no-
+ --prefetch-size MIB  Memory in MiB for images that the events of a map use and
+                      that are loaded in advance when the map is entered, and
+                      for the images of the title, menu and battle scene.
+                      The default is 4. 0 disables prefetching.
  --project-path PATH  Instead of using the working directory, the game in PATH
                       is used.
  --record-input FILE  Record all button inputs to FILE.
@@ -1449,6 +1501,9 @@ Engine options:
                       store them in PATH. When using the game browser all games
                       will share the same save directory!
  --seed N             Seeds the random number generator with N.
+ --threaded-loading   Decode images on separate threads while the game
+                      continues. Always off when input is recorded or replayed.
+                      Off by default.
 
 Providing any patch option disables the patch autodetection of the engine.
 
@@ -1463,6 +1518,9 @@ Video options:
                        original   - 320x240 (4:3). Recommended
                        widescreen - 416x240 (16:9)
                        ultrawide  - 560x240 (21:9)
+ --partial-update     Only draw and transfer the parts of the screen that
+                      changed. Disable with --no-partial-update to redraw
+                      the whole screen every frame.
  --pause-focus-lost   Pause the game when the window has no focus.
                       Disable with --no-pause-focus-lost.
  --scaling S          How the video output is scaled.
@@ -1481,6 +1539,12 @@ Video options:
  --stretch            Ignore the aspect ratio and stretch video output to the
                       entire width of the screen.
                       Disable with --no-stretch.
+ --threaded-presentation
+                      Display a frame on a separate thread while the next
+                      frame is calculated. Useful with vsync.
+                      Disable with --no-threaded-presentation.
+ --threaded-rendering Draw the screen with all CPU cores.
+                      Disable with --no-threaded-rendering.
  --vsync              Enables vertical sync if supported on this platform.
                       Disable with --no-vsync.
  --window             Start in windowed mode.
@@ -0,0 +1,111 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "present_thread.h"
+
+PresentThread::PresentThread(std::function<void()> on_exit) : on_exit(std::move(on_exit)) {
+}
+
+PresentThread::~PresentThread() {
+	Stop();
+}
+
+#ifdef HAVE_THREADS
+
+void PresentThread::Submit(std::function<void()> func) {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		idle_cv.wait(lock, [this]() { return !job; });
+		job = std::move(func);
+	}
+
+	if (!thread.joinable()) {
+		quit = false;
+		thread = std::thread(&PresentThread::ThreadFunction, this);
+	} else {
+		job_cv.notify_one();
+	}
+}
+
+void PresentThread::Wait() {
+	if (!thread.joinable() || IsCurrentThread()) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	idle_cv.wait(lock, [this]() { return !job; });
+}
+
+void PresentThread::Stop() {
+	if (!thread.joinable() || IsCurrentThread()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	job_cv.notify_one();
+
+	thread.join();
+	thread = std::thread();
+}
+
+bool PresentThread::IsCurrentThread() const {
+	return std::this_thread::get_id() == thread.get_id();
+}
+
+void PresentThread::ThreadFunction() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+		job_cv.wait(lock, [this]() { return quit || job; });
+
+		// A pending job is finished before quitting
+		if (!job) {
+			break;
+		}
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		job = nullptr;
+		idle_cv.notify_all();
+	}
+
+	lock.unlock();
+
+	if (on_exit) {
+		on_exit();
+	}
+}
+
+#else
+
+void PresentThread::Submit(std::function<void()> func) {
+	func();
+}
+
+void PresentThread::Wait() {
+}
+
+void PresentThread::Stop() {
+}
+
+#endif
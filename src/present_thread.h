@@ -0,0 +1,100 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_PRESENT_THREAD_H
+#define EP_PRESENT_THREAD_H
+
+// Headers
+#include <functional>
+#ifdef HAVE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+/**
+ * A thread that displays finished frames while the next frame is calculated.
+ *
+ * Only one frame is in flight: Submit waits until the previous frame was
+ * displayed. The thread is started by Submit and ends on Stop, this way
+ * the owner can use resources that are bound to a thread (e.g. an OpenGL
+ * context) after stopping it.
+ *
+ * When the Player is built without thread support the function passed to
+ * Submit is called immediately.
+ */
+class PresentThread {
+public:
+	/**
+	 * @param on_exit called on the thread before it ends
+	 */
+	explicit PresentThread(std::function<void()> on_exit = {});
+
+	PresentThread(const PresentThread&) = delete;
+	PresentThread& operator=(const PresentThread&) = delete;
+
+	/** Stops the thread */
+	~PresentThread();
+
+	/**
+	 * Waits until the previous function finished and runs func on the thread.
+	 * Starts the thread when it is not running.
+	 *
+	 * @param func function to run
+	 */
+	void Submit(std::function<void()> func);
+
+	/**
+	 * Waits until the last submitted function finished.
+	 * Does nothing when called from the thread itself.
+	 */
+	void Wait();
+
+	/**
+	 * Waits until the last submitted function finished and ends the thread.
+	 * Does nothing when called from the thread itself.
+	 */
+	void Stop();
+
+	/** @return whether the thread is running */
+	bool IsRunning() const;
+
+private:
+	std::function<void()> on_exit;
+
+#ifdef HAVE_THREADS
+	void ThreadFunction();
+	bool IsCurrentThread() const;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable job_cv;
+	std::condition_variable idle_cv;
+	std::function<void()> job;
+	bool quit = false;
+#endif
+};
+
+inline bool PresentThread::IsRunning() const {
+#ifdef HAVE_THREADS
+	return thread.joinable();
+#else
+	return false;
+#endif
+}
+
+#endif
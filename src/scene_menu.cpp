@@ -18,6 +18,7 @@
 // Headers
 #include <cassert>
 #include "scene_menu.h"
+#include "asset_prefetch.h"
 #include "audio.h"
 #include "cache.h"
 #include "game_party.h"
@@ -46,6 +47,9 @@ Scene_Menu::Scene_Menu(int menu_index) :
 }
 
 void Scene_Menu::Start() {
+	// Decode the faces of the party at once
+	AssetPrefetch::PrefetchScene(AssetPrefetch::CollectMenuImages());
+
 	CreateCommandWindow();
 
 	// Gold Window
@@ -24,6 +24,7 @@
 #include "scene_settings.h"
 #include "scene_title.h"
 #include "audio.h"
+#include "asset_prefetch.h"
 #include "audio_secache.h"
 #include "cache.h"
 #include "game_battle.h"
@@ -71,7 +72,10 @@ void Scene_Title::Start() {
 	}
 
 	// Skip background image and music if not used
-	if (CheckEnableTitleGraphicAndMusic()) {
+	const bool title_graphic = CheckEnableTitleGraphicAndMusic();
+	AssetPrefetch::PrefetchScene(AssetPrefetch::CollectTitleImages(title_graphic));
+
+	if (title_graphic) {
 		CreateTitleGraphic();
 		PlayTitleMusic();
 	}
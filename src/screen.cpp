@@ -19,8 +19,10 @@
 #include <string>
 #include "bitmap.h"
 #include "color.h"
+#include "damage_tracker.h"
 #include "game_screen.h"
 #include "main_data.h"
+#include "player.h"
 #include "screen.h"
 #include "drawable_mgr.h"
 
@@ -31,31 +33,39 @@ Screen::Screen() : Drawable(Priority_Screen)
 
 void Screen::Draw(Bitmap& dst) {
 	auto flash_color = Main_Data::game_screen->GetFlashColor();
-	if (flash_color.alpha > 0) {
-		if (!flash) {
-			flash = Bitmap::Create(dst.GetWidth(), dst.GetHeight(), flash_color);
-		} else {
-			flash->Fill(flash_color);
-		}
-		dst.Blit(0, 0, *flash, flash->GetRect(), 255);
-	}
 
+	// Clear all parts of the screen that are out-of-bounds
+	dst.FlashFill(flash_color, GetKeepRect(dst.GetRect()));
+}
+
+uint64_t Screen::GetDrawState(Rect& bounds) {
+	const auto flash_color = Main_Data::game_screen->GetFlashColor();
+	const Rect screen_rect(0, 0, Player::screen_width, Player::screen_height);
+	const Rect keep_rect = GetKeepRect(screen_rect);
+
+	// Nothing is drawn without a flash when the viewport covers the screen
+	bounds = (flash_color.alpha == 0 && keep_rect == screen_rect) ? Rect() : screen_rect;
+
+	return DrawStateHash().Add(flash_color).Add(keep_rect).Get();
+}
+
+Rect Screen::GetKeepRect(Rect screen_rect) const {
+	Rect keep_rect = screen_rect;
 	if (viewport != Rect()) {
-		// Clear all parts of the screen that are out-of-bounds
-		Rect dst_rect = dst.GetRect();
-		int dx = viewport.x - dst_rect.x;
-		int dy = viewport.y - dst_rect.y;
+		int dx = viewport.x - keep_rect.x;
+		int dy = viewport.y - keep_rect.y;
 
 		if (dx > 0) {
 			// Left and Right
-			dst.ClearRect({0, 0, dx, dst.GetHeight()});
-			dst.ClearRect({dst.GetWidth() - dx, 0, dx, dst.GetHeight()});
+			keep_rect.x = dx;
+			keep_rect.width = screen_rect.width - 2 * dx;
 		}
 
 		if (dy > 0) {
 			// Top and Bottom
-			dst.ClearRect({0, 0, dst.GetWidth(), dy});
-			dst.ClearRect({0, dst.GetHeight() - dy, dst.GetWidth(), dy});
+			keep_rect.y = dy;
+			keep_rect.height = screen_rect.height - 2 * dy;
 		}
 	}
+	return keep_rect;
 }
@@ -38,15 +38,27 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	Rect GetViewport() const;
 	void SetViewport(const Rect& rect);
 
 private:
-	BitmapRef flash;
+	/**
+	 * @param screen_rect rect of the screen
+	 * @return part of the screen inside of the viewport
+	 */
+	Rect GetKeepRect(Rect screen_rect) const;
 
 	Rect viewport;
 };
 
+inline bool Screen::TracksDamage() const {
+	return true;
+}
+
 inline Rect Screen::GetViewport() const {
 	return viewport;
 }
@@ -22,6 +22,7 @@
 #include "util_macro.h"
 #include "bitmap.h"
 #include "cache.h"
+#include "damage_tracker.h"
 #include "drawable_mgr.h"
 
 // Constructor
@@ -32,15 +33,64 @@ Sprite::Sprite(Drawable::Flags flags) : Drawable(0, flags)
 
 // Draw
 void Sprite::Draw(Bitmap& dst) {
-	if (GetWidth() <= 0 || GetHeight() <= 0) return;
+	PrepareBlit();
+	BlitPrepared(dst);
+}
+
+uint64_t Sprite::GetDrawState(Rect& bounds) {
+	bounds = {};
+
+	// Same checks as in PrepareBlit
+	if (GetWidth() <= 0 || GetHeight() <= 0 || !bitmap || (opacity_top_effect <= 0 && opacity_bottom_effect <= 0)) {
+		return 0;
+	}
+
+	bounds = GetScreenRect();
+
+	return DrawStateHash()
+		.Add(bitmap.get()).Add(bitmap->GetRevision())
+		.Add(src_rect).Add(src_rect_effect)
+		.Add(x).Add(y).Add(ox).Add(oy).Add(GetRenderOx()).Add(GetRenderOy())
+		.Add(opacity_top_effect).Add(opacity_bottom_effect).Add(bush_effect)
+		.Add(tone_effect).Add(flash_effect).Add(flipx_effect).Add(flipy_effect)
+		.Add(zoom_x_effect).Add(zoom_y_effect).Add(angle_effect)
+		.Add(blend_type_effect).Add(blend_color_effect)
+		.Add(waver_effect_depth).Add(waver_effect_depth != 0 ? waver_effect_phase : 0.0)
+		.Get();
+}
+
+bool Sprite::PrepareBlitBands() {
+	PrepareBlit();
+
+	if (!prepared_bitmap) {
+		return true;
+	}
 
-	BlitScreen(dst);
+	// Rotation, zoom and waver change the transformation of the source image while blitting
+	if (!effects_direct && (zoom_x_effect != 1.0 || zoom_y_effect != 1.0 || angle_effect != 0.0 || waver_effect_depth != 0)) {
+		return false;
+	}
+
+	// The bitmap is the source of all band threads, see Bitmap::PrepareParallelRead
+	prepared_bitmap->PrepareParallelRead();
+	return true;
 }
 
-void Sprite::BlitScreen(Bitmap& dst) {
+void Sprite::PrepareBlit() {
+	prepared_bitmap = nullptr;
+
+	if (GetWidth() <= 0 || GetHeight() <= 0)
+		return;
+
 	if (!bitmap || (opacity_top_effect <= 0 && opacity_bottom_effect <= 0))
 		return;
 
+	// Prevent effect sprite creation when not in the viewport
+	prepared_dst_rect = GetScreenRect();
+	if (prepared_dst_rect.IsOutOfBounds(Rect(0, 0, Player::screen_width, Player::screen_height))) {
+		return;
+	}
+
 	BitmapRef draw_bitmap = Refresh(src_rect_effect);
 	if (!draw_bitmap) {
 		return;
@@ -49,7 +99,7 @@ void Sprite::BlitScreen(Bitmap& dst) {
 	bitmap_changed = false;
 
 	Rect rect = src_rect_effect.GetSubRect(src_rect);
-	if (draw_bitmap == bitmap_effects) {
+	if (!effects_direct && draw_bitmap == bitmap_effects) {
 		// When a "sprite rect" (src_rect_effect) is used bitmap_effects
 		// only has the size of this subrect instead of the whole bitmap
 		rect.x %= bitmap_effects->GetWidth();
@@ -64,7 +114,25 @@ void Sprite::BlitScreen(Bitmap& dst) {
 		}
 	}
 
-	BlitScreenIntern(dst, *draw_bitmap, rect);
+	// The bitmap is kept alive by bitmap or bitmap_effects until the next refresh
+	prepared_bitmap = draw_bitmap.get();
+	prepared_rect = rect;
+}
+
+void Sprite::BlitPrepared(Bitmap& dst) const {
+	// Skips bands of the screen the sprite does not touch
+	if (!prepared_bitmap || prepared_dst_rect.IsOutOfBounds(dst.GetClipRect())) {
+		return;
+	}
+
+	if (effects_direct) {
+		dst.ToneBlendFlipBlit(x - (ox - GetRenderOx()), y - (oy - GetRenderOy()), *prepared_bitmap, prepared_rect,
+			flipx_effect, flipy_effect, tone_effect, flash_effect,
+			Opacity(opacity_top_effect, opacity_bottom_effect, bush_effect));
+		return;
+	}
+
+	BlitScreenIntern(dst, *prepared_bitmap, prepared_rect);
 }
 
 void Sprite::BlitScreenIntern(Bitmap& dst, Bitmap const& draw_bitmap, Rect const& src_rect) const
@@ -78,16 +146,12 @@ void Sprite::BlitScreenIntern(Bitmap& dst, Bitmap const& draw_bitmap, Rect const
 		waver_effect_depth, waver_effect_phase, static_cast<Bitmap::BlendMode>(blend_type_effect));
 }
 
-BitmapRef Sprite::Refresh(Rect& rect) {
-	if (zoom_x_effect == 1.0 && zoom_y_effect == 1.0 && angle_effect == 0.0 && waver_effect_depth == 0) {
-		// Prevent effect sprite creation when not in the viewport
-		// TODO: Out of bounds math adjustments for zoom, angle and waver
-		// but even without this will catch most of the cases
-		if (Rect(x - ox, y - oy, GetWidth(), GetHeight()).IsOutOfBounds(Rect(0, 0, Player::screen_width, Player::screen_height))) {
-			return BitmapRef();
-		}
-	}
+Rect Sprite::GetScreenRect() const {
+	return Bitmap::GetEffectsBlitRect(x, y, ox - GetRenderOx(), oy - GetRenderOy(), Rect(0, 0, GetWidth(), GetHeight()),
+		zoom_x_effect, zoom_y_effect, angle_effect, waver_effect_depth);
+}
 
+BitmapRef Sprite::Refresh(Rect& rect) {
 	rect.Adjust(bitmap->GetWidth(), bitmap->GetHeight());
 
 	bool no_tone = tone_effect == Tone();
@@ -104,6 +168,8 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 		bitmap_effects.reset();
 	}
 
+	effects_direct = false;
+
 	if (no_effects) {
 		return bitmap;
 	} else if (bitmap_effects) {
@@ -114,6 +180,14 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 		current_flip_x = flipx_effect;
 		current_flip_y = flipy_effect;
 
+		// Effects changing every frame (tone fades, flashes) are applied while blitting.
+		// The effect bitmap is only cached when nothing changed since the last frame.
+		if ((effects_changed || effects_rect_changed || bitmap_changed) && CanBlitEffectsDirect()) {
+			effects_direct = true;
+			bitmap_effects_src_rect = rect;
+			return bitmap;
+		}
+
 		bitmap_effects = Cache::SpriteEffect(bitmap, rect, flipx_effect, flipy_effect, current_tone, current_flash);
 		bitmap_effects_src_rect = rect;
 
@@ -121,6 +195,13 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 	}
 }
 
+bool Sprite::CanBlitEffectsDirect() const {
+	auto blend_mode = static_cast<Bitmap::BlendMode>(blend_type_effect);
+
+	return zoom_x_effect == 1.0 && zoom_y_effect == 1.0 && angle_effect == 0.0 && waver_effect_depth == 0 &&
+		(blend_mode == Bitmap::BlendMode::Default || blend_mode == Bitmap::BlendMode::Normal);
+}
+
 void Sprite::SetBitmap(BitmapRef const& nbitmap) {
 	bitmap = nbitmap;
 	if (!bitmap) {
@@ -34,6 +34,10 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	virtual int GetWidth() const;
 	virtual int GetHeight() const;
 
@@ -103,6 +107,22 @@ public:
 	 */
 	void SetFlashEffect(const Color &color);
 
+protected:
+	/**
+	 * Runs the part of Draw that updates the effect bitmap.
+	 * Used by subclasses that implement PrepareDraw.
+	 *
+	 * @return true when BlitPrepared can run for several bands of the screen at once
+	 */
+	bool PrepareBlitBands();
+
+	/**
+	 * Blits the sprite prepared by PrepareBlitBands.
+	 *
+	 * @param dst destination bitmap
+	 */
+	void BlitPrepared(Bitmap& dst) const;
+
 private:
 	BitmapRef bitmap;
 
@@ -137,13 +157,28 @@ private:
 	bool current_flip_x = false;
 	bool current_flip_y = false;
 	bool bitmap_changed = true;
+	bool effects_direct = false;
 
-	void BlitScreen(Bitmap& dst);
+	/** Bitmap and rect BlitPrepared draws, nullptr when nothing is drawn */
+	Bitmap* prepared_bitmap = nullptr;
+	Rect prepared_rect;
+	/** Screen rect covered by the prepared blit */
+	Rect prepared_dst_rect;
+
+	void PrepareBlit();
+	/** @return Screen rect covered by the sprite including zoom, angle and waver */
+	Rect GetScreenRect() const;
 	void BlitScreenIntern(Bitmap& dst, Bitmap const& draw_bitmap,
 							Rect const& src_rect) const;
 	BitmapRef Refresh(Rect& rect);
+	/** @return Whether tone, flash and flip can be applied while blitting */
+	bool CanBlitEffectsDirect() const;
 };
 
+inline bool Sprite::TracksDamage() const {
+	return true;
+}
+
 inline int Sprite::GetWidth() const {
 	return src_rect.width;
 }
@@ -55,6 +55,22 @@ void Sprite_AirshipShadow::RecreateShadow() {
 }
 
 void Sprite_AirshipShadow::Draw(Bitmap &dst) {
+	SyncShadow();
+
+	Sprite::Draw(dst);
+}
+
+bool Sprite_AirshipShadow::PrepareDraw() {
+	SyncShadow();
+
+	return false;
+}
+
+void Sprite_AirshipShadow::DrawPrepared(Bitmap& dst) {
+	Sprite::Draw(dst);
+}
+
+void Sprite_AirshipShadow::SyncShadow() {
 	Game_Vehicle* airship = Game_Map::GetVehicle(Game_Vehicle::Airship);
 	const int altitude = airship->GetAltitude();
 	const int max_altitude = TILE_SIZE;
@@ -63,8 +79,6 @@ void Sprite_AirshipShadow::Draw(Bitmap &dst) {
 
 	SetX(Main_Data::game_player->GetScreenX() + x_offset);
 	SetY(Main_Data::game_player->GetScreenY() + y_offset + Main_Data::game_player->GetJumpHeight());
-
-	Sprite::Draw(dst);
 }
 
 void Sprite_AirshipShadow::Update() {
@@ -33,10 +33,15 @@ class Sprite_AirshipShadow : public Sprite {
 public:
 	Sprite_AirshipShadow(int x_offset = 0, int y_offset = 0);
 	void Draw(Bitmap& dst) override;
+	bool PrepareDraw() override;
+	void DrawPrepared(Bitmap& dst) override;
 	void Update();
 	void RecreateShadow();
 
 private:
+	/** Follows the altitude and position of the airship */
+	void SyncShadow();
+
 	int x_offset = 0;
 	int y_offset = 0;
 };
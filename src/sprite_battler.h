@@ -45,6 +45,9 @@ public:
 
 	~Sprite_Battler() override;
 
+	/** Battlers are synchronized while drawing, the screen is redrawn completely while they are visible */
+	bool TracksDamage() const override;
+
 	Game_Battler* GetBattler() const;
 
 	void SetBattler(Game_Battler* new_battler);
@@ -98,4 +101,8 @@ inline Sprite_Battler::FixedFacing Sprite_Battler::GetFixedFacing() const {
 	return fixed_facing;
 }
 
+inline bool Sprite_Battler::TracksDamage() const {
+	return false;
+}
+
 #endif
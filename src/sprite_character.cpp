@@ -36,6 +36,22 @@ Sprite_Character::Sprite_Character(Game_Character* character, int x_offset, int
 }
 
 void Sprite_Character::Draw(Bitmap &dst) {
+	SyncCharacter();
+
+	Sprite::Draw(dst);
+}
+
+bool Sprite_Character::PrepareDraw() {
+	SyncCharacter();
+
+	return PrepareBlitBands();
+}
+
+void Sprite_Character::DrawPrepared(Bitmap& dst) {
+	BlitPrepared(dst);
+}
+
+void Sprite_Character::SyncCharacter() {
 	if (UsesCharset()) {
 		int row = character->GetFacing();
 		auto frame = character->GetAnimFrame();
@@ -52,8 +68,6 @@ void Sprite_Character::Draw(Bitmap &dst) {
 
 	int bush_split = 4 - character->GetBushDepth();
 	SetBushDepth(bush_split > 3 ? 0 : GetHeight() / bush_split);
-
-	Sprite::Draw(dst);
 }
 
 void Sprite_Character::Update() {
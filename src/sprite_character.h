@@ -43,6 +43,10 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool PrepareDraw() override;
+
+	void DrawPrepared(Bitmap& dst) override;
+
 	/**
 	 * Updates sprite state.
 	 */
@@ -91,6 +95,9 @@ private:
 	/** Returns true for charset sprites; false for tiles. */
 	bool UsesCharset() const;
 
+	/** Applies frame, position and effects of the character to the sprite */
+	void SyncCharacter();
+
 	int x_offset = 0;
 	int y_offset = 0;
 	bool refresh_bitmap = false;
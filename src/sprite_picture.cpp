@@ -62,13 +62,42 @@ void Sprite_Picture::OnPictureShow() {
 
 
 void Sprite_Picture::Draw(Bitmap& dst) {
+	// Also used by GetDrawState after a full redraw
+	prepared_visible = SyncPicture();
+	if (prepared_visible) {
+		Sprite::Draw(dst);
+	}
+}
+
+bool Sprite_Picture::PrepareDraw() {
+	prepared_visible = SyncPicture();
+
+	return prepared_visible ? PrepareBlitBands() : true;
+}
+
+void Sprite_Picture::DrawPrepared(Bitmap& dst) {
+	if (prepared_visible) {
+		BlitPrepared(dst);
+	}
+}
+
+uint64_t Sprite_Picture::GetDrawState(Rect& bounds) {
+	if (!prepared_visible) {
+		bounds = {};
+		return 0;
+	}
+
+	return Sprite::GetDrawState(bounds);
+}
+
+bool Sprite_Picture::SyncPicture() {
 	const auto& pic = Main_Data::game_pictures->GetPicture(pic_id);
 	const auto& data = pic.data;
 
 	auto& bitmap = GetBitmap();
 
 	if (!bitmap) {
-		return;
+		return false;
 	}
 
 	if (data.easyrpg_type == lcf::rpg::SavePicture::EasyRpgType_window) {
@@ -80,7 +109,7 @@ void Sprite_Picture::Draw(Bitmap& dst) {
 	const bool is_battle = Game_Battle::IsBattleRunning();
 
 	if (is_battle ? !pic.IsOnBattle() : !pic.IsOnMap()) {
-		return;
+		return false;
 	}
 
 	// RPG Maker 2k3 1.12: Spritesheets
@@ -166,10 +195,7 @@ void Sprite_Picture::Draw(Bitmap& dst) {
 	SetBlendType(data.easyrpg_blend_mode);
 
 	// Don't draw anything if zoom is at zero, helps avoid a glitchy rotated sprite in the top left corner
-	if (GetZoomX() <= 0.0 || GetZoomY() <= 0.0) {
-		return;
-	}
-	Sprite::Draw(dst);
+	return GetZoomX() > 0.0 && GetZoomY() > 0.0;
 }
 
 int Sprite_Picture::GetFrameWidth() const {
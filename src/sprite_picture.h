@@ -36,6 +36,12 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool PrepareDraw() override;
+
+	void DrawPrepared(Bitmap& dst) override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	void OnPictureShow();
 
 	/** @return Width of a single spritesheet frame or the entire width if the picture has no spritesheet */
@@ -45,7 +51,15 @@ public:
 	int GetFrameHeight() const;
 
 private:
+	/**
+	 * Applies the state of the picture to the sprite.
+	 *
+	 * @return true when the picture is drawn
+	 */
+	bool SyncPicture();
+
 	int last_spritesheet_frame = -1;
+	bool prepared_visible = false;
 	const int pic_id = 0;
 	const bool feature_spritesheet = false;
 	const bool feature_priority_layers = false;
@@ -19,6 +19,7 @@
 #include "sprite_timer.h"
 #include "cache.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "game_message.h"
 #include "game_party.h"
 #include "game_system.h"
@@ -61,14 +62,43 @@ Sprite_Timer::~Sprite_Timer() {
 }
 
 void Sprite_Timer::Draw(Bitmap& dst) {
+	// Also used by GetDrawState after a full redraw
+	prepared_visible = SyncTimer();
+	if (prepared_visible) {
+		Sprite::Draw(dst);
+	}
+}
+
+bool Sprite_Timer::PrepareDraw() {
+	prepared_visible = SyncTimer();
+
+	return false;
+}
+
+void Sprite_Timer::DrawPrepared(Bitmap& dst) {
+	if (prepared_visible) {
+		Sprite::Draw(dst);
+	}
+}
+
+uint64_t Sprite_Timer::GetDrawState(Rect& bounds) {
+	if (!prepared_visible) {
+		bounds = {};
+		return 0;
+	}
+
+	return Sprite::GetDrawState(bounds);
+}
+
+bool Sprite_Timer::SyncTimer() {
 	if (!Main_Data::game_party->GetTimerVisible(which, Game_Battle::IsBattleRunning())) {
-		return;
+		return false;
 	}
 
 	// RPG_RT never displays timers if there is no system graphic.
 	BitmapRef system = Cache::System();
 	if (!system) {
-		return;
+		return false;
 	}
 
 	const int all_secs = Main_Data::game_party->GetTimerSeconds(which);
@@ -97,17 +127,29 @@ void Sprite_Timer::Draw(Bitmap& dst) {
 		SetY(Player::menu_offset_y + 4);
 	}
 
+	int frames = Main_Data::game_party->GetTimerFrames(which);
+	const bool colon_visible = frames % DEFAULT_FPS >= DEFAULT_FPS / 2;
+
+	// Only redraw when the displayed time changes, this keeps the bitmap
+	// unmodified for partial screen updates
+	DrawStateHash state;
+	state.Add(system.get()).Add(system->GetRevision()).Add(colon_visible);
+	for (const auto& digit: digits) {
+		state.Add(digit);
+	}
+	if (state.Get() == drawn_state) {
+		return true;
+	}
+	drawn_state = state.Get();
+
 	GetBitmap()->Clear();
 	for (int i = 0; i < 5; ++i) {
-		if (i == 2) { // :
-			int frames =  Main_Data::game_party->GetTimerFrames(which);
-			if (frames % DEFAULT_FPS < DEFAULT_FPS / 2) {
-				continue;
-			}
+		if (i == 2 && !colon_visible) { // :
+			continue;
 		}
 		GetBitmap()->Blit(i * 8, 0, *system, digits[i], Opacity());
 	}
 
-	Sprite::Draw(dst);
+	return true;
 }
 
@@ -38,9 +38,28 @@ public:
 protected:
 	void Draw(Bitmap& dst) override;
 
+	bool PrepareDraw() override;
+
+	void DrawPrepared(Bitmap& dst) override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
+	/**
+	 * Positions the timer and draws the digits into the bitmap when they changed.
+	 *
+	 * @return true when the timer is displayed
+	 */
+	bool SyncTimer();
+
 	int which = 0;
 
 	Rect digits[5];
+
+	/** The timer is displayed in this frame, see SyncTimer */
+	bool prepared_visible = false;
+
+	/** Digits and system graphic that are drawn in the bitmap */
+	uint64_t drawn_state = 0;
 };
 
 #endif
@@ -54,6 +54,9 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	/** The weapon is synchronized while drawing, the screen is redrawn completely while it is visible */
+	bool TracksDamage() const override;
+
 protected:
 	void CreateSprite();
 	void OnBattleWeaponReady(FileRequestResult* result, int32_t weapon_index);
@@ -70,5 +73,9 @@ protected:
 	FileRequestBinding request_id;
 };
 
+inline bool Sprite_Weapon::TracksDamage() const {
+	return false;
+}
+
 
 #endif
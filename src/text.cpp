@@ -56,89 +56,211 @@ Point Text::Draw(Bitmap& dest, int x, int y, const Font& font, Color color, char
 	}
 }
 
-Point Text::Draw(Bitmap& dest, const int x, const int y, const Font& font, const Bitmap& system, const int color, StringView text, const Text::Alignment align) {
-	if (text.length() == 0) return { 0, 0 };
-
-	Rect dst_rect = Text::GetSize(font, text);
-
-	const int ih = dst_rect.height;
+namespace {
+	using LayoutGlyph = Font::TextLayout::Glyph;
+
+	/** Draws the string and records the position of every glyph in glyphs, returns the advance */
+	int DrawAndRecord(Bitmap& dest, const int ix, const int iy, const Font& font, const Bitmap& system, const int color, StringView text, std::vector<LayoutGlyph>& glyphs) {
+		// Where to draw the next glyph (x pos)
+		int next_glyph_pos = 0;
+
+		auto draw_char = [&](char32_t ch, bool is_exfont) {
+			LayoutGlyph glyph;
+			glyph.shape.code = ch;
+			glyph.x = next_glyph_pos;
+			glyph.is_exfont = is_exfont;
+			glyphs.push_back(glyph);
+
+			next_glyph_pos += Text::Draw(dest, ix + next_glyph_pos, iy, font, system, color, ch, is_exfont).x;
+		};
+
+		auto draw_shaped = [&](const Font::ShapeRet& shape) {
+			LayoutGlyph glyph;
+			glyph.shape = shape;
+			glyph.x = next_glyph_pos;
+			glyph.is_shaped = true;
+			glyphs.push_back(glyph);
+
+			next_glyph_pos += font.Render(dest, ix + next_glyph_pos, iy, system, color, shape).x;
+		};
+
+		// This loops always renders a single char, color blends it and then puts
+		// it onto the text_surface (including the drop shadow)
+		auto iter = text.data();
+		const auto end = iter + text.size();
+
+		if (font.CanShape()) {
+			// Collect all glyphs until ExFont or end of string and then shape and render
+			std::u32string text32;
+			while (iter != end) {
+				auto ret = Utils::TextNext(iter, end, 0);
+
+				iter = ret.next;
+				if (EP_UNLIKELY(!ret)) {
+					continue;
+				}
 
-	switch (align) {
-	case Text::AlignCenter:
-		dst_rect.x = x - dst_rect.width / 2; break;
-	case Text::AlignRight:
-		dst_rect.x = x - dst_rect.width; break;
-	case Text::AlignLeft:
-		dst_rect.x = x; break;
-	default: assert(false);
-	}
+				if (EP_UNLIKELY(Utils::IsControlCharacter(ret.ch))) {
+					draw_char(ret.ch, ret.is_exfont);
+					continue;
+				}
 
-	dst_rect.y = y;
-	dst_rect.width += 1; dst_rect.height += 1; // Need place for shadow
+				if (ret.is_exfont) {
+					if (!text32.empty()) {
+						auto shape_ret = font.Shape(text32);
+						text32.clear();
 
-	const int iy = dst_rect.y;
-	const int ix = dst_rect.x;
+						for (const auto& ch: shape_ret) {
+							draw_shaped(ch);
+						}
+					}
 
-	// Where to draw the next glyph (x pos)
-	int next_glyph_pos = 0;
+					draw_char(ret.ch, true);
+					continue;
+				}
 
-	// This loops always renders a single char, color blends it and then puts
-	// it onto the text_surface (including the drop shadow)
-	auto iter = text.data();
-	const auto end = iter + text.size();
+				text32 += ret.ch;
+			}
 
-	if (font.CanShape()) {
-		// Collect all glyphs until ExFont or end of string and then shape and render
-		std::u32string text32;
-		while (iter != end) {
-			auto ret = Utils::TextNext(iter, end, 0);
+			if (!text32.empty()) {
+				auto shape_ret = font.Shape(text32);
 
-			iter = ret.next;
-			if (EP_UNLIKELY(!ret)) {
-				continue;
+				for (const auto& ch: shape_ret) {
+					draw_shaped(ch);
+				}
 			}
+		} else {
+			while (iter != end) {
+				auto ret = Utils::TextNext(iter, end, 0);
 
-			if (EP_UNLIKELY(Utils::IsControlCharacter(ret.ch))) {
-				next_glyph_pos += Draw(dest, ix + next_glyph_pos, iy, font, system, color, ret.ch, ret.is_exfont).x;
-				continue;
+				iter = ret.next;
+				if (EP_UNLIKELY(!ret)) {
+					continue;
+				}
+				draw_char(ret.ch, ret.is_exfont);
 			}
+		}
+
+		return next_glyph_pos;
+	}
+
+	Rect Measure(const Font& font, StringView text) {
+		Rect rect;
+		Rect rect_tmp;
+
+		auto iter = text.data();
+		const auto end = iter + text.size();
+
+		if (font.CanShape()) {
+			std::u32string text32;
+			while (iter != end) {
+				auto ret = Utils::TextNext(iter, end, 0);
+
+				iter = ret.next;
+				if (EP_UNLIKELY(!ret)) {
+					continue;
+				}
+
+				if (EP_UNLIKELY(Utils::IsControlCharacter(ret.ch))) {
+					rect_tmp = Text::GetSize(font, ret.ch, ret.is_exfont);
+					rect.width += rect_tmp.width;
+					rect.height = std::max(rect.height, rect_tmp.height);
+					continue;
+				}
 
-			if (ret.is_exfont) {
-				if (!text32.empty()) {
-					auto shape_ret = font.Shape(text32);
-					text32.clear();
+				if (ret.is_exfont) {
+					if (!text32.empty()) {
+						auto shape_ret = font.Shape(text32);
+						text32.clear();
 
-					for (const auto& ch: shape_ret) {
-						next_glyph_pos += font.Render(dest, ix + next_glyph_pos, iy, system, color, ch).x;
+						for (const auto& ch: shape_ret) {
+							Rect size = font.GetSize(ch);
+							rect.width += ch.offset.x + size.width;
+							rect.height = std::max(rect.height, size.height);
+						}
 					}
+
+					rect_tmp = Text::GetSize(font, ret.ch, ret.is_exfont);
+					rect.width += rect_tmp.width;
+					rect.height = std::max(rect.height, rect_tmp.height);
+					continue;
 				}
 
-				next_glyph_pos += Draw(dest, ix + next_glyph_pos, iy, font, system, color, ret.ch, true).x;
-				continue;
+				text32 += ret.ch;
 			}
 
-			text32 += ret.ch;
-		}
+			if (!text32.empty()) {
+				auto shape_ret = font.Shape(text32);
 
-		if (!text32.empty()) {
-			auto shape_ret = font.Shape(text32);
+				for (const auto& ch: shape_ret) {
+					Rect size = font.GetSize(ch);
+					rect.width += ch.offset.x + size.width;
+					rect.height = std::max(rect.height, size.height);
+				}
+			}
+		} else {
+			while (iter != end) {
+				auto ret = Utils::TextNext(iter, end, 0);
+
+				iter = ret.next;
+				if (EP_UNLIKELY(!ret)) {
+					continue;
+				}
 
-			for (const auto& ch: shape_ret) {
-				next_glyph_pos += font.Render(dest, ix + next_glyph_pos, iy, system, color, ch).x;
+				rect_tmp = Text::GetSize(font, ret.ch, ret.is_exfont);
+				rect.width += rect_tmp.width;
+				rect.height = std::max(rect.height, rect_tmp.height);
 			}
 		}
-	} else {
-		while (iter != end) {
-			auto ret = Utils::TextNext(iter, end, 0);
 
-			iter = ret.next;
-			if (EP_UNLIKELY(!ret)) {
-				continue;
-			}
-			next_glyph_pos += Text::Draw(dest, ix + next_glyph_pos, iy, font, system, color, ret.ch, ret.is_exfont).x;
+		return rect;
+	}
+}
+
+Point Text::Draw(Bitmap& dest, const int x, const int y, const Font& font, const Bitmap& system, const int color, StringView text, const Text::Alignment align) {
+	if (text.length() == 0) return { 0, 0 };
+
+	// Measuring and decoding the string is skipped when it was drawn before
+	auto& layout = font.GetTextLayout(text);
+	if (!layout.has_size) {
+		layout.size = Measure(font, text);
+		layout.has_size = true;
+	}
+
+	Rect dst_rect = layout.size;
+
+	const int ih = dst_rect.height;
+
+	switch (align) {
+	case Text::AlignCenter:
+		dst_rect.x = x - dst_rect.width / 2; break;
+	case Text::AlignRight:
+		dst_rect.x = x - dst_rect.width; break;
+	case Text::AlignLeft:
+		dst_rect.x = x; break;
+	default: assert(false);
+	}
+
+	dst_rect.y = y;
+
+	const int iy = dst_rect.y;
+	const int ix = dst_rect.x;
+
+	if (!layout.has_glyphs) {
+		layout.width = DrawAndRecord(dest, ix, iy, font, system, color, text, layout.glyphs);
+		layout.has_glyphs = true;
+		return { layout.width, ih };
+	}
+
+	for (const auto& glyph: layout.glyphs) {
+		if (glyph.is_shaped) {
+			font.Render(dest, ix + glyph.x, iy, system, color, glyph.shape);
+		} else {
+			Draw(dest, ix + glyph.x, iy, font, system, color, glyph.shape.code, glyph.is_exfont);
 		}
 	}
-	return { next_glyph_pos, ih };
+
+	return { layout.width, ih };
 }
 
 Point Text::Draw(Bitmap& dest, const int x, const int y, const Font& font, const Color color, StringView text) {
@@ -183,75 +305,13 @@ Point Text::Draw(Bitmap& dest, const int x, const int y, const Font& font, const
 }
 
 Rect Text::GetSize(const Font& font, StringView text) {
-	Rect rect;
-	Rect rect_tmp;
-
-	auto iter = text.data();
-	const auto end = iter + text.size();
-
-	if (font.CanShape()) {
-		std::u32string text32;
-		while (iter != end) {
-			auto ret = Utils::TextNext(iter, end, 0);
-
-			iter = ret.next;
-			if (EP_UNLIKELY(!ret)) {
-				continue;
-			}
-
-			if (EP_UNLIKELY(Utils::IsControlCharacter(ret.ch))) {
-				rect_tmp = GetSize(font, ret.ch, ret.is_exfont);
-				rect.width += rect_tmp.width;
-				rect.height = std::max(rect.height, rect_tmp.height);
-				continue;
-			}
-
-			if (ret.is_exfont) {
-				if (!text32.empty()) {
-					auto shape_ret = font.Shape(text32);
-					text32.clear();
-
-					for (const auto& ch: shape_ret) {
-						Rect size = font.GetSize(ch);
-						rect.width += ch.offset.x + size.width;
-						rect.height = std::max(rect.height, size.height);
-					}
-				}
-
-				rect_tmp = GetSize(font, ret.ch, ret.is_exfont);
-				rect.width += rect_tmp.width;
-				rect.height = std::max(rect.height, rect_tmp.height);
-				continue;
-			}
-
-			text32 += ret.ch;
-		}
-
-		if (!text32.empty()) {
-			auto shape_ret = font.Shape(text32);
-
-			for (const auto& ch: shape_ret) {
-				Rect size = font.GetSize(ch);
-				rect.width += ch.offset.x + size.width;
-				rect.height = std::max(rect.height, size.height);
-			}
-		}
-	} else {
-		while (iter != end) {
-			auto ret = Utils::TextNext(iter, end, 0);
-
-			iter = ret.next;
-			if (EP_UNLIKELY(!ret)) {
-				continue;
-			}
-
-			rect_tmp = GetSize(font, ret.ch, ret.is_exfont);
-			rect.width += rect_tmp.width;
-			rect.height = std::max(rect.height, rect_tmp.height);
-		}
+	auto& layout = font.GetTextLayout(text);
+	if (!layout.has_size) {
+		layout.size = Measure(font, text);
+		layout.has_size = true;
 	}
 
-	return rect;
+	return layout.size;
 }
 
 Rect Text::GetSize(const Font& font, char32_t glyph, bool is_exfont) {
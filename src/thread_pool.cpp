@@ -0,0 +1,132 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "thread_pool.h"
+
+int ThreadPool::GetHardwareThreads() {
+#ifdef HAVE_THREADS
+	return std::max<int>(1, std::thread::hardware_concurrency());
+#else
+	return 1;
+#endif
+}
+
+#ifdef HAVE_THREADS
+
+ThreadPool::ThreadPool(int threads) {
+	num_threads = threads > 0 ? threads : GetHardwareThreads();
+
+	for (int i = 1; i < num_threads; ++i) {
+		workers.emplace_back(&ThreadPool::WorkerFunction, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	start_cv.notify_all();
+
+	for (auto& worker: workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& func) {
+	if (count <= 0) {
+		return;
+	}
+
+	if (workers.empty() || count == 1) {
+		for (int i = 0; i < count; ++i) {
+			func(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &func;
+		job_count = count;
+		next_index = 0;
+		finished = 0;
+		++generation;
+	}
+	start_cv.notify_all();
+
+	RunJobs();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cv.wait(lock, [this]() { return finished == job_count; });
+	job = nullptr;
+	job_count = 0;
+	next_index = 0;
+	finished = 0;
+}
+
+void ThreadPool::RunJobs() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (next_index < job_count) {
+		const int index = next_index++;
+		const auto& func = *job;
+
+		lock.unlock();
+		func(index);
+		lock.lock();
+
+		if (++finished == job_count) {
+			done_cv.notify_one();
+		}
+	}
+}
+
+void ThreadPool::WorkerFunction() {
+	unsigned seen_generation = 0;
+
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start_cv.wait(lock, [&]() { return quit || generation != seen_generation; });
+			if (quit) {
+				return;
+			}
+			seen_generation = generation;
+		}
+
+		RunJobs();
+	}
+}
+
+#else
+
+ThreadPool::ThreadPool(int) {
+}
+
+ThreadPool::~ThreadPool() {
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& func) {
+	for (int i = 0; i < count; ++i) {
+		func(i);
+	}
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EP_THREAD_POOL_H
+#define EP_THREAD_POOL_H
+
+// Headers
+#include <functional>
+#include <vector>
+#ifdef HAVE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+/**
+ * A fixed set of worker threads that run the iterations of a loop in parallel.
+ *
+ * When the Player is built without thread support all work runs on the
+ * calling thread.
+ */
+class ThreadPool {
+public:
+	/**
+	 * Starts the worker threads.
+	 *
+	 * @param num_threads number of threads including the calling thread,
+	 *                    0 uses the number of CPU cores
+	 */
+	explicit ThreadPool(int num_threads = 0);
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** Stops the worker threads */
+	~ThreadPool();
+
+	/** @return number of threads work is distributed to, including the calling thread */
+	int GetNumThreads() const;
+
+	/**
+	 * Calls func(i) for every i in [0, count) and waits until all calls finished.
+	 * The calling thread takes part in the work.
+	 * Must not be called from inside of func.
+	 *
+	 * @param count number of iterations
+	 * @param func function to call
+	 */
+	void ParallelFor(int count, const std::function<void(int)>& func);
+
+	/** @return number of threads available on this system */
+	static int GetHardwareThreads();
+
+private:
+	int num_threads = 1;
+
+#ifdef HAVE_THREADS
+	void WorkerFunction();
+	void RunJobs();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start_cv;
+	std::condition_variable done_cv;
+
+	const std::function<void(int)>* job = nullptr;
+	int job_count = 0;
+	int next_index = 0;
+	int finished = 0;
+	unsigned generation = 0;
+	bool quit = false;
+#endif
+};
+
+inline int ThreadPool::GetNumThreads() const {
+	return num_threads;
+}
+
+#endif
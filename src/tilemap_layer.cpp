@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include "tilemap_layer.h"
@@ -25,6 +26,7 @@
 #include "main_data.h"
 #include "bitmap.h"
 #include "compiler.h"
+#include "damage_tracker.h"
 #include "game_map.h"
 #include "game_system.h"
 #include "drawable_mgr.h"
@@ -205,6 +207,100 @@ static uint32_t MakeAbTileHash(int id, int anim_step) {
 	return static_cast<uint32_t>((id + (anim_step << 12)) | (4 << 24));
 }
 
+TilemapLayer::TileSource TilemapLayer::GetTileSource(const TileData& tile, int animation_step_c, int animation_step_ab) {
+	TileSource src;
+
+	if (layer == 0) {
+		// If lower layer
+		src.allow_fast_blit = (tile.z == TileBelow);
+
+		if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
+			int id = substitutions[tile.ID - BLOCK_E];
+			// If Block E
+
+			// Get the tile coordinates from chipset
+			if (id < 96) {
+				// If from first column of the block
+				src.col = 12 + id % 6;
+				src.row = id / 6;
+			} else {
+				// If from second column of the block
+				src.col = 18 + (id - 96) % 6;
+				src.row = (id - 96) / 6;
+			}
+
+			src.tone_hash = MakeETileHash(id);
+			src.tileset = chipset.get();
+			src.tone_tileset = chipset_effect.get();
+		} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
+			// If Block C
+
+			// Get the tile coordinates from chipset
+			src.col = 3 + (tile.ID - BLOCK_C) / 50;
+			src.row = 4 + animation_step_c;
+
+			src.tone_hash = MakeCTileHash(tile.ID, animation_step_c);
+			src.tileset = chipset.get();
+			src.tone_tileset = chipset_effect.get();
+		} else if (tile.ID < BLOCK_C) {
+			// If Blocks A1, A2, B
+
+			// Draw the tile from autotile cache
+			TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
+
+			src.col = pos.x;
+			src.row = pos.y;
+
+			src.tone_hash = MakeAbTileHash(tile.ID,  animation_step_ab);
+			src.tileset = autotiles_ab_screen.get();
+			src.tone_tileset = autotiles_ab_screen_effect.get();
+		} else {
+			// If blocks D1-D12
+
+			// Draw the tile from autotile cache
+			TileXY pos = GetCachedAutotileD(tile.ID);
+
+			src.col = pos.x;
+			src.row = pos.y;
+
+			src.tone_hash = MakeDTileHash(tile.ID);
+			src.tileset = autotiles_d_screen.get();
+			src.tone_tileset = autotiles_d_screen_effect.get();
+		}
+	} else {
+		// If upper layer
+
+		// Check that block F is being drawn
+		if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
+			int id = substitutions[tile.ID - BLOCK_F];
+
+			// Get the tile coordinates from chipset
+			if (id < 48) {
+				// If from first column of the block
+				src.col = 18 + id % 6;
+				src.row = 8 + id / 6;
+			} else {
+				// If from second column of the block
+				src.col = 24 + (id - 48) % 6;
+				src.row = (id - 48) / 6;
+			}
+
+			src.tone_hash = MakeFTileHash(id);
+			src.tileset = chipset.get();
+			src.tone_tileset = chipset_effect.get();
+		}
+	}
+
+	return src;
+}
+
+void TilemapLayer::DrawTileData(Bitmap& dst, const TileData& tile, int x, int y, int animation_step_c, int animation_step_ab) {
+	auto src = GetTileSource(tile, animation_step_c, animation_step_ab);
+	if (src.tileset) {
+		DrawTile(dst, *src.tileset, *src.tone_tileset, x, y, src.row, src.col, src.tone_hash, src.allow_fast_blit);
+	}
+}
+
 void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy) {
 	// Get the number of tiles that can be displayed on window
 	int tiles_x = (int)ceil(Player::screen_width / (float)TILE_SIZE);
@@ -231,18 +327,9 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 		return rem >= 0 ? rem : m + rem;
 	};
 
-	// FIXME: When Game_Map singleton is made an object we can remove this null check
-	const auto frames = Main_Data::game_system ? Main_Data::game_system->GetFrameCounter() : 0;
-	auto animation_step_c = (frames / 6) % 4;
-	auto animation_step_ab = frames / animation_speed;
-	if (animation_type) {
-		animation_step_ab %= 3;
-	} else {
-		animation_step_ab %= 4;
-		if (animation_step_ab == 3) {
-			animation_step_ab = 1;
-		}
-	}
+	int animation_step_c;
+	int animation_step_ab;
+	GetAnimationSteps(animation_step_c, animation_step_ab);
 
 	const int div_ox = div_rounding_down(ox - render_ox, TILE_SIZE);
 	const int div_oy = div_rounding_down(oy - render_oy, TILE_SIZE);
@@ -250,113 +337,235 @@ void TilemapLayer::Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_
 	const int mod_ox = mod(ox - render_ox, TILE_SIZE);
 	const int mod_oy = mod(oy - render_oy, TILE_SIZE);
 
-	for (int y = 0; y < tiles_y; y++) {
-		for (int x = 0; x < tiles_x; x++) {
+	if (chunk_warmup > 0) {
+		// The chunks were invalidated recently (e.g. by a tone fade),
+		// rendering them would be slower than drawing the tiles directly
+		--chunk_warmup;
+
+		for (int y = 0; y < tiles_y; y++) {
+			for (int x = 0; x < tiles_x; x++) {
 
-			// Get the real maps tile coordinates
+				// Get the real maps tile coordinates
+				int map_x = div_ox + x;
+				int map_y = div_oy + y;
+				if (loop_h) map_x = mod(map_x, width);
+				if (loop_v) map_y = mod(map_y, height);
+
+				bool out_of_bounds =
+					map_x < 0 || map_x >= width ||
+					map_y < 0 || map_y >= height;
+
+				if (out_of_bounds) {
+					continue;
+				}
+
+				// Get the tile data
+				TileData &tile = GetDataCache(map_x, map_y);
+
+				// Draw the sublayer if its z is being draw now
+				if (z_order == tile.z) {
+					int map_draw_x = x * TILE_SIZE - mod_ox;
+					int map_draw_y = y * TILE_SIZE - mod_oy;
+
+					DrawTileData(dst, tile, map_draw_x, map_draw_y, animation_step_c, animation_step_ab);
+				}
+			}
+		}
+		return;
+	}
+
+	const int chunks_w = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	const int chunks_h = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	if (chunks.size() != static_cast<size_t>(chunks_w * chunks_h * 2)) {
+		chunks.clear();
+		chunks.resize(chunks_w * chunks_h * 2);
+		chunk_bitmaps = 0;
+	}
+
+	// Enough chunks for both sublayers and some scrolling before evicting
+	constexpr int chunk_px = CHUNK_SIZE * TILE_SIZE;
+	max_chunk_bitmaps = 4 * (Player::screen_width / chunk_px + 2) * (Player::screen_height / chunk_px + 2);
+
+	const int z_index = z_order >= TileAbove ? 1 : 0;
+
+	// Draw the visible parts of every chunk with a single blit, the tiles that
+	// are animated or not stored in the chunk are drawn on top
+	for (int y = 0; y < tiles_y;) {
+		int map_y = div_oy + y;
+		if (loop_v) map_y = mod(map_y, height);
+
+		if (map_y < 0 || map_y >= height) {
+			++y;
+			continue;
+		}
+
+		const int chunk_ty = map_y % CHUNK_SIZE;
+		const int run_h = std::min({ tiles_y - y, CHUNK_SIZE - chunk_ty, height - map_y });
+
+		for (int x = 0; x < tiles_x;) {
 			int map_x = div_ox + x;
-			int map_y = div_oy + y;
 			if (loop_h) map_x = mod(map_x, width);
-			if (loop_v) map_y = mod(map_y, height);
 
-			bool out_of_bounds =
-				map_x < 0 || map_x >= width ||
-				map_y < 0 || map_y >= height;
-
-			if (out_of_bounds) {
+			if (map_x < 0 || map_x >= width) {
+				++x;
 				continue;
 			}
 
-			int map_draw_x = x * TILE_SIZE - mod_ox;
-			int map_draw_y = y * TILE_SIZE - mod_oy;
-
-			// Get the tile data
-			TileData &tile = GetDataCache(map_x, map_y);
-
-			// Draw the sublayer if its z is being draw now
-			if (z_order == tile.z) {
-				if (layer == 0) {
-					// If lower layer
-					bool allow_fast_blit = (tile.z == TileBelow);
-
-					if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
-						int id = substitutions[tile.ID - BLOCK_E];
-						// If Block E
-
-						int row, col;
-
-						// Get the tile coordinates from chipset
-						if (id < 96) {
-							// If from first column of the block
-							col = 12 + id % 6;
-							row = id / 6;
-						} else {
-							// If from second column of the block
-							col = 18 + (id - 96) % 6;
-							row = (id - 96) / 6;
-						}
-
-						auto tone_hash = MakeETileHash(id);
-						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-					} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
-						// If Block C
-
-						// Get the tile coordinates from chipset
-						int col = 3 + (tile.ID - BLOCK_C) / 50;
-						int row = 4 + animation_step_c;
-
-						auto tone_hash = MakeCTileHash(tile.ID, animation_step_c);
-						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-					} else if (tile.ID < BLOCK_C) {
-						// If Blocks A1, A2, B
-
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
-
-						int col = pos.x;
-						int row = pos.y;
-
-						// Create tone changed tile
-						auto tone_hash = MakeAbTileHash(tile.ID,  animation_step_ab);
-						DrawTile(dst, *autotiles_ab_screen, *autotiles_ab_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-					} else {
-						// If blocks D1-D12
-
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileD(tile.ID);
-
-						int col = pos.x;
-						int row = pos.y;
-
-						auto tone_hash = MakeDTileHash(tile.ID);
-						DrawTile(dst, *autotiles_d_screen, *autotiles_d_screen_effect, map_draw_x, map_draw_y, row, col, tone_hash, allow_fast_blit);
-					}
+			const int chunk_tx = map_x % CHUNK_SIZE;
+			const int run_w = std::min({ tiles_x - x, CHUNK_SIZE - chunk_tx, width - map_x });
+
+			const int chunk_x = map_x / CHUNK_SIZE;
+			const int chunk_y = map_y / CHUNK_SIZE;
+			auto& chunk = chunks[(z_index * chunks_h + chunk_y) * chunks_w + chunk_x];
+			if (!chunk.valid) {
+				RenderChunk(chunk, chunk_x, chunk_y, z_order);
+			}
+			chunk.last_used = ++chunk_use_counter;
+
+			const int draw_x = x * TILE_SIZE - mod_ox;
+			const int draw_y = y * TILE_SIZE - mod_oy;
+
+			if (chunk.bitmap) {
+				Rect rect(chunk_tx * TILE_SIZE, chunk_ty * TILE_SIZE, run_w * TILE_SIZE, run_h * TILE_SIZE);
+				if (chunk.opaque) {
+					dst.BlitFast(draw_x, draw_y, *chunk.bitmap, rect, 255);
 				} else {
-					// If upper layer
-
-					// Check that block F is being drawn
-					if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
-						int id = substitutions[tile.ID - BLOCK_F];
-						int row, col;
-
-						// Get the tile coordinates from chipset
-						if (id < 48) {
-							// If from first column of the block
-							col = 18 + id % 6;
-							row = 8 + id / 6;
-						} else {
-							// If from second column of the block
-							col = 24 + (id - 48) % 6;
-							row = (id - 48) / 6;
-						}
-
-						auto tone_hash = MakeFTileHash(id);
-						DrawTile(dst, *chipset, *chipset_effect, map_draw_x, map_draw_y, row, col, tone_hash);
-					}
+					dst.Blit(draw_x, draw_y, *chunk.bitmap, rect, Opacity::Opaque());
+				}
+			}
+
+			for (auto index: chunk.dynamic_tiles) {
+				const int tx = index & 0xFF;
+				const int ty = index >> 8;
+				if (tx < chunk_tx || tx >= chunk_tx + run_w || ty < chunk_ty || ty >= chunk_ty + run_h) {
+					continue;
+				}
+
+				const TileData& tile = GetDataCache(chunk_x * CHUNK_SIZE + tx, chunk_y * CHUNK_SIZE + ty);
+				DrawTileData(dst, tile, draw_x + (tx - chunk_tx) * TILE_SIZE, draw_y + (ty - chunk_ty) * TILE_SIZE,
+					animation_step_c, animation_step_ab);
+			}
+
+			x += run_w;
+		}
+
+		y += run_h;
+	}
+}
+
+uint64_t TilemapLayer::GetDrawState(int render_ox, int render_oy) const {
+	DrawStateHash state;
+	state.Add(revision).Add(chipset.get()).Add(chipset ? chipset->GetRevision() : 0)
+		.Add(ox).Add(oy).Add(render_ox).Add(render_oy).Add(width).Add(height)
+		.Add(Game_Map::LoopHorizontal()).Add(Game_Map::LoopVertical())
+		.Add(Player::screen_width).Add(Player::screen_height).Add(tone).Add(fast_blit);
+
+	if (animated) {
+		int animation_step_c;
+		int animation_step_ab;
+		GetAnimationSteps(animation_step_c, animation_step_ab);
+		state.Add(animation_step_c).Add(animation_step_ab);
+	}
+
+	return state.Get();
+}
+
+void TilemapLayer::GetAnimationSteps(int& step_c, int& step_ab) const {
+	// FIXME: When Game_Map singleton is made an object we can remove this null check
+	const auto frames = Main_Data::game_system ? Main_Data::game_system->GetFrameCounter() : 0;
+	step_c = (frames / 6) % 4;
+	step_ab = frames / animation_speed;
+	if (animation_type) {
+		step_ab %= 3;
+	} else {
+		step_ab %= 4;
+		if (step_ab == 3) {
+			step_ab = 1;
+		}
+	}
+}
+
+void TilemapLayer::RenderChunk(TileChunk& chunk, int chunk_x, int chunk_y, uint8_t z_order) {
+	const int base_x = chunk_x * CHUNK_SIZE;
+	const int base_y = chunk_y * CHUNK_SIZE;
+	const int chunk_w = std::min(CHUNK_SIZE, width - base_x);
+	const int chunk_h = std::min(CHUNK_SIZE, height - base_y);
+
+	chunk.valid = true;
+	chunk.opaque = false;
+	chunk.dynamic_tiles.clear();
+
+	int opaque_tiles = 0;
+
+	for (int ty = 0; ty < chunk_h; ++ty) {
+		for (int tx = 0; tx < chunk_w; ++tx) {
+			const TileData& tile = GetDataCache(base_x + tx, base_y + ty);
+			if (tile.z != z_order) {
+				continue;
+			}
+
+			const uint16_t index = static_cast<uint16_t>(tx | (ty << 8));
+
+			// Blocks A, B and C are animated
+			if (layer == 0 && tile.ID < BLOCK_D) {
+				chunk.dynamic_tiles.push_back(index);
+				continue;
+			}
+
+			auto src = GetTileSource(tile, 0, 0);
+			if (!src.tileset) {
+				continue;
+			}
+
+			auto op = src.tileset->GetTileOpacity(src.col, src.row);
+			if (op == ImageOpacity::Transparent) {
+				continue;
+			}
+
+			// Fast blit replaces the pixels below, this cannot be stored in the chunk
+			if (op != ImageOpacity::Opaque && fast_blit && src.allow_fast_blit) {
+				chunk.dynamic_tiles.push_back(index);
+				continue;
+			}
+
+			if (!chunk.bitmap) {
+				if (chunk_bitmaps >= max_chunk_bitmaps) {
+					EvictChunk();
 				}
+				chunk.bitmap = Bitmap::Create(chunk_w * TILE_SIZE, chunk_h * TILE_SIZE, true);
+				++chunk_bitmaps;
+			}
+
+			DrawTile(*chunk.bitmap, *src.tileset, *src.tone_tileset, tx * TILE_SIZE, ty * TILE_SIZE, src.row, src.col, src.tone_hash, src.allow_fast_blit);
+
+			if (op == ImageOpacity::Opaque) {
+				++opaque_tiles;
 			}
 		}
 	}
+
+	chunk.opaque = opaque_tiles == chunk_w * chunk_h;
+}
+
+void TilemapLayer::EvictChunk() {
+	TileChunk* oldest = nullptr;
+	for (auto& chunk: chunks) {
+		if (chunk.bitmap && (!oldest || chunk.last_used < oldest->last_used)) {
+			oldest = &chunk;
+		}
+	}
+
+	if (oldest) {
+		*oldest = {};
+		--chunk_bitmaps;
+	}
+}
+
+void TilemapLayer::InvalidateChunks() {
+	++revision;
+	chunks.clear();
+	chunk_bitmaps = 0;
+	chunk_warmup = chunk_warmup_draws;
 }
 
 TilemapLayer::TileXY TilemapLayer::GetCachedAutotileAB(short ID, short animID) {
@@ -373,7 +582,10 @@ TilemapLayer::TileXY TilemapLayer::GetCachedAutotileD(short ID) {
 }
 
 void TilemapLayer::CreateTileCache(const std::vector<short>& nmap_data) {
+	InvalidateChunks();
+
 	data_cache_vec.resize(width * height);
+	animated = false;
 	for (int x = 0; x < width; x++) {
 		for (int y = 0; y < height; y++) {
 			TileData tile;
@@ -381,6 +593,11 @@ void TilemapLayer::CreateTileCache(const std::vector<short>& nmap_data) {
 			// Get the tile ID
 			tile.ID = nmap_data[x + y * width];
 
+			// Blocks A, B and C are animated, they only exist on the lower layer
+			if (layer == 0 && tile.ID < BLOCK_D) {
+				animated = true;
+			}
+
 			tile.z = TileBelow;
 
 			// Calculate the tile Z
@@ -612,6 +829,7 @@ void TilemapLayer::SetChipset(BitmapRef const& nchipset) {
 	chipset = nchipset;
 	chipset_effect = Bitmap::Create(chipset->width(), chipset->height());
 	chipset_tone_tiles.clear();
+	InvalidateChunks();
 
 	if (autotiles_ab_next != 0 && autotiles_d_screen != nullptr && layer == 0) {
 		autotiles_ab_screen = GenerateAutotiles(autotiles_ab_next, autotiles_ab_map);
@@ -691,6 +909,16 @@ void TilemapSubLayer::Draw(Bitmap& dst) {
 	tilemap->Draw(dst, internal_z, GetRenderOx(), GetRenderOy());
 }
 
+uint64_t TilemapSubLayer::GetDrawState(Rect& bounds) {
+	if (!tilemap->GetChipset()) {
+		bounds = {};
+		return 0;
+	}
+
+	bounds = Rect(0, 0, Player::screen_width, Player::screen_height);
+	return tilemap->GetDrawState(GetRenderOx(), GetRenderOy());
+}
+
 void TilemapLayer::SetTone(Tone tone) {
 	if (tone == this->tone) {
 		return;
@@ -708,4 +936,14 @@ void TilemapLayer::SetTone(Tone tone) {
 		chipset_effect->Clear();
 	}
 	chipset_tone_tiles.clear();
+	InvalidateChunks();
+}
+
+void TilemapLayer::SetFastBlit(bool fast) {
+	if (fast == fast_blit) {
+		return;
+	}
+
+	fast_blit = fast;
+	InvalidateChunks();
 }
@@ -41,6 +41,10 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 private:
 	TilemapLayer* tilemap = nullptr;
 
@@ -62,6 +66,15 @@ public:
 
 	void Draw(Bitmap& dst, uint8_t z_order, int render_ox, int render_oy);
 
+	/**
+	 * Used for partial screen updates, see Drawable::GetDrawState.
+	 *
+	 * @param render_ox render offset x of the sublayer
+	 * @param render_oy render offset y of the sublayer
+	 * @return fingerprint of everything that affects the drawn tiles
+	 */
+	uint64_t GetDrawState(int render_ox, int render_oy) const;
+
 	BitmapRef const& GetChipset() const;
 	void SetChipset(BitmapRef const& nchipset);
 	const std::vector<short>& GetMapData() const;
@@ -113,6 +126,10 @@ private:
 	int animation_type = 0;
 	int layer = 0;
 	bool fast_blit = false;
+	/** The layer contains animated tiles */
+	bool animated = false;
+	/** Incremented whenever the tiles change, see InvalidateChunks */
+	uint32_t revision = 0;
 
 	void CreateTileCache(const std::vector<short>& nmap_data);
 	void GenerateAutotileAB(short ID, short animID);
@@ -132,6 +149,16 @@ private:
 
 	BitmapRef GenerateAutotiles(int count, const std::unordered_map<uint32_t, TileXY>& map);
 
+	/** Where the graphic of a tile is located */
+	struct TileSource {
+		Bitmap* tileset = nullptr;
+		Bitmap* tone_tileset = nullptr;
+		int row = 0;
+		int col = 0;
+		uint32_t tone_hash = 0;
+		bool allow_fast_blit = true;
+	};
+
 	TileXY GetCachedAutotileAB(short ID, short animID);
 	TileXY GetCachedAutotileD(short ID);
 	BitmapRef autotiles_ab_screen;
@@ -155,8 +182,53 @@ private:
 
 	TileData& GetDataCache(int x, int y);
 
+	/**
+	 * Calculates the animation frame of the animated tiles in this frame.
+	 *
+	 * @param step_c animation step of block C
+	 * @param step_ab animation step of the autotiles of block A and B
+	 */
+	void GetAnimationSteps(int& step_c, int& step_ab) const;
+
 	std::vector<TileData> data_cache_vec;
 
+	TileSource GetTileSource(const TileData& tile, int animation_step_c, int animation_step_ab);
+	void DrawTileData(Bitmap& dst, const TileData& tile, int x, int y, int animation_step_c, int animation_step_ab);
+
+	/** Size of a pre-rendered chunk in tiles */
+	static constexpr int CHUNK_SIZE = 16;
+	/** Amount of draws after an invalidation before the chunks are rendered again */
+	static constexpr int chunk_warmup_draws = 4;
+
+	/**
+	 * Pre-rendered static tiles of a CHUNK_SIZE x CHUNK_SIZE area of one sublayer.
+	 * Animated tiles are drawn every frame from dynamic_tiles.
+	 */
+	struct TileChunk {
+		/** Static tiles, null when the chunk has none */
+		BitmapRef bitmap;
+		/** Tiles drawn every frame, packed as x | y << 8 relative to the chunk */
+		std::vector<uint16_t> dynamic_tiles;
+		/** Counter of the last use, for eviction */
+		uint32_t last_used = 0;
+		bool valid = false;
+		/** All tiles of the chunk are opaque and static */
+		bool opaque = false;
+	};
+
+	void RenderChunk(TileChunk& chunk, int chunk_x, int chunk_y, uint8_t z_order);
+	/** Frees the bitmap of the least recently used chunk */
+	void EvictChunk();
+	/** Drops all chunks, called when the tiles, chipset or tone change */
+	void InvalidateChunks();
+
+	/** Chunks of the lower and the upper sublayer */
+	std::vector<TileChunk> chunks;
+	uint32_t chunk_use_counter = 0;
+	int chunk_bitmaps = 0;
+	int max_chunk_bitmaps = 0;
+	int chunk_warmup = chunk_warmup_draws;
+
 	TilemapSubLayer lower_layer;
 	TilemapSubLayer upper_layer;
 
@@ -251,8 +323,8 @@ inline void TilemapLayer::SetAnimationType(int type) {
 	animation_type = type;
 }
 
-inline void TilemapLayer::SetFastBlit(bool fast) {
-	fast_blit = fast;
+inline bool TilemapSubLayer::TracksDamage() const {
+	return true;
 }
 
 inline TilemapLayer::TileData& TilemapLayer::GetDataCache(int x, int y) {
@@ -122,7 +122,7 @@ void Transition::Init(Type type, Scene *linked_scene, int duration, bool next_er
 void Transition::SetAttributesTransitions() {
 	int w, h, beg_i, mid_i, end_i, length;
 
-	zoom_position = std::vector<int>(2);
+	zoom_position = {};
 	random_blocks = std::vector<uint32_t>(Player::screen_width * Player::screen_height / (size_random_blocks * size_random_blocks));
 	for (uint32_t i = 0; i < random_blocks.size(); i++) {
 		random_blocks[i] = i;
@@ -155,6 +155,21 @@ void Transition::SetAttributesTransitions() {
 			else { std::partial_sort(random_blocks.begin() + beg_i, random_blocks.begin() + mid_i, random_blocks.begin() + end_i, std::greater<uint32_t>()); }
 		}
 		break;
+	case TransitionBlindOpen:
+	case TransitionBlindClose:
+	case TransitionVerticalStripesIn:
+	case TransitionVerticalStripesOut:
+		stripe_lines.resize(Player::screen_height);
+		break;
+	case TransitionHorizontalStripesIn:
+	case TransitionHorizontalStripesOut:
+		stripe_lines.resize(Player::screen_width);
+		break;
+	case TransitionMosaicIn:
+	case TransitionMosaicOut:
+		mosaic_x.resize(Player::screen_width);
+		mosaic_y.resize(Player::screen_height);
+		break;
 	case TransitionZoomIn:
 	case TransitionZoomOut:
 		if (scene != nullptr && scene->type == Scene::Map) {
@@ -174,14 +189,22 @@ void Transition::SetAttributesTransitions() {
 	}
 }
 
+void Transition::SetStripes(int from, int count, uint8_t screen) {
+	// Same clipping as a Blit of the stripe
+	const int end = std::min(from + count, static_cast<int>(stripe_lines.size()));
+	from = std::max(from, 0);
+	if (from < end) {
+		std::fill(stripe_lines.begin() + from, stripe_lines.begin() + end, screen);
+	}
+}
+
 void Transition::Draw(Bitmap& dst) {
 	if (!IsActive())
 		return;
 
-	std::vector<int> z_pos(2), z_size(2), z_length(2);
+	std::array<int, 2> z_pos, z_size, z_length;
 	int z_min, z_max, z_percent, z_fixed_pos, z_fixed_size;
-	uint8_t m_r, m_g, m_b, m_a;
-	uint32_t *m_pointer, blocks_to_print;
+	uint32_t blocks_to_print;
 	int m_size;
 
 	BitmapRef screen_pointer1, screen_pointer2;
@@ -199,8 +222,7 @@ void Transition::Draw(Bitmap& dst) {
 	switch (transition_type) {
 	case TransitionFadeIn:
 	case TransitionFadeOut:
-		dst.Blit(0, 0, *screen1, screen1->GetRect(), 255);
-		dst.Blit(0, 0, *screen2, screen2->GetRect(), 255 * percentage / 100);
+		dst.CrossFadeBlit(*screen1, *screen2, 255 * percentage / 100);
 		break;
 	case TransitionRandomBlocks:
 	case TransitionRandomBlocksDown:
@@ -218,38 +240,48 @@ void Transition::Draw(Bitmap& dst) {
 		current_blocks_print = blocks_to_print;
 		break;
 	case TransitionBlindOpen:
+		// Stripes are collected per row (1: screen1, 2: screen2) and drawn at once
+		stripe_lines.assign(h, 0);
 		for (int i = 0; i < h / 8; i++) {
-			dst.Blit(0, i * 8, *screen1, Rect(0, i * 8, w, 8 - 8 * percentage / 100), 255);
-			dst.Blit(0, i * 8 + 8 - 8 * percentage / 100, *screen2, Rect(0, i * 8 + 8 - 8 * percentage / 100, w, 8 * percentage / 100), 255);
+			SetStripes(i * 8, 8 - 8 * percentage / 100, 1);
+			SetStripes(i * 8 + 8 - 8 * percentage / 100, 8 * percentage / 100, 2);
 		}
+		dst.StripeBlit(*screen1, *screen2, stripe_lines.data(), false);
 		break;
 	case TransitionBlindClose:
+		stripe_lines.assign(h, 0);
 		for (int i = 0; i < h / 8; i++) {
-			dst.Blit(0, i * 8 + 8 * percentage / 100, *screen1, Rect(0, i * 8 + 8 * percentage / 100, w, 8 - 8 * percentage / 100), 255);
-			dst.Blit(0, i * 8, *screen2, Rect(0, i * 8, w, 8 * percentage / 100), 255);
+			SetStripes(i * 8 + 8 * percentage / 100, 8 - 8 * percentage / 100, 1);
+			SetStripes(i * 8, 8 * percentage / 100, 2);
 		}
+		dst.StripeBlit(*screen1, *screen2, stripe_lines.data(), false);
 		break;
 	case TransitionVerticalStripesIn:
 	case TransitionVerticalStripesOut:
+		stripe_lines.assign(h, 0);
 		for (int i = 0; i < h / 6 + 1 - h / 6 * percentage / 100; i++) {
-			dst.Blit(0, i * 6 + 3, *screen1, Rect(0, i * 6 + 3, w, 3), 255);
-			dst.Blit(0, h - i * 6, *screen1, Rect(0, h - i * 6, w, 3), 255);
+			SetStripes(i * 6 + 3, 3, 1);
+			SetStripes(h - i * 6, 3, 1);
 		}
 		for (int i = 0; i < h / 6 * percentage / 100; i++) {
-			dst.Blit(0, i * 6, *screen2, Rect(0, i * 6, w, 3), 255);
-			dst.Blit(0, h - 3 - i * 6, *screen2, Rect(0, h - 3 - i * 6, w, 3), 255);
+			SetStripes(i * 6, 3, 2);
+			SetStripes(h - 3 - i * 6, 3, 2);
 		}
+		dst.StripeBlit(*screen1, *screen2, stripe_lines.data(), false);
 		break;
 	case TransitionHorizontalStripesIn:
 	case TransitionHorizontalStripesOut:
+		// Stripes are collected per column
+		stripe_lines.assign(w, 0);
 		for (int i = 0; i < w / 8 + 1 - w / 8 * percentage / 100; i++) {
-			dst.Blit(i * 8 + 4, 0, *screen1, Rect(i * 8 + 4, 0, 4, h), 255);
-			dst.Blit(w - i * 8, 0, *screen1, Rect(w - i * 8, 0, 4, h), 255);
+			SetStripes(i * 8 + 4, 4, 1);
+			SetStripes(w - i * 8, 4, 1);
 		}
 		for (int i = 0; i < w / 8 * percentage / 100; i++) {
-			dst.Blit(i * 8, 0, *screen2, Rect(i * 8, 0, 4, h), 255);
-			dst.Blit(w - 4 - i * 8, 0, *screen2, Rect(w - 4 - i * 8, 0, 4, h), 255);
+			SetStripes(i * 8, 4, 2);
+			SetStripes(w - 4 - i * 8, 4, 2);
 		}
+		dst.StripeBlit(*screen1, *screen2, stripe_lines.data(), true);
 		break;
 	case TransitionBorderToCenterIn:
 	case TransitionBorderToCenterOut:
@@ -356,16 +388,23 @@ void Transition::Draw(Bitmap& dst) {
 		screen_pointer1 = transition_type == TransitionMosaicIn ? screen2 : screen1;
 
 		m_size = (percentage + 1) * 4 / 10;
-		if (m_size > 1)
-			for (int i = 0; i < w; i += m_size)
-				for (int j = 0; j < h; j += m_size) {
-					m_pointer = static_cast<uint32_t *>(screen_pointer1->pixels()) + j * w + i;
-					m_pointer += ((i == 0 ? 1 : 0) + (j == 0 ? w : 0)) * (m_size - 1);
-					dst.pixel_format.uint32_to_rgba(*m_pointer, m_r, m_g, m_b, m_a);
-					dst.FillRect(Rect(i - ((m_size - w % m_size) % m_size) / 2, j - ((m_size - h % m_size) % m_size) / 2, m_size, m_size), Color(m_r, m_g, m_b, m_a));
+		if (m_size > 1) {
+			// The blocks are centered, every block shows its top left pixel.
+			// The blocks in the first row and column show their bottom right pixel instead.
+			auto map_block = [m_size](std::vector<int>& positions, int length) {
+				const int offset = ((m_size - length % m_size) % m_size) / 2;
+				positions.resize(length);
+				for (int i = 0; i < length; ++i) {
+					const int block = (i + offset) / m_size * m_size;
+					positions[i] = block == 0 ? m_size - 1 : block;
 				}
-		else
+			};
+			map_block(mosaic_x, w);
+			map_block(mosaic_y, h);
+			dst.RemapBlit(*screen_pointer1, mosaic_x.data(), mosaic_y.data());
+		} else {
 			dst.Blit(0, 0, *screen_pointer1, screen_pointer1->GetRect(), 255);
+		}
 		break;
 	case TransitionWaveIn:
 	case TransitionWaveOut:
@@ -19,6 +19,7 @@
 #define EP_TRANSITION_H
 
 // Headers
+#include <array>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -110,6 +111,9 @@ public:
 	void Draw(Bitmap& dst) override;
 	void Update();
 
+	/** Transitions redraw the screen completely, only the inactive transition is tracked */
+	bool TracksDamage() const override;
+
 	bool IsActive() const;
 	bool IsErasedNotActive() const;
 
@@ -146,11 +150,18 @@ private:
 	int flash_duration = 0;
 	int flash_iterations = 0;
 
-	std::vector<int> zoom_position;
+	std::array<int, 2> zoom_position = {};
 	std::vector<uint32_t> random_blocks;
 	uint32_t current_blocks_print;
 
+	/** Source screen of every row or column for blind and stripe transitions */
+	std::vector<uint8_t> stripe_lines;
+	/** Source pixel of every column and row for mosaic transitions */
+	std::vector<int> mosaic_x;
+	std::vector<int> mosaic_y;
+
 	void SetAttributesTransitions();
+	void SetStripes(int from, int count, uint8_t screen);
 };
 
 inline Transition& Transition::instance() {
@@ -166,6 +177,10 @@ inline void Transition::InitErase(Type type, Scene *linked_scene, int duration)
 	Init(type, linked_scene, duration, true);
 }
 
+inline bool Transition::TracksDamage() const {
+	return !IsActive();
+}
+
 inline bool Transition::IsActive() const {
 	return current_frame < total_frames || flash_iterations != 0;
 }
@@ -33,14 +33,15 @@ Weather::Weather() :
 	Drawable(Priority_Weather, Drawable::Flags::Shared)
 {
 	DrawableMgr::Register(this);
-
-	auto rect = Main_Data::game_screen->GetScreenEffectsRect();
-	weather_surface = Bitmap::Create(rect.width, rect.height, true);
 }
 
 void Weather::Update() {
 }
 
+bool Weather::TracksDamage() const {
+	return Main_Data::game_screen->GetWeatherType() == Game_Screen::Weather_None;
+}
+
 void Weather::Draw(Bitmap& dst) {
 	SetTone(Main_Data::game_screen->GetTone());
 
@@ -150,6 +151,22 @@ const Bitmap* Weather::ApplyToneEffect(const Bitmap& bitmap, Rect rect) {
 	return tone_bitmap.get();
 }
 
+void Weather::ClearParticleBatch() {
+	particle_x.clear();
+	particle_y.clear();
+	particle_opacity.clear();
+}
+
+void Weather::AddToParticleBatch(int x, int y, int opacity) {
+	if (opacity <= 0) {
+		return;
+	}
+
+	particle_x.push_back(static_cast<int16_t>(x));
+	particle_y.push_back(static_cast<int16_t>(y));
+	particle_opacity.push_back(static_cast<uint8_t>(std::min(opacity, 255)));
+}
+
 void Weather::CreateRainParticle() {
 	constexpr int w = rain_bitmap_rect.width;
 	constexpr int h = rain_bitmap_rect.height;
@@ -204,26 +221,25 @@ void Weather::DrawParticles(Bitmap& dst, const Bitmap& particle, const Rect rect
 	const int num_particles = num_rain_or_snow_particles[Utils::Clamp(strength, 0, num_strength - 1)];
 	const auto ainc = abase + strength;
 
-	auto surface_rect = weather_surface->GetRect();
-	weather_surface->Clear();
-
 	assert(num_particles <= static_cast<int>(particles.size()));
 
+	ClearParticleBatch();
 	for (int i = 0; i < num_particles; ++i) {
 		auto& p = particles[i];
 		if (p.t > tmax) {
 			continue;
 		}
 
-		auto alpha = std::min(ainc * p.t, 255);
-
-		weather_surface->EdgeMirrorBlit(p.x, p.y, *bitmap, rect, true, true, alpha);
+		AddToParticleBatch(p.x, p.y, ainc * p.t);
 	}
 
+	// The particles wrap around a surface of the size of the pannable area,
+	// which is tiled over the screen
 	const auto shake_x = Main_Data::game_screen->GetShakeOffsetX();
 	const auto shake_y = Main_Data::game_screen->GetShakeOffsetY();
 	auto pan_rect = Main_Data::game_screen->GetScreenEffectsRect();
-	dst.TiledBlit(-pan_rect.x + shake_x, -pan_rect.y + shake_y, surface_rect, *weather_surface, dst.GetRect(), Opacity::Opaque());
+	dst.ParticleBlit(-pan_rect.x + shake_x, -pan_rect.y + shake_y, Rect(0, 0, pan_rect.width, pan_rect.height),
+		*bitmap, rect, particle_x.data(), particle_y.data(), particle_opacity.data(), static_cast<int>(particle_x.size()));
 }
 
 void Weather::DrawFog(Bitmap& dst) {
@@ -276,9 +292,13 @@ void Weather::DrawSandParticles(Bitmap& dst, const Bitmap& particle_bitmap) {
 
 	assert(num_particles <= static_cast<int>(particles.size()));
 
-	for (int i = 0; i < num_particles; ++i) {
-		auto& p = particles[i];
-		const int color = (i % num_sand_colors);
+	// One batch per color
+	for (int color = 0; color < num_sand_colors; ++color) {
+		ClearParticleBatch();
+		for (int i = color; i < num_particles; i += num_sand_colors) {
+			auto& p = particles[i];
+			AddToParticleBatch(p.x, p.y, p.alpha);
+		}
 
 		auto rect = Rect{
 			0,
@@ -287,7 +307,8 @@ void Weather::DrawSandParticles(Bitmap& dst, const Bitmap& particle_bitmap) {
 			sand_particle_rect.height
 		};
 
-		dst.Blit(p.x, p.y, *bitmap, rect, p.alpha);
+		dst.ParticleBlit(0, 0, Rect(), *bitmap, rect,
+			particle_x.data(), particle_y.data(), particle_opacity.data(), static_cast<int>(particle_x.size()));
 	}
 }
 
@@ -19,7 +19,9 @@
 #define EP_WEATHER_H
 
 // Headers
+#include <cstdint>
 #include <string>
+#include <vector>
 #include "drawable.h"
 #include "system.h"
 #include "tone.h"
@@ -35,6 +37,9 @@ public:
 	void Draw(Bitmap& dst) override;
 	void Update();
 
+	/** Particles move every frame, only the disabled weather is tracked */
+	bool TracksDamage() const override;
+
 	Tone GetTone() const;
 	void SetTone(Tone tone);
 
@@ -56,6 +61,8 @@ private:
 	void DrawFogOverlay(Bitmap& dst, const Bitmap& overlay);
 	void DrawSandParticles(Bitmap& dst, const Bitmap& particle);
 	const Bitmap* ApplyToneEffect(const Bitmap& bitmap, Rect rect);
+	void ClearParticleBatch();
+	void AddToParticleBatch(int x, int y, int opacity);
 
 	BitmapRef snow_bitmap;
 	BitmapRef rain_bitmap;
@@ -65,7 +72,10 @@ private:
 
 	BitmapRef tone_bitmap;
 
-	BitmapRef weather_surface;
+	/** Visible particles of the current batch, one array per field */
+	std::vector<int16_t> particle_x;
+	std::vector<int16_t> particle_y;
+	std::vector<uint8_t> particle_opacity;
 
 	Tone tone_effect;
 
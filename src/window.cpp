@@ -16,17 +16,79 @@
  */
 
 // Headers
+#include <array>
 #include <cmath>
+#include <memory>
+#include "lru_cache.h"
 #include "system.h"
 #include "player.h"
 #include "rect.h"
 #include "util_macro.h"
 #include "window.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "drawable_mgr.h"
 
 constexpr int arrow_animation_frames = 20;
 
+namespace {
+	enum class SkinPart {
+		Background,
+		Frame,
+		Cursor
+	};
+
+	struct SkinPartKey {
+		const Bitmap* windowskin;
+		SkinPart part;
+		int width;
+		int height;
+		bool stretch;
+
+		bool operator==(const SkinPartKey& other) const {
+			return windowskin == other.windowskin && part == other.part &&
+				width == other.width && height == other.height && stretch == other.stretch;
+		}
+	};
+
+	struct SkinPartKeyHash {
+		size_t operator()(const SkinPartKey& key) const {
+			size_t h = std::hash<const Bitmap*>()(key.windowskin);
+			h = h * 31 + static_cast<size_t>(key.part);
+			h = h * 31 + static_cast<size_t>(key.width);
+			h = h * 31 + static_cast<size_t>(key.height);
+			return h * 2 + key.stretch;
+		}
+	};
+
+	using SkinPartBitmaps = std::array<BitmapRef, 4>;
+
+	struct SkinPartEntry {
+		/** Detects a new windowskin that was allocated at the address of a freed one */
+		std::weak_ptr<Bitmap> windowskin;
+		SkinPartBitmaps bitmaps;
+	};
+
+	// Windows with the same windowskin and size share the bitmaps of their
+	// background, frame and cursor. The bitmaps are never modified after creation.
+	constexpr size_t skin_part_cache_limit = 64;
+	LruCache<SkinPartKey, SkinPartEntry, SkinPartKeyHash> skin_part_cache(skin_part_cache_limit);
+
+	const SkinPartBitmaps* FindSkinPart(const BitmapRef& windowskin, SkinPart part, int width, int height, bool stretch) {
+		SkinPartKey key = { windowskin.get(), part, width, height, stretch };
+		auto* entry = skin_part_cache.Find(key);
+		if (!entry || entry->windowskin.lock() != windowskin) {
+			return nullptr;
+		}
+		return &entry->bitmaps;
+	}
+
+	void StoreSkinPart(const BitmapRef& windowskin, SkinPart part, int width, int height, bool stretch, SkinPartBitmaps bitmaps) {
+		SkinPartKey key = { windowskin.get(), part, width, height, stretch };
+		skin_part_cache.Insert(key, { windowskin, std::move(bitmaps) });
+	}
+}
+
 Window::Window(Drawable::Flags flags): Drawable(Priority_Window, flags)
 {
 	DrawableMgr::Register(this);
@@ -175,9 +237,35 @@ void Window::Draw(Bitmap& dst) {
 	}
 }
 
+uint64_t Window::GetDrawState(Rect& bounds) {
+	if (width <= 0 || height <= 0) {
+		bounds = {};
+		return 0;
+	}
+
+	// The cursor and the arrows can be drawn outside of the window
+	bounds = DamageTracker::Union(Rect(x - 16, y - 16, width + 32, height + 32),
+		Rect(x + cursor_rect.x + border_x, y + cursor_rect.y + border_y, cursor_rect.width, cursor_rect.height));
+
+	DrawStateHash state;
+	state.Add(windowskin.get()).Add(windowskin ? windowskin->GetRevision() : 0);
+	state.Add(contents.get()).Add(contents ? contents->GetRevision() : 0);
+	state.Add(stretch).Add(cursor_rect).Add(x).Add(y).Add(width).Add(height).Add(ox).Add(oy)
+		.Add(border_x).Add(border_y).Add(opacity).Add(frame_opacity).Add(back_opacity).Add(contents_opacity)
+		.Add(up_arrow).Add(down_arrow).Add(left_arrow).Add(right_arrow).Add(animate_arrows).Add(pause)
+		.Add(cursor_frame <= 10).Add(arrow_animation_frame < arrow_animation_frames)
+		.Add(animation_frames).Add(static_cast<int>(animation_count));
+	return state.Get();
+}
+
 void Window::RefreshBackground() {
 	background_needs_refresh = false;
 
+	if (auto* parts = FindSkinPart(windowskin, SkinPart::Background, width, height, stretch)) {
+		background = (*parts)[0];
+		return;
+	}
+
 	BitmapRef bitmap = Bitmap::Create(width, height);
 
 	if (stretch) {
@@ -187,11 +275,20 @@ void Window::RefreshBackground() {
 	}
 
 	background = bitmap;
+	StoreSkinPart(windowskin, SkinPart::Background, width, height, stretch, { bitmap });
 }
 
 void Window::RefreshFrame() {
 	frame_needs_refresh = false;
 
+	if (auto* parts = FindSkinPart(windowskin, SkinPart::Frame, width, height, false)) {
+		frame_up = (*parts)[0];
+		frame_down = (*parts)[1];
+		frame_left = (*parts)[2];
+		frame_right = (*parts)[3];
+		return;
+	}
+
 	BitmapRef up_bitmap = Bitmap::Create(width, 8);
 	BitmapRef down_bitmap = Bitmap::Create(width, 8);
 
@@ -245,6 +342,8 @@ void Window::RefreshFrame() {
 		frame_left = BitmapRef();
 		frame_right = BitmapRef();
 	}
+
+	StoreSkinPart(windowskin, SkinPart::Frame, width, height, false, { frame_up, frame_down, frame_left, frame_right });
 }
 
 void Window::RefreshCursor() {
@@ -253,6 +352,12 @@ void Window::RefreshCursor() {
 	int cw = cursor_rect.width;
 	int ch = cursor_rect.height;
 
+	if (auto* parts = FindSkinPart(windowskin, SkinPart::Cursor, cw, ch, false)) {
+		cursor1 = (*parts)[0];
+		cursor2 = (*parts)[1];
+		return;
+	}
+
 	BitmapRef cursor1_bitmap = Bitmap::Create(cw, ch);
 	BitmapRef cursor2_bitmap = Bitmap::Create(cw, ch);
 
@@ -304,6 +409,7 @@ void Window::RefreshCursor() {
 
 	cursor1 = cursor1_bitmap;
 	cursor2 = cursor2_bitmap;
+	StoreSkinPart(windowskin, SkinPart::Cursor, cw, ch, false, { cursor1, cursor2 });
 }
 
 void Window::Update() {
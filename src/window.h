@@ -33,6 +33,10 @@ public:
 
 	void Draw(Bitmap& dst) override;
 
+	bool TracksDamage() const override;
+
+	uint64_t GetDrawState(Rect& bounds) override;
+
 	virtual void Update();
 	BitmapRef const& GetWindowskin() const;
 	void SetWindowskin(BitmapRef const& nwindowskin);
@@ -141,6 +145,10 @@ private:
 	double animation_increment = 0.0;
 };
 
+inline bool Window::TracksDamage() const {
+	return true;
+}
+
 inline bool Window::IsOpening() const {
 	return animation_frames > 0 && !closing;
 }
@@ -28,7 +28,9 @@
 #include "keys.h"
 #include "output.h"
 #include "baseui.h"
+#include "async_handler.h"
 #include "bitmap.h"
+#include "cache.h"
 #include "player.h"
 #include "system.h"
 #include "audio.h"
@@ -283,6 +285,9 @@ void Window_Settings::RefreshVideo() {
 	AddOption(cfg.scaling_mode, [this](){ DisplayUi->SetScalingMode(static_cast<ConfigEnum::ScalingMode>(GetCurrentOption().current_value)); });
 	AddOption(cfg.pause_when_focus_lost, [cfg]() mutable { DisplayUi->SetPauseWhenFocusLost(cfg.pause_when_focus_lost.Toggle()); });
 	AddOption(cfg.touch_ui, [](){ DisplayUi->ToggleTouchUi(); });
+	AddOption(cfg.partial_update, [](){ DisplayUi->TogglePartialUpdate(); });
+	AddOption(cfg.threaded_rendering, [cfg]() mutable { DisplayUi->SetThreadedRendering(cfg.threaded_rendering.Toggle()); });
+	AddOption(cfg.threaded_presentation, [](){ DisplayUi->ToggleThreadedPresentation(); });
 	AddOption(cfg.game_resolution, [this]() { DisplayUi->SetGameResolution(static_cast<ConfigEnum::GameResolution>(GetCurrentOption().current_value)); });
 }
 
@@ -423,6 +428,10 @@ void Window_Settings::RefreshEngine() {
 	AddOption(cfg.settings_autosave, [&cfg](){ cfg.settings_autosave.Toggle(); });
 	AddOption(cfg.settings_in_title, [&cfg](){ cfg.settings_in_title.Toggle(); });
 	AddOption(cfg.settings_in_menu, [&cfg](){ cfg.settings_in_menu.Toggle(); });
+	AddOption(cfg.cache_size, [this, &cfg](){ auto tmp = GetCurrentOption().current_value; cfg.cache_size.Set(tmp); Cache::SetSizeLimit(static_cast<size_t>(tmp) * 1024 * 1024); });
+	AddOption(cfg.effect_cache_size, [this, &cfg](){ auto tmp = GetCurrentOption().current_value; cfg.effect_cache_size.Set(tmp); Cache::SetEffectSizeLimit(static_cast<size_t>(tmp) * 1024 * 1024); });
+	AddOption(cfg.prefetch_size, [this, &cfg](){ cfg.prefetch_size.Set(GetCurrentOption().current_value); });
+	AddOption(cfg.threaded_loading, [&cfg](){ AsyncHandler::SetThreaded(cfg.threaded_loading.Toggle()); });
 }
 
 void Window_Settings::RefreshEngineFont(bool mincho) {
@@ -0,0 +1,79 @@
+#include <string>
+#include <vector>
+#include "asset_prefetch.h"
+#include "doctest.h"
+#include <lcf/data.h>
+#include <lcf/rpg/map.h>
+
+namespace {
+
+using Cmd = lcf::rpg::EventCommand::Code;
+
+lcf::rpg::EventCommand MakeCommand(Cmd code, const std::string& string, std::vector<int32_t> parameters) {
+	lcf::rpg::EventCommand com;
+	com.code = static_cast<int32_t>(code);
+	com.string = lcf::DBString(string);
+	com.parameters = lcf::DBArray<int32_t>(parameters.begin(), parameters.end());
+	return com;
+}
+
+std::vector<std::string> Names(const std::vector<Cache::PreloadImage>& images) {
+	std::vector<std::string> names;
+	for (auto& image: images) {
+		names.push_back(image.folder + "/" + image.filename + (image.transparent ? "" : "!"));
+	}
+	return names;
+}
+
+}
+
+TEST_SUITE_BEGIN("AssetPrefetch");
+
+TEST_CASE("CollectMapImages") {
+	lcf::Data::animations.resize(2);
+	lcf::Data::animations[0].animation_name = lcf::DBString("Slash");
+	lcf::Data::animations[1].animation_name = lcf::DBString("Meteor");
+	lcf::Data::animations[1].large = true;
+
+	lcf::Data::commonevents.resize(1);
+	lcf::Data::commonevents[0].event_commands.push_back(MakeCommand(Cmd::ChangeFaceGraphic, "Faces", { 0, 0, 0 }));
+
+	lcf::rpg::Map map;
+	map.parallax_flag = true;
+	map.parallax_name = lcf::DBString("Sky");
+
+	map.events.resize(2);
+	map.events[0].pages.resize(2);
+	map.events[0].pages[0].character_name = lcf::DBString("People1");
+	map.events[0].pages[1].character_name = lcf::DBString("People2");
+
+	lcf::rpg::MoveCommand change_graphic;
+	change_graphic.command_id = static_cast<int>(lcf::rpg::MoveCommand::Code::change_graphic);
+	change_graphic.parameter_string = lcf::DBString("Monster1");
+	map.events[0].pages[1].move_route.move_commands.push_back(change_graphic);
+
+	map.events[1].pages.resize(1);
+	map.events[1].pages[0].character_name = lcf::DBString("People1");
+	auto& commands = map.events[1].pages[0].event_commands;
+	commands.push_back(MakeCommand(Cmd::ShowPicture, "Title", { 1, 0, 160, 120, 0, 100, 0, 1 }));
+	commands.push_back(MakeCommand(Cmd::ShowPicture, "Title", { 1, 0, 160, 120, 0, 100, 0, 0 }));
+	commands.push_back(MakeCommand(Cmd::ShowBattleAnimation, "", { 1, 0, 0, 0 }));
+	commands.push_back(MakeCommand(Cmd::ShowBattleAnimation, "", { 2, 0, 0, 0 }));
+	commands.push_back(MakeCommand(Cmd::ShowBattleAnimation, "", { 3, 0, 0, 0 }));
+	commands.push_back(MakeCommand(Cmd::ChangePBG, "Sky", { 0, 0, 0, 0, 0, 0 }));
+	commands.push_back(MakeCommand(Cmd::ChangeVehicleGraphic, "Vehicle", { 0, 0 }));
+	// Move route with the encoded command "Change Graphic" of "Ship" (34, length, characters, index)
+	commands.push_back(MakeCommand(Cmd::MoveEvent, "", { 10001, 6, 0, 0, 34, 4, 'S', 'h', 'i', 'p', 0 }));
+
+	auto names = Names(AssetPrefetch::CollectMapImages(map));
+
+	REQUIRE_EQ(names, std::vector<std::string>{
+		"Panorama/Sky", "CharSet/People1", "CharSet/People2", "CharSet/Monster1",
+		"Picture/Title", "Picture/Title!", "Battle/Slash", "Battle2/Meteor",
+		"CharSet/Vehicle", "CharSet/Ship", "FaceSet/Faces" });
+
+	lcf::Data::animations.clear();
+	lcf::Data::commonevents.clear();
+}
+
+TEST_SUITE_END();
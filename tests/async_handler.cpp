@@ -0,0 +1,111 @@
+#include <chrono>
+#include <thread>
+#include "async_handler.h"
+#include "cache.h"
+#include "drawable_list.h"
+#include "drawable_mgr.h"
+#include "filefinder.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("AsyncHandler");
+
+namespace {
+	// Graphic requests query the transition, which is a drawable
+	struct RequestFixture {
+		RequestFixture() {
+			DrawableMgr::SetLocalList(&list);
+			FileFinder::SetGameFilesystem(FileFinder::Root().Subtree(EP_TEST_PATH "/game"));
+		}
+
+		~RequestFixture() {
+			AsyncHandler::SetThreaded(false);
+			AsyncHandler::ClearRequests();
+			Cache::ClearAll();
+			FileFinder::SetGameFilesystem({});
+			DrawableMgr::SetLocalList(nullptr);
+		}
+
+		FileRequestAsync* Request(bool& done) {
+			auto* request = AsyncHandler::RequestFile("CharSet", "chara1");
+			request->SetGraphicFile(true);
+			binding = request->Bind([&done](FileRequestResult* result) {
+				done = result->success;
+			});
+			request->Start();
+			return request;
+		}
+
+		DrawableList list;
+		FileRequestBinding binding;
+	};
+}
+
+TEST_CASE_FIXTURE(RequestFixture, "Synchronous") {
+	AsyncHandler::SetThreaded(false);
+
+	bool done = false;
+	auto* request = Request(done);
+
+	CHECK(request->IsReady());
+	CHECK(done);
+	CHECK(!AsyncHandler::IsGraphicFilePending());
+}
+
+TEST_CASE_FIXTURE(RequestFixture, "Threaded") {
+	AsyncHandler::SetThreaded(true);
+
+	bool done = false;
+	auto* request = Request(done);
+
+	if (AsyncHandler::IsThreaded()) {
+		// Listeners are only called by Update
+		CHECK(!done);
+		CHECK(AsyncHandler::IsGraphicFilePending());
+	}
+
+	for (int i = 0; i < 5000 && !request->IsReady(); ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		AsyncHandler::Update();
+	}
+
+	REQUIRE(request->IsReady());
+	CHECK(done);
+
+	// The decoded image is in the cache
+	const auto hits = Cache::GetStats().hits;
+	CHECK(Cache::Charset("chara1"));
+	CHECK_EQ(Cache::GetStats().hits, hits + (AsyncHandler::IsThreaded() ? 1 : 0));
+}
+
+TEST_CASE_FIXTURE(RequestFixture, "Prefetch") {
+	const auto preloaded = Cache::GetStats().preloaded;
+	AsyncHandler::Prefetch({ { "CharSet", "chara1" } }, 1024 * 1024);
+
+	// Nothing is loaded before Update
+	CHECK_EQ(Cache::GetStats().preloaded, preloaded);
+
+	for (int i = 0; i < 5000 && Cache::GetStats().preloaded == preloaded; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		AsyncHandler::Update();
+	}
+
+	REQUIRE_EQ(Cache::GetStats().preloaded, preloaded + 1);
+
+	const auto hits = Cache::GetStats().hits;
+	CHECK(Cache::Charset("chara1"));
+	CHECK_EQ(Cache::GetStats().hits, hits + 1);
+}
+
+TEST_CASE_FIXTURE(RequestFixture, "PrefetchWithoutBudget") {
+	const auto preloaded = Cache::GetStats().preloaded;
+	AsyncHandler::Prefetch({ { "CharSet", "chara1" } }, 0);
+
+	for (int i = 0; i < 20; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		AsyncHandler::Update();
+	}
+
+	CHECK_EQ(Cache::GetStats().preloaded, preloaded);
+}
+
+TEST_SUITE_END();
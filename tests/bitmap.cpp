@@ -0,0 +1,533 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "bitmap.h"
+#include "bitmap_hslrgb.h"
+#include "pixel_format.h"
+#include "pixel_ops.h"
+#include "point.h"
+#include "thread_pool.h"
+#include "test_bitmap.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("Bitmap");
+
+namespace {
+
+constexpr int width = 23;
+constexpr int height = 11;
+
+// Deterministic premultiplied pixels with all kinds of alpha values
+BitmapRef MakeSource() {
+	auto bitmap = Bitmap::Create(width, height, true);
+	uint32_t state = 4711;
+	for (int y = 0; y < height; ++y) {
+		auto* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(bitmap->pixels()) + y * bitmap->pitch());
+		for (int x = 0; x < width; ++x) {
+			state = state * 1664525u + 1013904223u;
+			uint32_t a = (state >> 24) & 0xFF;
+			if (x % 3 == 0) {
+				a = 0xFF;
+			} else if (x % 5 == 0) {
+				a = 0;
+			}
+			auto ch = [&](int shift) { return static_cast<uint8_t>(((state >> shift) & 0xFF) * a / 255); };
+			row[x] = Bitmap::pixel_format.rgba_to_uint32_t(ch(0), ch(8), ch(16), static_cast<uint8_t>(a));
+		}
+	}
+	return bitmap;
+}
+
+BitmapRef MakeBackground() {
+	return Bitmap::Create(width + 8, height + 8, Color(40, 90, 200, 255));
+}
+
+// Particles that don't overlap on a 24x12 surface, also not with their clones
+constexpr int num_particles = 5;
+const int16_t particle_x[num_particles] = { 1, 9, 20, -4, 14 };
+const int16_t particle_y[num_particles] = { 1, 6, 9, 5, 0 };
+const uint8_t particle_opacity[num_particles] = { 255, 128, 40, 200, 0 };
+
+void TestEffects(int x, int y, Rect src_rect, bool flip_x, bool flip_y, Tone tone, Color color, Opacity opacity) {
+	auto src = MakeSource();
+
+	// Reference: The effect bitmap created by Cache::SpriteEffect
+	auto effects = Bitmap::Create(src_rect.width, src_rect.height, true);
+	effects->ToneBlit(0, 0, *src, src_rect, tone, Opacity::Opaque());
+	effects->BlendBlit(0, 0, *effects, effects->GetRect(), color, Opacity::Opaque());
+	effects->Flip(flip_x, flip_y);
+
+	auto expected = MakeBackground();
+	expected->Blit(x, y, *effects, effects->GetRect(), opacity, Bitmap::BlendMode::Normal);
+
+	auto actual = MakeBackground();
+	actual->ToneBlendFlipBlit(x, y, *src, src_rect, flip_x, flip_y, tone, color, opacity);
+
+	REQUIRE(SamePixels(*expected, *actual));
+}
+
+}
+
+TEST_CASE("PixelOps") {
+	for (uint32_t a = 0; a < 256; ++a) {
+		for (uint32_t b = 0; b < 256; ++b) {
+			const uint32_t t = a * b + 0x80;
+			REQUIRE_EQ(PixelOps::MulUn8(a, b), ((t >> 8) + t) >> 8);
+			REQUIRE_EQ(PixelOps::MulUn8x4(a * 0x01010101u, b), PixelOps::MulUn8(a, b) * 0x01010101u);
+		}
+		REQUIRE_EQ(PixelOps::AddUn8x4(a * 0x01010101u, 0x80808080u), std::min<uint32_t>(a + 0x80, 0xFF) * 0x01010101u);
+	}
+}
+
+TEST_CASE("ToneBlendFlipBlit") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	const Rect full(0, 0, width, height);
+	const Rect sub(3, 2, 13, 7);
+
+	for (auto flip_x: { false, true }) {
+		for (auto flip_y: { false, true }) {
+			TestEffects(4, 4, full, flip_x, flip_y, Tone(), Color(), Opacity::Opaque());
+			TestEffects(4, 4, full, flip_x, flip_y, Tone(200, 50, 128, 100), Color(), Opacity::Opaque());
+			TestEffects(1, 6, sub, flip_x, flip_y, Tone(), Color(255, 0, 128, 170), Opacity(160));
+			TestEffects(-5, -3, sub, flip_x, flip_y, Tone(10, 240, 128, 0), Color(20, 255, 60, 90), Opacity::Opaque());
+			TestEffects(20, 12, full, flip_x, flip_y, Tone(128, 128, 128, 255), Color(255, 255, 255, 255), Opacity(77));
+		}
+	}
+}
+
+TEST_CASE("ClippedView") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto src = MakeSource();
+
+	auto draw = [&](Bitmap& dst) {
+		dst.Blit(-3, 5, *src, src->GetRect(), Opacity(200, 100, 4));
+		dst.ToneBlendFlipBlit(7, -2, *src, src->GetRect(), true, false, Tone(10, 240, 128, 0), Color(20, 255, 60, 90), Opacity(160));
+		dst.TiledBlit(2, 3, src->GetRect(), *src, Rect(1, 1, 20, 17), Opacity(77));
+		dst.ParticleBlit(-4, 6, Rect(0, 0, 24, 12), *src, Rect(2, 1, 6, 4), particle_x, particle_y, particle_opacity, num_particles);
+	};
+
+	auto expected = MakeBackground();
+	draw(*expected);
+
+	// Drawing in bands gives the same result as drawing at once
+	auto actual = MakeBackground();
+	const int band_h = 5;
+	for (int y = 0; y < actual->height(); y += band_h) {
+		auto band = actual->CreateClippedView(Rect(0, y, actual->width(), band_h));
+		REQUIRE_EQ(band->GetClipRect(), Rect(0, y, actual->width(), std::min(band_h, actual->height() - y)));
+		draw(*band);
+	}
+
+	REQUIRE(SamePixels(*expected, *actual));
+}
+
+TEST_CASE("ParallelRead") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto src = MakeSource();
+
+	// pixman composites with a mask instead of the fast copy paths
+	auto draw = [&](Bitmap& dst) {
+		dst.Blit(-3, 5, *src, src->GetRect(), Opacity(200, 100, 4));
+		dst.Blit(4, -1, *src, src->GetRect(), Opacity(77));
+	};
+
+	auto expected = MakeBackground();
+	draw(*expected);
+
+	// Resetting the transformation of the source marks the pixman image as
+	// changed, the next composite validates it again
+	auto copy = Bitmap::Create(*src, src->GetRect());
+	auto stretched = Bitmap::Create(width * 2, height * 2, true);
+	stretched->StretchBlit(stretched->GetRect(), *src, src->GetRect(), Opacity::Opaque());
+
+	// Validating the image does not change it
+	src->PrepareParallelRead();
+	REQUIRE(SamePixels(*copy, *src));
+
+	// Like BandRenderer the source is shared by all threads, each band has its
+	// own pixman image. Run under ThreadSanitizer this also catches pixman
+	// validating the source image concurrently.
+	auto actual = MakeBackground();
+	std::vector<BitmapRef> bands;
+	for (int y = 0; y < actual->height(); ++y) {
+		bands.push_back(actual->CreateClippedView(Rect(0, y, actual->width(), 1)));
+	}
+
+	ThreadPool pool(4);
+	pool.ParallelFor(static_cast<int>(bands.size()), [&](int band) {
+		draw(*bands[band]);
+	});
+
+	REQUIRE(SamePixels(*expected, *actual));
+}
+
+TEST_CASE("ParticleBlit") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto src = MakeSource();
+	const Rect particle(2, 1, 6, 4);
+
+	// Reference: Weather particles drawn on a surface which is tiled over the screen
+	auto surface = Bitmap::Create(24, 12, true);
+	surface->Clear();
+	for (int i = 0; i < num_particles; ++i) {
+		surface->EdgeMirrorBlit(particle_x[i], particle_y[i], *src, particle, true, true, particle_opacity[i]);
+	}
+
+	for (auto offset: { Point(0, 0), Point(-5, 7), Point(30, -13) }) {
+		auto expected = MakeBackground();
+		expected->TiledBlit(offset.x, offset.y, surface->GetRect(), *surface, expected->GetRect(), Opacity::Opaque());
+
+		auto actual = MakeBackground();
+		actual->ParticleBlit(offset.x, offset.y, surface->GetRect(), *src, particle, particle_x, particle_y, particle_opacity, num_particles);
+
+		REQUIRE(SamePixels(*expected, *actual));
+	}
+
+	// Without wrapping every particle is a normal blit
+	auto expected = MakeBackground();
+	for (int i = 0; i < num_particles; ++i) {
+		expected->Blit(particle_x[i] + 3, particle_y[i] - 2, *src, particle, particle_opacity[i]);
+	}
+
+	auto actual = MakeBackground();
+	actual->ParticleBlit(-3, 2, Rect(), *src, particle, particle_x, particle_y, particle_opacity, num_particles);
+
+	REQUIRE(SamePixels(*expected, *actual));
+}
+
+TEST_CASE("TransitionKernels") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto alpha_src = MakeSource();
+	auto opaque_src = Bitmap::Create(width, height, false);
+	opaque_src->BlitFast(0, 0, *alpha_src, alpha_src->GetRect(), Opacity::Opaque());
+	auto src2 = Bitmap::Create(width, height, Color(200, 30, 70, 255));
+
+	for (auto& src1: { alpha_src, opaque_src }) {
+		for (int opacity: { 0, 100, 255 }) {
+			auto expected = MakeBackground();
+			expected->Blit(0, 0, *src1, src1->GetRect(), Opacity::Opaque());
+			expected->Blit(0, 0, *src2, src2->GetRect(), opacity);
+
+			auto actual = MakeBackground();
+			actual->CrossFadeBlit(*src1, *src2, opacity);
+
+			REQUIRE(SamePixels(*expected, *actual));
+		}
+
+		for (bool columns: { false, true }) {
+			const int count = columns ? width : height;
+			std::vector<uint8_t> lines(count);
+			for (int i = 0; i < count; ++i) {
+				lines[i] = (i / 3) % 3;
+			}
+
+			auto expected = MakeBackground();
+			for (int i = 0; i < count; ++i) {
+				auto& src = lines[i] == 1 ? *src1 : *src2;
+				const Rect rect = columns ? Rect(i, 0, 1, height) : Rect(0, i, width, 1);
+				if (lines[i] != 0) {
+					expected->Blit(rect.x, rect.y, src, rect, Opacity::Opaque());
+				}
+			}
+
+			auto actual = MakeBackground();
+			actual->StripeBlit(*src1, *src2, lines.data(), columns);
+
+			REQUIRE(SamePixels(*expected, *actual));
+		}
+
+		std::vector<int> src_x(width + 8);
+		std::vector<int> src_y(height + 8);
+		for (size_t i = 0; i < src_x.size(); ++i) {
+			src_x[i] = (i / 4 * 4 + 3) % width;
+		}
+		for (size_t i = 0; i < src_y.size(); ++i) {
+			src_y[i] = (i / 4 * 4 + 1) % height;
+		}
+
+		auto expected = MakeBackground();
+		for (int y = 0; y < expected->height(); ++y) {
+			for (int x = 0; x < expected->width(); ++x) {
+				expected->Blit(x, y, *src1, Rect(src_x[x], src_y[y], 1, 1), Opacity::Opaque());
+			}
+		}
+
+		auto actual = MakeBackground();
+		actual->RemapBlit(*src1, src_x.data(), src_y.data());
+
+		REQUIRE(SamePixels(*expected, *actual));
+	}
+}
+
+namespace {
+
+struct BitmapAccess : public Bitmap {
+	static pixman_image_t* GetImage(const Bitmap& bm) {
+		return (bm.*(&BitmapAccess::bitmap)).get();
+	}
+
+	static void SetImageOpacity(Bitmap& bm, ImageOpacity opacity) {
+		bm.*(&BitmapAccess::image_opacity) = opacity;
+	}
+};
+
+// Source with 1 bit alpha: Transparent every fifth column
+BitmapRef MakeSource1Bit() {
+	auto bitmap = MakeSource();
+	for (int y = 0; y < height; ++y) {
+		auto* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(bitmap->pixels()) + y * bitmap->pitch());
+		for (int x = 0; x < width; ++x) {
+			row[x] = x % 5 == 0 ? 0 : row[x] | Bitmap::pixel_format.rgba_to_uint32_t(0, 0, 0, 255);
+		}
+	}
+	BitmapAccess::SetImageOpacity(*bitmap, ImageOpacity::Alpha_1Bit);
+	return bitmap;
+}
+
+// Source without alpha channel
+BitmapRef MakeSourceOpaque() {
+	auto bitmap = Bitmap::Create(width, height, false);
+	bitmap->BlitFast(0, 0, *MakeSource(), Rect(0, 0, width, height), Opacity::Opaque());
+	return bitmap;
+}
+
+}
+
+TEST_CASE("DirectBlit") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto alpha_1bit = MakeSource1Bit();
+	auto opaque = MakeSourceOpaque();
+	auto alpha_8bit = MakeSource();
+
+	auto composite = [](Bitmap& dst, pixman_op_t op, Bitmap& src, int x, int y, Rect rect) {
+		pixman_image_composite32(op, BitmapAccess::GetImage(src), nullptr, BitmapAccess::GetImage(dst),
+			rect.x, rect.y, 0, 0, x, y, rect.width, rect.height);
+	};
+
+	for (auto pos: { Point(0, 0), Point(5, 3), Point(-4, -2), Point(20, 15) }) {
+		const Rect rect(2, 1, 17, 9);
+
+		for (auto& src: { alpha_1bit, opaque }) {
+			auto expected = MakeBackground();
+			composite(*expected, src == opaque ? PIXMAN_OP_SRC : PIXMAN_OP_OVER, *src, pos.x, pos.y, rect);
+
+			auto actual = MakeBackground();
+			actual->Blit(pos.x, pos.y, *src, rect, Opacity::Opaque());
+
+			REQUIRE(SamePixels(*expected, *actual));
+		}
+
+		for (auto& src: { alpha_1bit, opaque, alpha_8bit }) {
+			auto expected = MakeBackground();
+			composite(*expected, PIXMAN_OP_SRC, *src, pos.x, pos.y, rect);
+
+			auto actual = MakeBackground();
+			actual->BlitFast(pos.x, pos.y, *src, rect, Opacity::Opaque());
+
+			REQUIRE(SamePixels(*expected, *actual));
+		}
+	}
+
+	// Tiling: Every pixel is blitted on its own as reference
+	const Rect tile(3, 2, 7, 5);
+	const Rect dst_rect(-2, 3, 30, 13);
+	for (auto& src: { alpha_1bit, opaque }) {
+		auto expected = MakeBackground();
+		for (int y = std::max(dst_rect.y, 0); y < dst_rect.y + dst_rect.height; ++y) {
+			for (int x = std::max(dst_rect.x, 0); x < dst_rect.x + dst_rect.width; ++x) {
+				const int sx = tile.x + (x - dst_rect.x + 4) % tile.width;
+				const int sy = tile.y + (y - dst_rect.y + 12) % tile.height;
+				composite(*expected, src == opaque ? PIXMAN_OP_SRC : PIXMAN_OP_OVER, *src, x, y, Rect(sx, sy, 1, 1));
+			}
+		}
+
+		auto actual = MakeBackground();
+		actual->TiledBlit(4, -3, tile, *src, dst_rect, Opacity::Opaque());
+
+		REQUIRE(SamePixels(*expected, *actual));
+	}
+}
+
+TEST_CASE("EffectsBlitRect") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	auto src = Bitmap::Create(width, height, Color(255, 255, 255, 255));
+
+	auto test = [&](int x, int y, int ox, int oy, double zoom_x, double zoom_y, double angle, int depth) {
+		auto dst = Bitmap::Create(96, 96, true);
+		dst->EffectsBlit(x, y, ox, oy, *src, src->GetRect(), Opacity::Opaque(), zoom_x, zoom_y, angle, depth, 1.0);
+
+		const Rect rect = Bitmap::GetEffectsBlitRect(x, y, ox, oy, src->GetRect(), zoom_x, zoom_y, angle, depth);
+
+		// Every drawn pixel is inside the rect
+		for (int py = 0; py < dst->height(); ++py) {
+			auto* row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(dst->pixels()) + py * dst->pitch());
+			for (int px = 0; px < dst->width(); ++px) {
+				if (row[px] != 0) {
+					REQUIRE(px >= rect.x);
+					REQUIRE(py >= rect.y);
+					REQUIRE(px < rect.x + rect.width);
+					REQUIRE(py < rect.y + rect.height);
+				}
+			}
+		}
+	};
+
+	test(10, 20, 0, 0, 1.0, 1.0, 0.0, 0);
+	test(40, 40, 11, 5, 2.5, 0.5, 0.0, 0);
+	test(48, 48, 11, 5, 1.0, 1.0, 0.7, 0);
+	test(48, 48, 11, 5, 1.5, 2.0, 2.3, 0);
+	test(48, 48, 0, 11, 0.8, 1.2, -1.1, 0);
+	test(30, 30, 11, 5, 1.0, 1.0, 0.0, 4);
+	test(30, 30, 11, 5, 2.0, 1.5, 0.0, 7);
+	test(-6, -4, 11, 5, 1.0, 1.0, 0.4, 3);
+
+	// Far outside of 16 bit coordinates
+	REQUIRE(Bitmap::GetEffectsBlitRect(100000, 100000, 0, 0, src->GetRect(), 1.0, 1.0, 1.0, 0).IsOutOfBounds(Rect(0, 0, 320, 240)));
+	REQUIRE_FALSE(Bitmap::GetEffectsBlitRect(330, 100, 0, 0, src->GetRect(), 1.0, 1.0, 3.14159, 0).IsOutOfBounds(Rect(0, 0, 320, 240)));
+}
+
+TEST_CASE("AffineBlit") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	const std::vector<BitmapRef> sources = { MakeSource(), MakeSource1Bit(), MakeSourceOpaque() };
+	const std::vector<Opacity> opacities = { Opacity::Opaque(), Opacity(160), Opacity(200, 80, 4), Opacity(255, 100, 9) };
+	const Rect full(0, 0, width, height);
+	const Rect sub(3, 2, 13, 7);
+
+	// The same blits drawn by pixman and without pixman
+	auto test = [&](auto&& draw) {
+		for (auto& src: sources) {
+			for (auto& opacity: opacities) {
+				Bitmap::SetPixmanAffineBlit(true);
+				auto expected = MakeBackground();
+				draw(*expected, *src, opacity);
+
+				Bitmap::SetPixmanAffineBlit(false);
+				auto actual = MakeBackground();
+				draw(*actual, *src, opacity);
+
+				// In bands like the band renderer
+				auto banded = MakeBackground();
+				for (int y = 0; y < banded->height(); y += 6) {
+					draw(*banded->CreateClippedView(Rect(0, y, banded->width(), 6)), *src, opacity);
+				}
+
+				REQUIRE(SamePixels(*expected, *actual));
+				REQUIRE(SamePixels(*expected, *banded));
+			}
+		}
+	};
+
+	for (double angle: { 0.3, 1.0, 2.5, -0.8, 3.14159265 }) {
+		for (double zoom: { 1.0, 0.6, 1.7 }) {
+			test([&](Bitmap& dst, Bitmap& src, Opacity opacity) {
+				dst.RotateZoomOpacityBlit(15, 9, 11, 5, src, full, angle, zoom, zoom * 0.9, opacity, Bitmap::BlendMode::Default);
+				dst.RotateZoomOpacityBlit(4, 12, 2, 3, src, sub, angle, zoom, zoom, opacity, Bitmap::BlendMode::Normal);
+			});
+		}
+	}
+
+	for (double zoom_x: { 0.5, 1.0, 1.3, 2.0 }) {
+		for (double zoom_y: { 0.7, 1.0, 2.4 }) {
+			test([&](Bitmap& dst, Bitmap& src, Opacity opacity) {
+				dst.ZoomOpacityBlit(12, 8, 11, 5, src, full, zoom_x, zoom_y, opacity, Bitmap::BlendMode::Default);
+				dst.ZoomOpacityBlit(-3, 14, 0, 0, src, sub, zoom_x, zoom_y, opacity, Bitmap::BlendMode::Normal);
+			});
+		}
+	}
+
+	test([&](Bitmap& dst, Bitmap& src, Opacity opacity) {
+		dst.StretchBlit(Rect(2, 3, 27, 14), src, sub, opacity);
+	});
+
+	for (double zoom: { 1.0, 0.8, 1.6 }) {
+		test([&](Bitmap& dst, Bitmap& src, Opacity opacity) {
+			dst.WaverBlit(4, -2, zoom, zoom, src, full, 3, 0.7, opacity, Bitmap::BlendMode::Default);
+			dst.WaverBlit(-5, 6, zoom, 1.2, src, sub, 5, 2.0, opacity, Bitmap::BlendMode::Normal);
+		});
+	}
+
+	Bitmap::SetPixmanAffineBlit(false);
+}
+
+TEST_CASE("HueChangeBlit") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	const auto& fmt = Bitmap::pixel_format;
+	const Rect rect(2, 1, 17, 9);
+
+	for (auto& src: { MakeSource(), MakeSource1Bit(), MakeSourceOpaque() }) {
+		for (double hue: { 0.0, 45.0, 200.0, -100.0, 390.0 }) {
+			int fixed_hue = static_cast<int>(hue / 60.0 * 0x100);
+			fixed_hue = (fixed_hue % 0x600 + 0x600) % 0x600;
+
+			// Reference: Hue of every pixel rotated on its own
+			auto adjusted = Bitmap::Create(rect.width, rect.height, true);
+			for (int y = 0; y < rect.height; ++y) {
+				for (int x = 0; x < rect.width; ++x) {
+					auto* src_row = static_cast<const uint8_t*>(src->pixels()) + (rect.y + y) * src->pitch();
+					uint32_t pixel = reinterpret_cast<const uint32_t*>(src_row)[rect.x + x];
+					uint8_t r, g, b, a;
+					fmt.uint32_to_rgba(pixel, r, g, b, a);
+					if (!src->GetTransparent()) {
+						a = 255;
+					}
+					if (a > 0) {
+						RGB_adjust_HSL(r, g, b, fixed_hue);
+					}
+					auto* dst_row = static_cast<uint8_t*>(adjusted->pixels()) + y * adjusted->pitch();
+					reinterpret_cast<uint32_t*>(dst_row)[x] = fmt.rgba_to_uint32_t(r, g, b, a);
+				}
+			}
+
+			for (auto pos: { Point(0, 0), Point(5, 3), Point(-4, -2), Point(20, 15) }) {
+				auto expected = MakeBackground();
+				expected->Blit(pos.x, pos.y, *adjusted, adjusted->GetRect(), Opacity::Opaque());
+
+				auto actual = MakeBackground();
+				actual->HueChangeBlit(pos.x, pos.y, *src, rect, hue);
+
+				REQUIRE(SamePixels(*expected, *actual));
+			}
+		}
+	}
+}
+
+TEST_CASE("FlashFill") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+
+	for (auto color: { Color(), Color(255, 0, 128, 170), Color(255, 255, 255, 255), Color(31, 200, 7, 1) }) {
+		for (auto keep: { Rect(0, 0, width, height), Rect(3, 2, 17, 7), Rect(0, 4, width, 3), Rect(30, 0, 5, 5) }) {
+			auto src = MakeSource();
+
+			auto expected = Bitmap::Create(width, height, true);
+			expected->Blit(0, 0, *src, src->GetRect(), Opacity::Opaque());
+			if (color.alpha > 0) {
+				auto flash = Bitmap::Create(width, height, color);
+				expected->Blit(0, 0, *flash, flash->GetRect(), Opacity::Opaque());
+			}
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					if (x < keep.x || y < keep.y || x >= keep.x + keep.width || y >= keep.y + keep.height) {
+						expected->ClearRect(Rect(x, y, 1, 1));
+					}
+				}
+			}
+
+			auto actual = Bitmap::Create(width, height, true);
+			actual->Blit(0, 0, *src, src->GetRect(), Opacity::Opaque());
+			actual->FlashFill(color, keep);
+
+			REQUIRE(SamePixels(*expected, *actual));
+		}
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <vector>
+#include "bitmap_tone.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("BitmapTone");
+
+namespace {
+
+constexpr BitmapTone::Kernel kernels[] = {
+	BitmapTone::Kernel::SSE2,
+	BitmapTone::Kernel::AVX2,
+	BitmapTone::Kernel::NEON
+};
+
+constexpr BitmapTone::Layout layouts[] = {
+	{ 24, 16, 8, 0 }, // RGBA
+	{ 8, 16, 24, 0 }, // BGRA
+	{ 16, 8, 0, 24 }, // ARGB
+	{ 0, 8, 16, 24 }  // ABGR
+};
+
+const Tone tones[] = {
+	Tone(255, 255, 255, 128),
+	Tone(0, 0, 0, 128),
+	Tone(128, 129, 127, 128),
+	Tone(200, 50, 128, 128),
+	Tone(128, 128, 128, 0),
+	Tone(128, 128, 128, 255),
+	Tone(128, 128, 128, 77),
+	Tone(255, 0, 130, 0),
+	Tone(10, 240, 128, 200),
+	Tone(129, 128, 128, 255)
+};
+
+// Deterministic pseudo random numbers, rand() differs between platforms
+struct Lcg {
+	uint32_t state = 12345;
+	uint32_t operator()() {
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+};
+
+std::vector<uint32_t> MakePixels(ImageOpacity op, const BitmapTone::Layout& layout, int count) {
+	Lcg rng;
+	std::vector<uint32_t> pixels(count);
+	for (auto& px: pixels) {
+		uint32_t a = rng() & 0xFF;
+		if (op == ImageOpacity::Opaque) {
+			a = 0xFF;
+		} else if (op == ImageOpacity::Alpha_1Bit) {
+			a = (a & 1) ? 0xFF : 0;
+		}
+		// Premultiplied alpha
+		uint32_t r = (rng() & 0xFF) * a / 255;
+		uint32_t g = (rng() & 0xFF) * a / 255;
+		uint32_t b = (rng() & 0xFF) * a / 255;
+		px = (r << layout.r_shift) | (g << layout.g_shift) | (b << layout.b_shift) | (a << layout.a_shift);
+	}
+	return pixels;
+}
+
+void TestKernel(BitmapTone::Kernel kernel, ImageOpacity op) {
+	// Odd sizes exercise the scalar tail of the vector kernels
+	const int width = 37;
+	const int height = 5;
+	const int stride = 41;
+
+	for (auto& layout: layouts) {
+		for (auto& tone: tones) {
+			auto expected = MakePixels(op, layout, stride * height);
+			auto actual = expected;
+
+			REQUIRE(BitmapTone::SetKernel(BitmapTone::Kernel::Scalar));
+			BitmapTone::Apply(expected.data(), width, height, stride, tone, op, layout);
+
+			REQUIRE(BitmapTone::SetKernel(kernel));
+			BitmapTone::Apply(actual.data(), width, height, stride, tone, op, layout);
+
+			REQUIRE_EQ(expected, actual);
+		}
+	}
+
+	BitmapTone::SetKernel(BitmapTone::GetBestKernel());
+}
+
+}
+
+TEST_CASE("Supported") {
+	REQUIRE(BitmapTone::IsSupported(BitmapTone::Kernel::Scalar));
+	REQUIRE(BitmapTone::IsSupported(BitmapTone::GetBestKernel()));
+	REQUIRE_EQ(BitmapTone::GetKernel(), BitmapTone::GetBestKernel());
+}
+
+TEST_CASE("NeutralTone") {
+	const BitmapTone::Layout layout = layouts[0];
+	auto pixels = MakePixels(ImageOpacity::Alpha_8Bit, layout, 64);
+	auto copy = pixels;
+
+	BitmapTone::Apply(pixels.data(), 8, 8, 8, Tone(), ImageOpacity::Alpha_8Bit, layout);
+	REQUIRE_EQ(pixels, copy);
+}
+
+TEST_CASE("TransparentSkipped") {
+	const BitmapTone::Layout layout = layouts[0];
+	std::vector<uint32_t> pixels(16, 0x10203000);
+
+	for (auto kernel: { BitmapTone::Kernel::Scalar, BitmapTone::Kernel::SSE2, BitmapTone::Kernel::AVX2, BitmapTone::Kernel::NEON }) {
+		if (!BitmapTone::SetKernel(kernel)) {
+			continue;
+		}
+		BitmapTone::Apply(pixels.data(), 16, 1, 16, Tone(255, 0, 255, 0), ImageOpacity::Alpha_8Bit, layout);
+		REQUIRE_EQ(pixels, std::vector<uint32_t>(16, 0x10203000));
+	}
+
+	BitmapTone::SetKernel(BitmapTone::GetBestKernel());
+}
+
+TEST_CASE("MatchesScalar") {
+	for (auto kernel: kernels) {
+		if (!BitmapTone::IsSupported(kernel)) {
+			continue;
+		}
+
+		INFO(BitmapTone::GetKernelName(kernel));
+
+		TestKernel(kernel, ImageOpacity::Opaque);
+		TestKernel(kernel, ImageOpacity::Alpha_1Bit);
+		TestKernel(kernel, ImageOpacity::Alpha_8Bit);
+	}
+}
+
+TEST_CASE("MatchesScalarAllValues") {
+	// Every channel value with every tone value
+	const BitmapTone::Layout layout = layouts[2];
+
+	std::vector<uint32_t> source(256);
+	for (uint32_t i = 0; i < 256; ++i) {
+		source[i] = (0xFFu << 24) | (i << 16) | ((255 - i) << 8) | ((i * 7) & 0xFF);
+	}
+
+	for (auto kernel: kernels) {
+		if (!BitmapTone::IsSupported(kernel)) {
+			continue;
+		}
+
+		INFO(BitmapTone::GetKernelName(kernel));
+
+		for (int t = 0; t < 256; ++t) {
+			const Tone tone(t, 255 - t, t, 255 - t);
+
+			auto expected = source;
+			REQUIRE(BitmapTone::SetKernel(BitmapTone::Kernel::Scalar));
+			BitmapTone::Apply(expected.data(), 256, 1, 256, tone, ImageOpacity::Opaque, layout);
+
+			auto actual = source;
+			REQUIRE(BitmapTone::SetKernel(kernel));
+			BitmapTone::Apply(actual.data(), 256, 1, 256, tone, ImageOpacity::Opaque, layout);
+
+			REQUIRE_EQ(expected, actual);
+		}
+	}
+
+	BitmapTone::SetKernel(BitmapTone::GetBestKernel());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,129 @@
+#include <string>
+#include <vector>
+#include "bitmap.h"
+#include "cache.h"
+#include "pixel_format.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("Cache");
+
+namespace {
+	constexpr int width = 16;
+	constexpr int height = 16;
+
+	struct CacheFixture {
+		CacheFixture() {
+			Bitmap::SetFormat(format_R8G8B8A8_a().format());
+			Cache::ClearAll();
+			size = Bitmap::Create(width, height, true)->GetSize();
+			// Room for three unreferenced images
+			Cache::SetSizeLimit(size * 3);
+		}
+
+		~CacheFixture() {
+			Cache::ClearAll();
+			Cache::SetSizeLimit(Cache::default_size_limit);
+		}
+
+		/** Adds a picture, the caller keeps the returned reference when referenced is set */
+		BitmapRef Add(const std::string& name, bool referenced = false) {
+			Cache::DecodeJob job;
+			job.key = "Picture:" + name + ":T";
+			job.bitmap = Bitmap::Create(width, height, true);
+
+			BitmapRef bmp = referenced ? job.bitmap : nullptr;
+			REQUIRE(Cache::AddDecoded(job, referenced));
+			return bmp;
+		}
+
+		/**
+		 * AddDecoded skips cached images. A missing image is added, so this
+		 * is only used at the end of a test.
+		 */
+		bool IsCached(const std::string& name) {
+			Cache::DecodeJob job;
+			job.key = "Picture:" + name + ":T";
+			job.bitmap = Bitmap::Create(width, height, true);
+			return !Cache::AddDecoded(job);
+		}
+
+		size_t size = 0;
+	};
+}
+
+TEST_CASE_FIXTURE(CacheFixture, "EvictLeastRecentlyUsed") {
+	Add("a");
+	Add("b");
+	Add("c");
+	REQUIRE_EQ(Cache::GetStats().entries, 3);
+	REQUIRE_EQ(Cache::GetStats().evictions, 0);
+	REQUIRE_EQ(Cache::GetAvailableSize(), 0);
+
+	// The lookup makes "a" the most recently used image
+	const auto hits = Cache::GetStats().hits;
+	REQUIRE(Cache::Picture("a", true));
+	REQUIRE_EQ(Cache::GetStats().hits, hits + 1);
+
+	Add("d");
+	REQUIRE_EQ(Cache::GetStats().entries, 3);
+	REQUIRE_EQ(Cache::GetStats().evictions, 1);
+
+	REQUIRE(IsCached("a"));
+	REQUIRE(IsCached("c"));
+	REQUIRE(IsCached("d"));
+	REQUIRE_FALSE(IsCached("b"));
+}
+
+TEST_CASE_FIXTURE(CacheFixture, "ReferencedIsNotEvicted") {
+	// Referenced when it is added
+	auto a = Add("a", true);
+	REQUIRE_EQ(Cache::GetStats().pinned, size);
+
+	// Referenced after it was added
+	Add("b");
+	auto b = Cache::Picture("b", true);
+	REQUIRE(b);
+
+	std::vector<std::string> names;
+	for (int i = 0; i < 8; ++i) {
+		names.push_back("other" + std::to_string(i));
+		Add(names.back());
+	}
+
+	REQUIRE_EQ(Cache::GetStats().evictions, 5);
+	REQUIRE_EQ(Cache::GetStats().entries, 5);
+	REQUIRE_EQ(Cache::GetStats().pinned, size * 2);
+
+	REQUIRE(IsCached("a"));
+	REQUIRE(IsCached("b"));
+	REQUIRE_FALSE(IsCached(names.front()));
+}
+
+TEST_CASE_FIXTURE(CacheFixture, "ReleasedRejoinsLru") {
+	auto a = Add("a", true);
+	Add("b");
+	Add("c");
+	REQUIRE_EQ(Cache::GetStats().entries, 3);
+	REQUIRE_EQ(Cache::GetAvailableSize(), size);
+
+	// Moved back to the LRU list by the next insert as the most recently used
+	a.reset();
+	REQUIRE_EQ(Cache::GetStats().pinned, 0);
+
+	Add("d");
+	REQUIRE_EQ(Cache::GetStats().entries, 3);
+	REQUIRE_EQ(Cache::GetStats().evictions, 1);
+
+	Add("e");
+	Add("f");
+	REQUIRE_EQ(Cache::GetStats().evictions, 3);
+
+	// Now the least recently used image
+	Add("g");
+	REQUIRE_EQ(Cache::GetStats().evictions, 4);
+	REQUIRE(IsCached("f"));
+	REQUIRE(IsCached("g"));
+	REQUIRE_FALSE(IsCached("a"));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <vector>
+#include "damage_tracker.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("DamageTracker");
+
+namespace {
+
+constexpr int width = 100;
+constexpr int height = 70;
+
+DamageTracker MakeTracker() {
+	DamageTracker tracker;
+	tracker.SetSize(width, height);
+	tracker.Clear();
+	return tracker;
+}
+
+}
+
+TEST_CASE("NewSizeIsFull") {
+	DamageTracker tracker;
+	tracker.SetSize(width, height);
+	REQUIRE(tracker.IsFull());
+	REQUIRE_FALSE(tracker.IsEmpty());
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, width, height));
+
+	// Further damage changes nothing
+	tracker.Add(Rect(10, 10, 5, 5));
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, width, height));
+}
+
+TEST_CASE("Clear") {
+	auto tracker = MakeTracker();
+	REQUIRE(tracker.IsEmpty());
+	REQUIRE_FALSE(tracker.IsFull());
+	REQUIRE(tracker.GetRects().empty());
+
+	tracker.Add(Rect(10, 10, 5, 5));
+	tracker.Clear();
+	REQUIRE(tracker.IsEmpty());
+}
+
+TEST_CASE("ClipToScreen") {
+	auto tracker = MakeTracker();
+
+	tracker.Add(Rect(-10, 60, 20, 20));
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 60, 10, 10));
+
+	// Outside of the screen
+	tracker.Add(Rect(width, 0, 10, 10));
+	tracker.Add(Rect(0, 0, 0, 10));
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+}
+
+TEST_CASE("MergeOverlapping") {
+	auto tracker = MakeTracker();
+
+	tracker.Add(Rect(0, 0, 10, 10));
+	tracker.Add(Rect(50, 50, 10, 10));
+	REQUIRE_EQ(tracker.GetRects().size(), 2);
+
+	// Overlaps both rects, everything is merged
+	tracker.Add(Rect(5, 5, 50, 50));
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, 60, 60));
+
+	// Touching rects do not overlap
+	tracker.Add(Rect(60, 0, 10, 10));
+	REQUIRE_EQ(tracker.GetRects().size(), 2);
+}
+
+TEST_CASE("MaxRects") {
+	auto tracker = MakeTracker();
+
+	for (int i = 0; i < DamageTracker::max_rects; ++i) {
+		tracker.Add(Rect(i * 12, 0, 2, 2));
+	}
+	REQUIRE_EQ(tracker.GetRects().size(), DamageTracker::max_rects);
+
+	// The closest pair is merged
+	tracker.Add(Rect(0, 3, 2, 2));
+	REQUIRE_EQ(tracker.GetRects().size(), DamageTracker::max_rects);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, 2, 5));
+}
+
+TEST_CASE("LargeDamageIsFull") {
+	auto tracker = MakeTracker();
+
+	tracker.Add(Rect(0, 0, width - 10, height));
+	REQUIRE(tracker.IsFull());
+	REQUIRE_EQ(tracker.GetRects().size(), 1);
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, width, height));
+
+	tracker.Clear();
+	tracker.Add(Rect(0, 0, width / 2, height));
+	REQUIRE_FALSE(tracker.IsFull());
+}
+
+TEST_CASE("SetFull") {
+	auto tracker = MakeTracker();
+
+	tracker.Add(Rect(0, 0, 10, 10));
+	tracker.SetFull();
+	REQUIRE(tracker.IsFull());
+	REQUIRE_EQ(tracker.GetRects()[0], Rect(0, 0, width, height));
+}
+
+TEST_CASE("Union") {
+	REQUIRE_EQ(DamageTracker::Union(Rect(0, 0, 10, 10), Rect(20, 5, 10, 10)), Rect(0, 0, 30, 15));
+	REQUIRE_EQ(DamageTracker::Union(Rect(), Rect(20, 5, 10, 10)), Rect(20, 5, 10, 10));
+	REQUIRE_EQ(DamageTracker::Union(Rect(20, 5, 10, 10), Rect()), Rect(20, 5, 10, 10));
+}
+
+TEST_CASE("DrawStateHash") {
+	const auto a = DrawStateHash().Add(1).Add(Rect(1, 2, 3, 4)).Get();
+	REQUIRE_EQ(a, DrawStateHash().Add(1).Add(Rect(1, 2, 3, 4)).Get());
+	REQUIRE_NE(a, DrawStateHash().Add(1).Add(Rect(1, 2, 3, 5)).Get());
+	REQUIRE_NE(a, DrawStateHash().Add(Rect(1, 2, 3, 4)).Add(1).Get());
+}
+
+TEST_SUITE_END();
@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <iterator>
+#include <vector>
 #include "utils.h"
 #include "drawable_list.h"
 #include "drawable_mgr.h"
 #include "bitmap.h"
+#include "damage_tracker.h"
 #include "doctest.h"
 
 TEST_SUITE_BEGIN("DrawableList");
@@ -83,9 +87,12 @@ void testAppend(F&& f) {
 	REQUIRE_EQ(list.size(), 2L);
 	REQUIRE_FALSE(list.empty());
 	REQUIRE_NE(list.begin(), list.end());
-	REQUIRE_EQ(*list.begin(), &s1);
-	REQUIRE_EQ(*(list.begin() + 1), &s2);
-	REQUIRE_EQ(list.IsSorted(), false);
+	REQUIRE_EQ(*list.begin(), &s2);
+	REQUIRE_EQ(*std::next(list.begin()), &s1);
+	REQUIRE_EQ(list.IsSorted(), true);
+	REQUIRE_FALSE(list.IsDirty());
+
+	list.SetDirty();
 	REQUIRE(list.IsDirty());
 
 	f(list);
@@ -94,7 +101,7 @@ void testAppend(F&& f) {
 	REQUIRE_FALSE(list.empty());
 	REQUIRE_NE(list.begin(), list.end());
 	REQUIRE_EQ(*list.begin(), &s2);
-	REQUIRE_EQ(*(list.begin() + 1), &s1);
+	REQUIRE_EQ(*std::next(list.begin()), &s1);
 	REQUIRE_EQ(list.IsSorted(), true);
 	REQUIRE_FALSE(list.IsDirty());
 }
@@ -127,8 +134,9 @@ TEST_CASE("AppendUnSorted") {
 	REQUIRE_FALSE(list.IsDirty());
 
 	list.Append(&s2);
-	REQUIRE_EQ(list.IsSorted(), false);
-	REQUIRE(list.IsDirty());
+	REQUIRE_EQ(list.IsSorted(), true);
+	REQUIRE_FALSE(list.IsDirty());
+	REQUIRE_EQ(*list.begin(), &s2);
 
 	list.Clear();
 	REQUIRE(list.empty());
@@ -224,7 +232,7 @@ TEST_CASE("TakeSorted") {
 	REQUIRE(list.IsSorted());
 }
 
-TEST_CASE("TakeNotSorted") {
+TEST_CASE("TakeDirty") {
 	DrawableList default_list;
 	DrawableMgr::SetLocalList(&default_list);
 
@@ -236,16 +244,16 @@ TEST_CASE("TakeNotSorted") {
 
 	list.Append(&s1);
 	list.Append(&s2);
+	list.SetDirty();
 
 	REQUIRE_EQ(list.size(), 2L);
 	REQUIRE(list.IsDirty());
-	REQUIRE_FALSE(list.IsSorted());
+	REQUIRE(list.IsSorted());
 
 	REQUIRE_EQ(list.Take(&s3), nullptr);
 
 	REQUIRE_EQ(list.size(), 2L);
 	REQUIRE(list.IsDirty());
-	REQUIRE_FALSE(list.IsSorted());
 
 	REQUIRE_EQ(list.Take(&s1), &s1);
 
@@ -260,6 +268,222 @@ TEST_CASE("TakeNotSorted") {
 	REQUIRE(list.IsSorted());
 }
 
+TEST_CASE("TakeMiddle") {
+	DrawableList default_list;
+	DrawableMgr::SetLocalList(&default_list);
+
+	DrawableList list;
+
+	std::vector<std::unique_ptr<TestSprite>> sprites;
+	for (int i = 0; i < 8; ++i) {
+		sprites.push_back(std::make_unique<TestSprite>(i / 2));
+		list.Append(sprites.back().get());
+	}
+
+	REQUIRE_EQ(list.Take(sprites[3].get()), sprites[3].get());
+	REQUIRE_EQ(list.Take(sprites[3].get()), nullptr);
+	REQUIRE_EQ(list.Take(sprites[4].get()), sprites[4].get());
+	REQUIRE_EQ(list.Take(sprites[1].get()), sprites[1].get());
+
+	REQUIRE_EQ(list.size(), 5L);
+	REQUIRE_FALSE(list.IsDirty());
+	REQUIRE(list.IsSorted());
+
+	std::vector<Drawable*> expected = { sprites[0].get(), sprites[2].get(), sprites[5].get(), sprites[6].get(), sprites[7].get() };
+	REQUIRE_EQ(std::vector<Drawable*>(list.begin(), list.end()), expected);
+
+	for (auto& s: sprites) {
+		REQUIRE_EQ(list.Contains(s.get()), std::find(expected.begin(), expected.end(), s.get()) != expected.end());
+	}
+
+	list.Append(sprites[3].get());
+	expected.insert(expected.begin() + 2, sprites[3].get());
+	REQUIRE_EQ(std::vector<Drawable*>(list.begin(), list.end()), expected);
+}
+
+TEST_CASE("UpdateZ") {
+	DrawableList list;
+	DrawableMgr::SetLocalList(&list);
+	list.Sort();
+
+	TestSprite s1(1);
+	TestSprite s2(1);
+	TestSprite s3(2);
+	TestSprite s4(Priority_Window);
+
+	list.Append(&s1);
+	list.Append(&s2);
+	list.Append(&s3);
+	list.Append(&s4);
+
+	auto order = [&]() {
+		return std::vector<Drawable*>(list.begin(), list.end());
+	};
+
+	// Same result as a stable sort: In front of equal z when moving up
+	s1.SetZ(2);
+	REQUIRE_EQ(order(), std::vector<Drawable*>{ &s2, &s1, &s3, &s4 });
+
+	// and behind equal z when moving down
+	s3.SetZ(1);
+	REQUIRE_EQ(order(), std::vector<Drawable*>{ &s2, &s3, &s1, &s4 });
+
+	// Other priority layers
+	s2.SetZ(Priority_Window + 1);
+	REQUIRE_EQ(order(), std::vector<Drawable*>{ &s3, &s1, &s4, &s2 });
+
+	s4.SetZ(0);
+	REQUIRE_EQ(order(), std::vector<Drawable*>{ &s4, &s3, &s1, &s2 });
+
+	REQUIRE_FALSE(list.IsDirty());
+	REQUIRE(list.IsSorted());
+}
+
+TEST_CASE("DrawRange") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	Bitmap bitmap(16, 16, false);
+
+	DrawableList default_list;
+	DrawableMgr::SetLocalList(&default_list);
+
+	std::vector<Drawable*> drawn;
+
+	class DrawSprite : public Drawable {
+		public:
+			DrawSprite(Drawable::Z_t z, std::vector<Drawable*>& drawn) : Drawable(z, Drawable::Flags::Global), drawn(drawn) {}
+			void Draw(Bitmap&) override { drawn.push_back(this); }
+			std::vector<Drawable*>& drawn;
+	};
+
+	DrawSprite s1(Priority_Background, drawn);
+	DrawSprite s2(Priority_Player, drawn);
+	DrawSprite s3(Priority_Player + 1, drawn);
+	DrawSprite s4(Priority_Window, drawn);
+
+	DrawableList list;
+	list.Append(&s4);
+	list.Append(&s3);
+	list.Append(&s2);
+	list.Append(&s1);
+
+	list.Draw(bitmap);
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s1, &s2, &s3, &s4 });
+
+	drawn.clear();
+	list.Draw(bitmap, Priority_Player + 1, Priority_Window);
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s3, &s4 });
+
+	drawn.clear();
+	list.Draw(bitmap, Priority_Background + 1, Priority_Player);
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s2 });
+}
+
+TEST_CASE("DrawDamage") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	Bitmap bitmap(64, 64, false);
+
+	DrawableList default_list;
+	DrawableMgr::SetLocalList(&default_list);
+
+	std::vector<Drawable*> drawn;
+	std::vector<Rect> backgrounds;
+
+	class DamageSprite : public Drawable {
+		public:
+			DamageSprite(Drawable::Z_t z, Rect rect, std::vector<Drawable*>& drawn) : Drawable(z, Drawable::Flags::Global), rect(rect), drawn(drawn) {}
+			void Draw(Bitmap&) override { drawn.push_back(this); }
+			bool TracksDamage() const override { return tracked; }
+			uint64_t GetDrawState(Rect& bounds) override {
+				bounds = rect;
+				return state;
+			}
+			Rect rect;
+			uint64_t state = 0;
+			bool tracked = true;
+			std::vector<Drawable*>& drawn;
+	};
+
+	DamageSprite s1(Priority_Background, Rect(0, 0, 16, 16), drawn);
+	DamageSprite s2(Priority_Player, Rect(8, 8, 16, 16), drawn);
+	DamageSprite s3(Priority_Window, Rect(40, 40, 8, 8), drawn);
+
+	DrawableList list;
+	list.Append(&s1);
+	list.Append(&s2);
+	list.Append(&s3);
+
+	DamageTracker damage;
+	damage.SetSize(bitmap.width(), bitmap.height());
+
+	auto draw = [&]() {
+		drawn.clear();
+		backgrounds.clear();
+		list.DrawDamage(bitmap, std::numeric_limits<Drawable::Z_t>::min(), std::numeric_limits<Drawable::Z_t>::max(), damage,
+			[&](Bitmap& dst) { backgrounds.push_back(dst.GetClipRect()); });
+	};
+
+	// The first frame is drawn completely
+	draw();
+	REQUIRE(damage.IsFull());
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s1, &s2, &s3 });
+	REQUIRE_EQ(backgrounds, std::vector<Rect>{ bitmap.GetRect() });
+
+	// Nothing changed
+	damage.Clear();
+	draw();
+	REQUIRE(damage.IsEmpty());
+	REQUIRE(drawn.empty());
+	REQUIRE(backgrounds.empty());
+
+	// Only the changed drawable and the drawables it overlaps are redrawn
+	damage.Clear();
+	s1.state = 1;
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(0, 0, 16, 16) });
+	REQUIRE_EQ(backgrounds, std::vector<Rect>{ Rect(0, 0, 16, 16) });
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s1, &s2 });
+
+	// Moving damages the old and the new area
+	damage.Clear();
+	s3.rect = Rect(44, 40, 8, 8);
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(40, 40, 12, 8) });
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s3 });
+
+	// Hiding and removing damage the area the drawable covered
+	damage.Clear();
+	s3.SetVisible(false);
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(44, 40, 8, 8) });
+	REQUIRE(drawn.empty());
+
+	damage.Clear();
+	list.Take(&s2);
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(8, 8, 16, 16) });
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s1 });
+
+	// A z change damages the area of the drawable
+	damage.Clear();
+	list.Append(&s2);
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(8, 8, 16, 16) });
+
+	damage.Clear();
+	s2.SetZ(Priority_Background - 1);
+	list.UpdateZ(&s2);
+	draw();
+	REQUIRE_EQ(damage.GetRects(), std::vector<Rect>{ Rect(8, 8, 16, 16) });
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s2, &s1 });
+
+	// Drawables that do not track their damage redraw everything
+	damage.Clear();
+	s1.tracked = false;
+	draw();
+	REQUIRE(damage.IsFull());
+	REQUIRE_EQ(drawn, std::vector<Drawable*>{ &s2, &s1 });
+}
+
 TEST_CASE("TakeFromAll") {
 	DrawableList default_list;
 	DrawableMgr::SetLocalList(&default_list);
@@ -0,0 +1,65 @@
+#include "glyph_atlas.h"
+#include "bitmap.h"
+#include "pixel_format.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("GlyphAtlas");
+
+static Font::GlyphRet MakeGlyph(int width, int height, Color color) {
+	auto bm = Bitmap::Create(width, height, color);
+	return { bm, { width, 0 }, { 1, 2 }, false, bm->GetRect() };
+}
+
+TEST_CASE("InsertFind") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	GlyphAtlas atlas;
+
+	REQUIRE(atlas.Find(65, 12) == nullptr);
+
+	auto gret = atlas.Insert(65, 12, MakeGlyph(6, 12, Color(255, 0, 0, 255)));
+	REQUIRE_EQ(gret.rect.width, 6);
+	REQUIRE_EQ(gret.rect.height, 12);
+	REQUIRE_EQ(gret.advance, Point(6, 0));
+	REQUIRE_EQ(gret.offset, Point(1, 2));
+	REQUIRE_EQ(gret.bitmap->GetColorAt(gret.rect.x + 3, gret.rect.y + 5), Color(255, 0, 0, 255));
+
+	auto* found = atlas.Find(65, 12);
+	REQUIRE(found != nullptr);
+	REQUIRE_EQ(found->rect, gret.rect);
+
+	// Same glyph at a different size is a different entry
+	REQUIRE(atlas.Find(65, 16) == nullptr);
+	REQUIRE_EQ(atlas.GetNumGlyphs(), 1);
+}
+
+TEST_CASE("TooLarge") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	GlyphAtlas atlas;
+
+	auto glyph = MakeGlyph(GlyphAtlas::max_glyph_size + 1, 8, Color(0, 255, 0, 255));
+	auto gret = atlas.Insert(1, 80, glyph);
+	REQUIRE_EQ(gret.bitmap, glyph.bitmap);
+	REQUIRE(atlas.Find(1, 80) == nullptr);
+}
+
+TEST_CASE("EvictsLeastRecentlyUsed") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	GlyphAtlas atlas;
+	constexpr int slots = GlyphAtlas::slots_per_row * GlyphAtlas::slots_per_row;
+
+	for (int i = 0; i < slots; ++i) {
+		atlas.Insert(i, 12, MakeGlyph(8, 8, Color(i, 0, 0, 255)));
+	}
+	REQUIRE_EQ(atlas.GetNumGlyphs(), slots);
+
+	// Glyph 0 is used again, glyph 1 is evicted instead
+	REQUIRE(atlas.Find(0, 12) != nullptr);
+	auto gret = atlas.Insert(slots, 12, MakeGlyph(8, 8, Color(1, 2, 3, 255)));
+
+	REQUIRE_EQ(atlas.GetNumGlyphs(), slots);
+	REQUIRE(atlas.Find(0, 12) != nullptr);
+	REQUIRE(atlas.Find(1, 12) == nullptr);
+	REQUIRE_EQ(gret.bitmap->GetColorAt(gret.rect.x, gret.rect.y), Color(1, 2, 3, 255));
+}
+
+TEST_SUITE_END();
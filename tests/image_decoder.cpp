@@ -0,0 +1,52 @@
+#include <vector>
+#include "bitmap.h"
+#include "filefinder.h"
+#include "image_decoder.h"
+#include "test_bitmap.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("ImageDecoder");
+
+namespace {
+	FilesystemView GetAssets() {
+		return FileFinder::Root().Subtree(EP_TEST_PATH);
+	}
+}
+
+TEST_CASE("MatchesBitmapCreate") {
+	auto fs = GetAssets();
+
+	auto expected = Bitmap::Create(fs.OpenInputStream("game/Charset/chara1.png"), true);
+	REQUIRE(expected);
+
+	std::vector<ImageDecoder::Source> sources;
+	for (int i = 0; i < 9; ++i) {
+		sources.push_back({ fs.OpenInputStream("game/Charset/chara1.png"), true, 0 });
+	}
+
+	auto bitmaps = ImageDecoder::Decode(std::move(sources));
+	REQUIRE_EQ(bitmaps.size(), 9);
+
+	for (auto& bitmap: bitmaps) {
+		REQUIRE(bitmap);
+		CHECK(SamePixels(*bitmap, *expected));
+	}
+}
+
+TEST_CASE("Failures") {
+	auto fs = GetAssets();
+
+	std::vector<ImageDecoder::Source> sources;
+	sources.push_back({ fs.OpenInputStream("platform/1kb"), true, 0 });
+	sources.push_back({ fs.OpenInputStream("game/Charset/chara1.png"), true, 0 });
+
+	auto bitmaps = ImageDecoder::Decode(std::move(sources));
+	REQUIRE_EQ(bitmaps.size(), 2);
+	CHECK(!bitmaps[0]);
+	CHECK(bitmaps[1]);
+
+	CHECK(ImageDecoder::Decode({}).empty());
+	CHECK(ImageDecoder::GetNumThreads() >= 1);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+#include "bitmap.h"
+#include "filefinder.h"
+#include "image_disk_cache.h"
+#include "platform.h"
+#include "test_bitmap.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("ImageDiskCache");
+
+namespace {
+	Filesystem_Stream::InputStream OpenCharset() {
+		return FileFinder::Root().Subtree(EP_TEST_PATH).OpenInputStream("game/Charset/chara1.png");
+	}
+
+	/** Unique folder in the temporary directory, removed with its files at the end of the test */
+	struct TempDir {
+		std::string path;
+
+		TempDir() {
+#ifndef _WIN32
+			const char* tmp = std::getenv("TMPDIR");
+			std::string name = std::string(tmp && *tmp ? tmp : "/tmp") + "/easyrpg_image_disk_cache_XXXXXX";
+			if (mkdtemp(&name[0])) {
+				path = std::move(name);
+			}
+#endif
+		}
+
+		~TempDir() {
+			if (path.empty()) {
+				return;
+			}
+			{
+				Platform::Directory dir(path);
+				while (dir && dir.Read()) {
+					const auto name = dir.GetEntryName();
+					if (name != "." && name != "..") {
+						std::remove((path + "/" + name).c_str());
+					}
+				}
+			}
+			std::remove(path.c_str());
+		}
+
+		int CountFiles() const {
+			int count = 0;
+			Platform::Directory dir(path);
+			while (dir && dir.Read()) {
+				const auto name = dir.GetEntryName();
+				if (name != "." && name != "..") {
+					++count;
+				}
+			}
+			return count;
+		}
+	};
+}
+
+TEST_CASE("Disabled") {
+	ImageDiskCache::SetPath("");
+	CHECK(!ImageDiskCache::IsEnabled());
+
+	auto stats = ImageDiskCache::GetStats();
+	CHECK(ImageDiskCache::Create(OpenCharset(), true, 0));
+	CHECK_EQ(ImageDiskCache::GetStats().misses, stats.misses);
+}
+
+TEST_CASE("StoreAndLoad") {
+	if (!ImageDiskCache::IsSupported()) {
+		return;
+	}
+
+	TempDir dir;
+	REQUIRE(!dir.path.empty());
+	ImageDiskCache::SetPath(dir.path);
+	REQUIRE(ImageDiskCache::IsEnabled());
+
+	const uint32_t flags = Bitmap::Flag_Chipset | Bitmap::Flag_ReadOnly;
+	auto expected = Bitmap::Create(OpenCharset(), true, flags);
+	REQUIRE(expected);
+
+	auto stats = ImageDiskCache::GetStats();
+	auto first = ImageDiskCache::Create(OpenCharset(), true, flags);
+	REQUIRE(first);
+	CHECK_EQ(ImageDiskCache::GetStats().misses, stats.misses + 1);
+	CHECK_EQ(ImageDiskCache::GetStats().stored, stats.stored + 1);
+	CHECK_EQ(dir.CountFiles(), 1);
+
+	stats = ImageDiskCache::GetStats();
+	auto second = ImageDiskCache::Create(OpenCharset(), true, flags);
+	REQUIRE(second);
+	CHECK_EQ(ImageDiskCache::GetStats().hits, stats.hits + 1);
+	CHECK_EQ(ImageDiskCache::GetStats().misses, stats.misses);
+
+	for (auto* bmp: { first.get(), second.get() }) {
+		CHECK(SamePixels(*bmp, *expected));
+
+		auto info = bmp->GetDecodedInfo();
+		auto expected_info = expected->GetDecodedInfo();
+		CHECK_EQ(info.original_bpp, expected_info.original_bpp);
+		CHECK_EQ(info.read_only, expected_info.read_only);
+		CHECK(info.image_opacity == expected_info.image_opacity);
+		CHECK(info.tile_opacity == expected_info.tile_opacity);
+	}
+
+	ImageDiskCache::SetPath("");
+}
+
+TEST_CASE("SizeLimit") {
+	if (!ImageDiskCache::IsSupported()) {
+		return;
+	}
+
+	TempDir dir;
+	REQUIRE(!dir.path.empty());
+	ImageDiskCache::SetPath(dir.path);
+	REQUIRE(ImageDiskCache::IsEnabled());
+
+	// Every image exceeds the limit, only the last stored one is kept
+	ImageDiskCache::SetSizeLimit(1);
+
+	auto stats = ImageDiskCache::GetStats();
+	REQUIRE(ImageDiskCache::Create(OpenCharset(), true, 0));
+	CHECK_EQ(dir.CountFiles(), 1);
+	CHECK_EQ(ImageDiskCache::GetStats().removed, stats.removed);
+
+	REQUIRE(ImageDiskCache::Create(OpenCharset(), false, 0));
+	CHECK_EQ(dir.CountFiles(), 1);
+	CHECK_EQ(ImageDiskCache::GetStats().removed, stats.removed + 1);
+
+	// The removed image is decoded again
+	stats = ImageDiskCache::GetStats();
+	REQUIRE(ImageDiskCache::Create(OpenCharset(), true, 0));
+	CHECK_EQ(ImageDiskCache::GetStats().misses, stats.misses + 1);
+	CHECK_EQ(dir.CountFiles(), 1);
+
+	ImageDiskCache::SetSizeLimit(ImageDiskCache::default_size_limit);
+	ImageDiskCache::SetPath("");
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+#include "lru_cache.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("LruCache");
+
+TEST_CASE("FindInsert") {
+	LruCache<int, std::string> cache(4);
+
+	REQUIRE(cache.Find(1) == nullptr);
+
+	cache.Insert(1, "one");
+	cache.Insert(2, "two");
+	REQUIRE_EQ(cache.GetSize(), 2);
+	REQUIRE_EQ(*cache.Find(1), "one");
+	REQUIRE_EQ(*cache.Find(2), "two");
+
+	cache.Insert(1, "uno");
+	REQUIRE_EQ(cache.GetSize(), 2);
+	REQUIRE_EQ(*cache.Find(1), "uno");
+}
+
+TEST_CASE("EvictsLeastRecentlyUsed") {
+	LruCache<int, int> cache(3);
+
+	cache.Insert(1, 10);
+	cache.Insert(2, 20);
+	cache.Insert(3, 30);
+	REQUIRE(cache.IsFull());
+
+	// 1 becomes the most recently used, 2 is evicted next
+	REQUIRE(cache.Find(1) != nullptr);
+	REQUIRE_EQ(cache.Oldest().first, 2);
+
+	cache.Insert(4, 40);
+	REQUIRE_EQ(cache.GetSize(), 3);
+	REQUIRE(cache.Find(2) == nullptr);
+	REQUIRE(cache.Find(1) != nullptr);
+	REQUIRE(cache.Find(3) != nullptr);
+	REQUIRE(cache.Find(4) != nullptr);
+}
+
+TEST_CASE("EraseClear") {
+	LruCache<int, int> cache(3);
+
+	cache.Insert(1, 10);
+	cache.Insert(2, 20);
+	REQUIRE(cache.Erase(1));
+	REQUIRE_FALSE(cache.Erase(1));
+	REQUIRE_EQ(cache.GetSize(), 1);
+
+	cache.PopOldest();
+	REQUIRE_EQ(cache.GetSize(), 0);
+
+	cache.Insert(3, 30);
+	cache.Clear();
+	REQUIRE_EQ(cache.GetSize(), 0);
+	REQUIRE(cache.Find(3) == nullptr);
+}
+
+TEST_CASE("Iterate") {
+	LruCache<int, int> cache(3);
+
+	cache.Insert(1, 10);
+	cache.Insert(2, 20);
+	cache.Insert(3, 30);
+	cache.Find(1);
+
+	// Most recently used first
+	std::vector<int> keys;
+	for (auto& entry: cache) {
+		keys.push_back(entry.first);
+	}
+	REQUIRE_EQ(keys, std::vector<int>{ 1, 3, 2 });
+}
+
+TEST_SUITE_END();
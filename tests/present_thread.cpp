@@ -0,0 +1,59 @@
+#include <atomic>
+#include <vector>
+#include "present_thread.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("PresentThread");
+
+TEST_CASE("RunsInOrder") {
+	std::vector<int> order;
+	PresentThread present;
+
+	for (int i = 0; i < 50; ++i) {
+		present.Submit([&order, i]() {
+			order.push_back(i);
+		});
+	}
+	present.Wait();
+
+	REQUIRE_EQ(order.size(), 50);
+	for (int i = 0; i < 50; ++i) {
+		REQUIRE_EQ(order[i], i);
+	}
+}
+
+TEST_CASE("StopAndRestart") {
+	std::atomic<int> exits(0);
+	std::atomic<int> calls(0);
+	PresentThread present([&]() { ++exits; });
+
+	present.Submit([&]() { ++calls; });
+	present.Stop();
+	REQUIRE_FALSE(present.IsRunning());
+	REQUIRE_EQ(calls.load(), 1);
+
+	present.Submit([&]() { ++calls; });
+	present.Submit([&]() { ++calls; });
+	present.Stop();
+	REQUIRE_EQ(calls.load(), 3);
+
+#ifdef HAVE_THREADS
+	REQUIRE_EQ(exits.load(), 2);
+#endif
+}
+
+TEST_CASE("StopFromThread") {
+	PresentThread present;
+	bool done = false;
+
+	present.Submit([&]() {
+		present.Stop();
+		present.Wait();
+		done = true;
+	});
+	present.Stop();
+
+	REQUIRE(done);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,23 @@
+#ifndef EP_TEST_BITMAP_H
+#define EP_TEST_BITMAP_H
+
+#include <cstdint>
+#include <cstring>
+#include "bitmap.h"
+
+/** Compares size and pixels of two bitmaps, bytes past the width of a row are ignored */
+inline bool SamePixels(const Bitmap& a, const Bitmap& b) {
+	if (a.width() != b.width() || a.height() != b.height()) {
+		return false;
+	}
+	for (int y = 0; y < a.height(); ++y) {
+		auto* row_a = static_cast<const uint8_t*>(a.pixels()) + y * a.pitch();
+		auto* row_b = static_cast<const uint8_t*>(b.pixels()) + y * b.pitch();
+		if (std::memcmp(row_a, row_b, a.width() * a.bpp()) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#endif
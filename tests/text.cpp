@@ -3,6 +3,7 @@
 #include "cache.h"
 #include "bitmap.h"
 #include "font.h"
+#include "test_bitmap.h"
 #include <iostream>
 #include "doctest.h"
 
@@ -15,6 +16,37 @@ constexpr int ch = 12;
 constexpr int cwh = 6;
 constexpr int cwf = 12;
 
+namespace {
+	// Uses the glyphs of the default font and shapes every character on its own
+	class ShapingFont : public Font {
+	public:
+		ShapingFont() : Font("ShapingFont", ch, false, false), base(Font::Default()) {}
+
+		Rect vGetSize(char32_t glyph) const override {
+			return base->vGetSize(glyph);
+		}
+
+		GlyphRet vRender(char32_t glyph) const override {
+			return base->vRender(glyph);
+		}
+
+		bool vCanShape() const override {
+			return true;
+		}
+
+		std::vector<ShapeRet> vShape(U32StringView text) const override {
+			std::vector<ShapeRet> shapes;
+			for (auto glyph: text) {
+				shapes.push_back({ glyph, { vGetSize(glyph).width, 0 }, { 0, 0 }, false });
+			}
+			return shapes;
+		}
+
+	private:
+		FontRef base;
+	};
+}
+
 TEST_CASE("TextDrawSystemStrReturn") {
 	Bitmap::SetFormat(format_R8G8B8A8_a().format());
 	auto font = Font::Default();
@@ -31,6 +63,49 @@ TEST_CASE("TextDrawSystemStrReturn") {
 	REQUIRE_EQ(draw(3, 17, "$A $B"), Point(cwf * 2 + cwh, ch));
 }
 
+TEST_CASE("TextDrawSystemStrCached") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	auto font = Font::Default();
+	auto system = Cache::SysBlack();
+	auto first = Bitmap::Create(width, height);
+	auto second = Bitmap::Create(width, height);
+
+	// The second draw uses the cached layout and must give the same result
+	for (auto* text: { "abc", "$A $B", "x\\y\n" }) {
+		first->Clear();
+		second->Clear();
+		auto size = Text::GetSize(*font, text);
+		auto ret1 = Text::Draw(*first, 20, 10, *font, *system, 1, text, Text::AlignCenter);
+		auto ret2 = Text::Draw(*second, 20, 10, *font, *system, 1, text, Text::AlignCenter);
+
+		REQUIRE_EQ(ret1, ret2);
+		REQUIRE_EQ(Text::GetSize(*font, text), size);
+		REQUIRE(SamePixels(*first, *second));
+	}
+}
+
+TEST_CASE("TextDrawShapedControlCharacter") {
+	Bitmap::SetFormat(format_R8G8B8A8_a().format());
+	ShapingFont font;
+	REQUIRE(font.CanShape());
+	auto system = Cache::SysBlack();
+	auto first = Bitmap::Create(width, height);
+	auto second = Bitmap::Create(width, height);
+
+	// Control characters are drawn and measured like any other character
+	for (auto* text: { "a\x01" "bc", "\x1f" "abc", "ab$A\x7f" "c" }) {
+		first->Clear();
+		second->Clear();
+		auto size = Text::GetSize(font, text);
+		auto ret1 = Text::Draw(*first, 0, 0, font, *system, 0, text);
+		auto ret2 = Text::Draw(*second, 0, 0, font, *system, 0, text);
+
+		REQUIRE_EQ(ret1.x, size.width);
+		REQUIRE_EQ(ret1, ret2);
+		REQUIRE(SamePixels(*first, *second));
+	}
+}
+
 TEST_CASE("TextDrawColorStrReturn") {
 	Bitmap::SetFormat(format_R8G8B8A8_a().format());
 	auto font = Font::Default();
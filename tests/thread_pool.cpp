@@ -0,0 +1,48 @@
+#include <atomic>
+#include <vector>
+#include "thread_pool.h"
+#include "doctest.h"
+
+TEST_SUITE_BEGIN("ThreadPool");
+
+TEST_CASE("RunsEveryIndexOnce") {
+	ThreadPool pool(4);
+
+	for (int count: { 0, 1, 3, 4, 17, 100 }) {
+		std::vector<std::atomic<int>> calls(count);
+		pool.ParallelFor(count, [&](int i) {
+			++calls[i];
+		});
+
+		for (auto& c: calls) {
+			REQUIRE_EQ(c.load(), 1);
+		}
+	}
+}
+
+TEST_CASE("Reuse") {
+	ThreadPool pool(3);
+	std::atomic<int> sum(0);
+
+	for (int i = 0; i < 200; ++i) {
+		pool.ParallelFor(8, [&](int j) {
+			sum += j;
+		});
+	}
+
+	REQUIRE_EQ(sum.load(), 200 * 28);
+}
+
+TEST_CASE("SingleThread") {
+	ThreadPool pool(1);
+	REQUIRE_EQ(pool.GetNumThreads(), 1);
+
+	std::vector<int> order;
+	pool.ParallelFor(5, [&](int i) {
+		order.push_back(i);
+	});
+
+	REQUIRE_EQ(order, std::vector<int>{ 0, 1, 2, 3, 4 });
+}
+
+TEST_SUITE_END();